@@ -0,0 +1,246 @@
+// command line tool that writes the binary cache of an obj mesh ahead of time
+// and compares parsing the obj (on one thread and on every core) against loading the cache
+//
+// usage: MeshConverter <mesh.obj> [-format full|compact|compactnocolor] [-benchmark runs] [-generate megabytes]
+// -generate first writes a synthetic grid of about that size to <mesh.obj>, for measuring parse throughput
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "OBJImporter.h"
+#include "MeshCache.h"
+
+// read every vertex / index byte, like glBufferData would, so lazily mapped pages are counted too
+static unsigned int consume(const MeshData& data)
+{
+	const VertexLayout& layout = VertexLayout::get(data.format);
+
+	unsigned int sum = 0;
+	for (const MeshChunkData& chunk : data.chunks)
+	{
+		const unsigned char* vertices = chunk.vertices;
+		size_t vertexBytes = (size_t)chunk.vertexCount * layout.getStride();
+		for (size_t i = 0; i < vertexBytes; i += 64)
+		{
+			sum += vertices[i];
+		}
+
+		for (unsigned int i = 0; i < chunk.indexCount; i += 16)
+		{
+			sum += chunk.indices[i];
+		}
+	}
+
+	return sum;
+}
+
+// write a bumpy grid of textured quads split into a few objects, about the requested size
+static bool generateOBJ(const std::string& path, int megabytes)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	// roughly 175 bytes of text per grid vertex (v, vt, vn and a share of a face)
+	int side = (int)std::sqrt((double)megabytes * 1024 * 1024 / 175.0);
+	if (side < 2)
+	{
+		side = 2;
+	}
+
+	std::string text;
+	char line[160];
+
+	auto write = [&](int length)
+	{
+		text.append(line, length);
+		if (text.size() > (1 << 20))
+		{
+			file.write(text.data(), text.size());
+			text.clear();
+		}
+	};
+
+	write(snprintf(line, sizeof(line), "# synthetic %dx%d grid\n", side, side));
+
+	for (int y = 0; y < side; y++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			float u = (float)x / (side - 1);
+			float v = (float)y / (side - 1);
+			float height = 0.05f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+
+			write(snprintf(line, sizeof(line), "v %f %f %f\n", u * 100.0f - 50.0f, height, v * 100.0f - 50.0f));
+			write(snprintf(line, sizeof(line), "vt %f %f\n", u, v));
+			write(snprintf(line, sizeof(line), "vn %f %f %f\n", -height, 1.0f, height));
+		}
+	}
+
+	const int objectCount = 8;
+	int rowsPerObject = (side - 1 + objectCount - 1) / objectCount;
+
+	for (int y = 0; y < side - 1; y++)
+	{
+		if (y % rowsPerObject == 0)
+		{
+			write(snprintf(line, sizeof(line), "o patch%d\n", y / rowsPerObject));
+		}
+
+		for (int x = 0; x < side - 1; x++)
+		{
+			int a = y * side + x + 1;
+			int b = a + 1;
+			int c = a + side + 1;
+			int d = a + side;
+			write(snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d));
+		}
+	}
+
+	file.write(text.data(), text.size());
+	return file.good();
+}
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: MeshConverter <mesh.obj> [-format full|compact|compactnocolor] [-benchmark runs]\n");
+		return 1;
+	}
+
+	std::string source = argv[1];
+	VertexFormat format = VertexFormat::Full;
+	int benchmarkRuns = 0;
+	int generateMegabytes = 0;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-format") == 0 && i + 1 < argc)
+		{
+			const char* name = argv[++i];
+			if (strcmp(name, "compact") == 0)
+				format = VertexFormat::Compact;
+			else if (strcmp(name, "compactnocolor") == 0)
+				format = VertexFormat::CompactNoColor;
+			else
+				format = VertexFormat::Full;
+		}
+		else if (strcmp(argv[i], "-benchmark") == 0 && i + 1 < argc)
+		{
+			benchmarkRuns = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-generate") == 0 && i + 1 < argc)
+		{
+			generateMegabytes = atoi(argv[++i]);
+		}
+	}
+
+	if (generateMegabytes > 0 && !generateOBJ(source, generateMegabytes))
+	{
+		printf("Failed to write %s\n", source.c_str());
+		return 1;
+	}
+
+	// convert
+	unsigned long long sourceHash = MeshCache::hashSource(source);
+	if (sourceHash == 0)
+	{
+		printf("Can't read %s\n", source.c_str());
+		return 1;
+	}
+
+	MeshData data;
+	if (!OBJImporter::import(source, format, data))
+	{
+		return 1;
+	}
+
+	std::string cachePath = MeshCache::getCachePath(source);
+	if (!MeshCache::save(cachePath, sourceHash, data))
+	{
+		printf("Failed to write %s\n", cachePath.c_str());
+		return 1;
+	}
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	for (const MeshChunkData& chunk : data.chunks)
+	{
+		vertexCount += chunk.vertexCount;
+		indexCount += chunk.indexCount;
+	}
+
+	printf("%s -> %s\n", source.c_str(), cachePath.c_str());
+	printf("%zu chunks, %zu materials, %zu vertices (%u bytes each), %zu indices\n", data.chunks.size(),
+		data.materials.size(), vertexCount, VertexLayout::get(format).getStride(), indexCount);
+
+	if (benchmarkRuns <= 0)
+	{
+		return 0;
+	}
+
+	MappedFile sourceFile;
+	sourceFile.open(source);
+	double megabytes = sourceFile.size() / (1024.0 * 1024.0);
+	sourceFile.close();
+
+	// cold path: parse the obj, build the vertices and tangents, first on this thread alone then on the default pool
+	unsigned int checksum = 0;
+	double serialTime = 0.0;
+	{
+		ThreadPool serial(0);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int run = 0; run < benchmarkRuns; run++)
+		{
+			MeshData parsed;
+			OBJImporter::import(source, format, parsed, serial);
+			checksum += consume(parsed);
+		}
+		serialTime = millisecondsSince(start) / benchmarkRuns;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int run = 0; run < benchmarkRuns; run++)
+	{
+		MeshData parsed;
+		OBJImporter::import(source, format, parsed);
+		checksum += consume(parsed);
+	}
+	double parseTime = millisecondsSince(start) / benchmarkRuns;
+
+	unsigned int threadCount = ThreadPool::getDefault().getWorkerCount() + 1;
+	printf("obj parse: %.3f ms (%.1f MB/s) on 1 thread, %.3f ms (%.1f MB/s) on %u threads, %.2fx\n",
+		serialTime, megabytes / (serialTime / 1000.0), parseTime, megabytes / (parseTime / 1000.0), threadCount, serialTime / parseTime);
+
+	// cached path: hash the source to validate the cache, then map it
+	start = std::chrono::high_resolution_clock::now();
+	for (int run = 0; run < benchmarkRuns; run++)
+	{
+		MeshData cached;
+		if (!MeshCache::load(cachePath, MeshCache::hashSource(source), format, cached))
+		{
+			printf("Failed to load %s\n", cachePath.c_str());
+			return 1;
+		}
+		checksum += consume(cached);
+	}
+	double cacheTime = millisecondsSince(start) / benchmarkRuns;
+
+	printf("obj parse: %.3f ms, cache load: %.3f ms (%.1fx faster) over %d runs [%u]\n",
+		parseTime, cacheTime, parseTime / cacheTime, benchmarkRuns, checksum);
+
+	return 0;
+}
@@ -22,9 +22,7 @@ struct Material
 };
 uniform Material material;
 
-uniform float time;
-
-uniform vec3 cameraPosition;
+#include "include/frameConstants.glsl"
 
 out vec4 FragDiffuse;
 out vec4 FragSpecular;
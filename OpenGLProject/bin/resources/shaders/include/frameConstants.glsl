@@ -0,0 +1,13 @@
+// per frame constants shared by every shader (see FrameConstants.h)
+layout(std140, binding = 0) uniform FrameConstants
+{
+	mat4 view;
+	mat4 projection;
+	mat4 projectionView;
+	vec4 cameraPosition;
+	float time;
+	bool correctGamma;
+	int directionalLightCount;
+	int pointLightCount;
+	int spotLightCount;
+};
\ No newline at end of file
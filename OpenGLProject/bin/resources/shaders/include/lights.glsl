@@ -0,0 +1,44 @@
+// directional light(s)
+struct DirectionalLight
+{
+	vec4 direction;
+
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+layout(std430, binding = 0) readonly buffer DirectionalLightBuffer
+{
+	DirectionalLight directionalLights[];
+};
+
+// point light(s)
+struct PointLight
+{
+	vec4 position; // w = falloff distance
+
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+};
+layout(std430, binding = 1) readonly buffer PointLightBuffer
+{
+	PointLight pointLights[];
+};
+
+// spot light(s)
+struct SpotLight
+{
+	vec4 position; // w = falloff distance
+	vec4 direction;
+
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+
+	vec4 cosAngles; // x = cos(inner angle), y = cos(outer angle)
+};
+layout(std430, binding = 2) readonly buffer SpotLightBuffer
+{
+	SpotLight spotLights[];
+};
\ No newline at end of file
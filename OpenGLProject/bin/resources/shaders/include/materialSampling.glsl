@@ -0,0 +1,67 @@
+// the material of a multi draw and how its textures are sampled, with or without bindless textures
+#include "materialTable.glsl"
+
+// material of this draw, read at the start of main
+Material material;
+
+// material texture slots (see Material.h)
+const uint diffuseMap = 0;
+const uint alphaMap = 1;
+const uint ambientMap = 2;
+const uint specularMap = 3;
+const uint specularHighlightMap = 4;
+const uint normalMap = 5;
+const uint displacementMap = 6;
+const uint emissiveMap = 7;
+
+// material feature bits (see MaterialFeature in Material.h), a multi draw mixes materials so these are branched on
+const uint featureNormalMap = 1u;
+const uint featureEmissive = 2u;
+const uint featureAlphaTest = 4u;
+
+#ifdef GL_ARB_bindless_texture
+
+// sample a texture of this draw's material, the reference is a resident bindless handle
+vec4 sampleMaterial(uint slot, vec2 uv)
+{
+	return texture(sampler2D(material.textures[slot]), uv);
+}
+
+#else
+
+// without bindless textures every material texture is a layer of one of these (see MaterialTextureTable)
+layout(binding = 8) uniform sampler2DArray materialArrays[8];
+
+// streamed textures only fill their layer from the finest resident level down, so never sample above it
+vec4 sampleLayer(sampler2DArray textureArray, vec3 coords, float firstLevel)
+{
+	float lod = max(textureQueryLod(textureArray, coords.xy).y, firstLevel);
+	return textureLod(textureArray, coords, lod);
+}
+
+// sample a texture of this draw's material, the reference is an array index and the layer (low 16 bits)
+// with the finest level it holds above it
+vec4 sampleMaterial(uint slot, vec2 uv)
+{
+	uvec2 reference = material.textures[slot];
+	vec3 coords = vec3(uv, float(reference.y & 0xFFFFu));
+	float firstLevel = float(reference.y >> 16);
+
+	// sampler arrays need constant indices here, the index isn't uniform across a multi draw
+	switch(reference.x)
+	{
+	case 0: return sampleLayer(materialArrays[0], coords, firstLevel);
+	case 1: return sampleLayer(materialArrays[1], coords, firstLevel);
+	case 2: return sampleLayer(materialArrays[2], coords, firstLevel);
+	case 3: return sampleLayer(materialArrays[3], coords, firstLevel);
+	case 4: return sampleLayer(materialArrays[4], coords, firstLevel);
+	case 5: return sampleLayer(materialArrays[5], coords, firstLevel);
+	case 6: return sampleLayer(materialArrays[6], coords, firstLevel);
+	case 7: return sampleLayer(materialArrays[7], coords, firstLevel);
+	}
+
+	// textures that didn't fit in any array
+	return vec4(1.0);
+}
+
+#endif
\ No newline at end of file
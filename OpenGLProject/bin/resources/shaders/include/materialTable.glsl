@@ -0,0 +1,20 @@
+// material constants, one per material drawn this frame (see GPUMaterial in Material.h)
+struct Material
+{
+	vec3 ambient;
+	float specularPower;
+	vec3 diffuse;
+	float opacity;
+	vec3 specular;
+	float roughness;
+	vec3 emissive;
+	float reflectionCoefficient;
+	bool useNormalMap;
+	uint features;
+	uint padding[2];
+	uvec2 textures[8]; // a bindless handle or texture array and layer per slot (see MaterialTextureTable)
+};
+layout(std430, binding = 5) readonly buffer MaterialBuffer
+{
+	Material materials[];
+};
\ No newline at end of file
@@ -22,7 +22,8 @@ struct Material
 };
 
 uniform Material material;
-uniform vec3 cameraPosition;
+
+#include "include/frameConstants.glsl"
 
 out vec4 FragColor;
 
@@ -31,10 +32,12 @@ void main()
 	// index of refraction (water)
 	float ratio = 1.0 / 1.33;
 
-	vec3 normalTexture = texture(material.normalTexture, vTexCoords).rgb;
+	// normal maps may only have x and y (BC5), so z is rebuilt from them
+	vec2 normalXY = texture(material.normalTexture, vTexCoords).rg * 2.0 - 1.0;
+	vec3 normalTexture = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0))) * 0.5 + 0.5;
 	vec3 N = TBN * (normalTexture * 2 - 1);
 
-	vec3 I = normalize(vPosition.xyz - cameraPosition);
+	vec3 I = normalize(vPosition.xyz - cameraPosition.xyz);
 
 	// reflect
 	vec3 R = reflect(I, normalize(N));
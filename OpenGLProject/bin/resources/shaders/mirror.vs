@@ -9,7 +9,7 @@ out vec4 vPosition;
 out mat3 TBN;
 out vec2 vTexCoords;
 
-uniform mat4 ProjectionViewModel;
+#include "include/frameConstants.glsl"
 
 // used to transform position
 uniform mat4 ModelMatrix;
@@ -29,5 +29,5 @@ void main()
 	TBN = mat3(T, B, N);
 
 	vTexCoords = TexCoords;
-	gl_Position = ProjectionViewModel * Position;
+	gl_Position = projectionView * vPosition;
 }
\ No newline at end of file
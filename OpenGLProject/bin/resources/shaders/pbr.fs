@@ -9,59 +9,24 @@ in mat3 TBN;
 in vec2 vTexCoords;
 in vec4 vColor;
 
-uniform bool correctGamma;
+#include "include/frameConstants.glsl"
 
-// point light(s)
-uniform int pointLightCount;
-struct PointLight
-{
-	vec3 position;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-uniform PointLight pointLights[20];
-
-// directional light(s)
-uniform int directionalLightCount;
-struct DirectionalLight
-{
-	vec3 direction;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-uniform DirectionalLight directionalLights[20];
-
-struct Material
-{
-	// colors
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-	vec3 emissive;
-
-	// textures
-	sampler2D diffuseTexture;
-	sampler2D alphaTexture;
-	sampler2D ambientTexture;
-	sampler2D specularTexture;
-	sampler2D specularHighlightTexture;
-	sampler2D normalTexture;
-	sampler2D displacementTexture;
-	sampler2D emissiveTexture;
-
-	// properties
-	float roughness;
-	float reflectionCoefficient;
-	float opacity;
-	bool useNormalMap;
-};
-uniform Material material;
-
-uniform vec3 cameraPosition;
+#include "include/lights.glsl"
+
+#include "include/materialTable.glsl"
+
+// this draw's entry in the material table (see MaterialTable)
+uniform int materialIndex;
+
+// material of this draw, read at the start of main
+Material material;
+
+// material textures, bound to the units of their slots (see Material::bindTextures)
+// the permutation's defines (HAS_NORMAL_MAP, ALPHA_TEST) leave out what the material doesn't use
+layout(binding = 0) uniform sampler2D diffuseMap;
+layout(binding = 2) uniform sampler2D ambientMap;
+layout(binding = 3) uniform sampler2D specularMap;
+layout(binding = 5) uniform sampler2D normalMap;
 
 out vec4 FragColor;
 
@@ -72,58 +37,72 @@ vec4 gammaCorrection(vec4 color);
 
 void main()
 {
+	material = materials[materialIndex];
+
+	vec4 diffuseSample = texture(diffuseMap, vTexCoords);
+
+#ifdef ALPHA_TEST
 	// transparency
-	if(texture(material.diffuseTexture, vTexCoords).a < 0.5)
+	if(diffuseSample.a < 0.5)
 	{
 		discard;
 	}
+#endif
 
 	// sample textures
-	vec3 diffuseTexture = texture(material.diffuseTexture, vTexCoords).rgb;
-	vec3 alphaTexture = texture(material.alphaTexture, vTexCoords).rgb;
-	vec3 ambientTexture = texture(material.ambientTexture, vTexCoords).rgb;
-	vec3 specularTexture = texture(material.specularTexture, vTexCoords).rgb;
-	vec3 specularHighlightTexture = texture(material.specularHighlightTexture, vTexCoords).rgb;
-	vec3 normalTexture = texture(material.normalTexture, vTexCoords).rgb;
-	vec3 displacementTexture = texture(material.displacementTexture, vTexCoords).rgb;
-	vec3 emissiveTexture = texture(material.emissiveTexture, vTexCoords).rgb;
+	vec3 diffuseTexture = diffuseSample.rgb;
+	vec3 ambientTexture = texture(ambientMap, vTexCoords).rgb;
+	vec3 specularTexture = texture(specularMap, vTexCoords).rgb;
 
 	// ambient lighting
 	vec3 ambient = material.ambient * ambientTexture;
 
 	// use normals
-	vec3 N;
+	vec3 N = TBN[2];
 
+#ifdef HAS_NORMAL_MAP
 	if(material.useNormalMap)
 	{
-		N = (normalTexture * 2.0 - 1.0);
-	}
-	else
-	{
-		N = TBN[2];
+		// normal maps may only have x and y (BC5), so z is rebuilt from them
+		vec2 normalXY = texture(normalMap, vTexCoords).rg * 2.0 - 1.0;
+		N = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 	}
+#endif
 
-	vec3 E = normalize(cameraPosition - vPosition.xyz);
+	vec3 E = normalize(cameraPosition.xyz - vPosition.xyz);
 
 	vec3 diffuse = vec3(0, 0, 0);
 	vec3 specular = vec3(0, 0, 0);
 
 	for(int i = 0; i < pointLightCount; i++)
 	{
-		vec3 L = normalize(vPosition.xyz - pointLights[i].position);
+		vec3 L = normalize(vPosition.xyz - pointLights[i].position.xyz);
 
-		diffuse += OrenNayer(E, N, L) * pointLights[i].diffuse * material.diffuse * diffuseTexture;
+		diffuse += OrenNayer(E, N, L) * pointLights[i].diffuse.xyz * material.diffuse * diffuseTexture;
 
-		specular += CookTorrance(E, N, L) * pointLights[i].specular * material.specular * specularTexture;
+		specular += CookTorrance(E, N, L) * pointLights[i].specular.xyz * material.specular * specularTexture;
 	}
 
 	for(int i = 0; i < directionalLightCount; i++)
 	{
-		vec3 L = normalize(-directionalLights[i].direction);
+		vec3 L = normalize(-directionalLights[i].direction.xyz);
+
+		diffuse += OrenNayer(E, N, L) * directionalLights[i].diffuse.xyz * material.diffuse * diffuseTexture;
+
+		specular += CookTorrance(E, N, L) * directionalLights[i].specular.xyz * material.specular * specularTexture;
+	}
+
+	for(int i = 0; i < spotLightCount; i++)
+	{
+		vec3 L = normalize(vPosition.xyz - spotLights[i].position.xyz);
+
+		// fade from the inner to the outer cone
+		float cosAngle = dot(L, normalize(spotLights[i].direction.xyz));
+		float cone = smoothstep(spotLights[i].cosAngles.y, spotLights[i].cosAngles.x, cosAngle);
 
-		diffuse += OrenNayer(E, N, L) * directionalLights[i].diffuse * material.diffuse * diffuseTexture;
+		diffuse += OrenNayer(E, N, L) * spotLights[i].diffuse.xyz * material.diffuse * diffuseTexture * cone;
 
-		specular += CookTorrance(E, N, L) * directionalLights[i].specular * material.specular * specularTexture;
+		specular += CookTorrance(E, N, L) * spotLights[i].specular.xyz * material.specular * specularTexture * cone;
 	}
 
 	FragColor = vec4(ambient + diffuse + specular, 1.0);
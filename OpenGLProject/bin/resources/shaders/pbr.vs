@@ -11,7 +11,7 @@ out mat3 TBN;
 out vec2 vTexCoords;
 out vec4 vColor;
 
-uniform mat4 ProjectionViewModel;
+#include "include/frameConstants.glsl"
 
 // used to transform position
 uniform mat4 ModelMatrix;
@@ -33,5 +33,5 @@ void main()
 	vTexCoords = TexCoords;
 	vColor = Color;
 
-	gl_Position = ProjectionViewModel * Position;
+	gl_Position = projectionView * vPosition;
 }
\ No newline at end of file
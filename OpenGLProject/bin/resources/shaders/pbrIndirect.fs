@@ -0,0 +1,162 @@
+// a physically based shader (multi draw indirect)
+#version 430
+#extension GL_ARB_bindless_texture : enable
+
+const float e = 2.71828182845904523536028747135;
+const float pi = 3.1415926535897932384626433832;
+
+in vec4 vPosition;
+in mat3 TBN;
+in vec2 vTexCoords;
+in vec4 vColor;
+flat in uint vMaterialIndex;
+
+#include "include/frameConstants.glsl"
+
+#include "include/lights.glsl"
+
+#include "include/materialSampling.glsl"
+
+out vec4 FragColor;
+
+float OrenNayer(vec3 E, vec3 N, vec3 L);
+float CookTorrance(vec3 E, vec3 N, vec3 L);
+
+vec4 gammaCorrection(vec4 color);
+
+void main()
+{
+	material = materials[vMaterialIndex];
+
+	vec4 diffuseSample = sampleMaterial(diffuseMap, vTexCoords);
+
+	// transparency
+	if((material.features & featureAlphaTest) != 0u && diffuseSample.a < 0.5)
+	{
+		discard;
+	}
+
+	// sample textures
+	vec3 diffuseTexture = diffuseSample.rgb;
+	vec3 ambientTexture = sampleMaterial(ambientMap, vTexCoords).rgb;
+	vec3 specularTexture = sampleMaterial(specularMap, vTexCoords).rgb;
+
+	// ambient lighting
+	vec3 ambient = material.ambient * ambientTexture;
+
+	// use normals
+	vec3 N = TBN[2];
+
+	if((material.features & featureNormalMap) != 0u && material.useNormalMap)
+	{
+		// normal maps may only have x and y (BC5), so z is rebuilt from them
+		vec2 normalXY = sampleMaterial(normalMap, vTexCoords).rg * 2.0 - 1.0;
+		N = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+	}
+
+	vec3 E = normalize(cameraPosition.xyz - vPosition.xyz);
+
+	vec3 diffuse = vec3(0, 0, 0);
+	vec3 specular = vec3(0, 0, 0);
+
+	for(int i = 0; i < pointLightCount; i++)
+	{
+		vec3 L = normalize(vPosition.xyz - pointLights[i].position.xyz);
+
+		diffuse += OrenNayer(E, N, L) * pointLights[i].diffuse.xyz * material.diffuse * diffuseTexture;
+
+		specular += CookTorrance(E, N, L) * pointLights[i].specular.xyz * material.specular * specularTexture;
+	}
+
+	for(int i = 0; i < directionalLightCount; i++)
+	{
+		vec3 L = normalize(-directionalLights[i].direction.xyz);
+
+		diffuse += OrenNayer(E, N, L) * directionalLights[i].diffuse.xyz * material.diffuse * diffuseTexture;
+
+		specular += CookTorrance(E, N, L) * directionalLights[i].specular.xyz * material.specular * specularTexture;
+	}
+
+	for(int i = 0; i < spotLightCount; i++)
+	{
+		vec3 L = normalize(vPosition.xyz - spotLights[i].position.xyz);
+
+		// fade from the inner to the outer cone
+		float cosAngle = dot(L, normalize(spotLights[i].direction.xyz));
+		float cone = smoothstep(spotLights[i].cosAngles.y, spotLights[i].cosAngles.x, cosAngle);
+
+		diffuse += OrenNayer(E, N, L) * spotLights[i].diffuse.xyz * material.diffuse * diffuseTexture * cone;
+
+		specular += CookTorrance(E, N, L) * spotLights[i].specular.xyz * material.specular * specularTexture * cone;
+	}
+
+	FragColor = vec4(ambient + diffuse + specular, 1.0);
+
+	// gamma correction (if needed)
+	if(correctGamma)
+	{
+		FragColor = gammaCorrection(FragColor);
+	}
+}
+
+// calculates Oren-Nayer Diffuse Reflectance
+float OrenNayer(vec3 E, vec3 N, vec3 L)
+{
+	float NdL = max(0.0f, dot(N, L));
+	float NdE = max(0.0f, dot(N, E));
+
+	float R2 = material.roughness * material.roughness;
+
+	// Oren-Nayer Diffuse Term
+	float A = 1.0 - 0.5 * R2 / (R2 + 0.33);
+	float B = 0.45 * R2 / (R2 + 0.09);
+
+	// CX = Max(0, cos(l, e))
+	vec3 lightProjected = normalize(L - N * NdL);
+	vec3 viewProjected = normalize(E - N * NdE);
+	float CX = max(0.0, dot(lightProjected, viewProjected));
+
+	// DX = sin(alpha) * tan(beta)
+	float alpha = sin(max(acos(NdE), acos(NdL)));
+	float beta = tan(min(acos(NdE), acos(NdL)));
+	float DX = alpha * beta;
+
+	// Calculate Oren-Nayer
+	float OrenNayer = NdL * (A + B * CX * DX);
+
+	return OrenNayer;
+}
+
+// calculates Cook-Torrance Specular Reflectance
+float CookTorrance(vec3 E, vec3 N, vec3 L)
+{
+	vec3 H = normalize(L + E);
+	float R2 = material.roughness * material.roughness;
+
+	float NdL = max(0.0, dot(N, L));
+	float NdE = max(0.0, dot(N, E));
+	float NdH = max(0.0, dot(N, H));
+	float NdH2 = NdH * NdH;
+
+	// Beckman's Distribution Function D
+	float exponent = -(1 - NdH2) / (NdH2 * R2);
+	float D = pow(e, exponent) / (R2 * NdH2 * NdH2);
+
+	// Fresnel Term F
+	float F = material.reflectionCoefficient + (1.0 - material.reflectionCoefficient) * pow(1 - NdE, 5);
+
+	// Geometric Attenuation Factor G
+	float X = 2.0 * NdH / dot(E, H);
+	float G = min(1, min(X * NdL, X * NdE));
+
+	// Calculate Cook-Torrance
+	float CookTorrance = max((D * G * F) / (NdE * pi), 0.0);
+
+	return CookTorrance;
+}
+
+// applys gamma correction
+vec4 gammaCorrection(vec4 color)
+{
+	return vec4(pow(color.xyz, vec3(1.0 / 2.2)), color.w);
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+// phong shader (multi draw indirect)
+#version 430
+#extension GL_ARB_bindless_texture : enable
+
+in vec4 vPosition;
+in mat3 TBN;
+in vec2 vTexCoords;
+in vec4 vColor;
+flat in uint vMaterialIndex;
+
+#include "include/frameConstants.glsl"
+
+#include "include/lights.glsl"
+
+#include "include/materialSampling.glsl"
+
+out vec4 FragColor;
+
+vec4 gammaCorrection(vec4 color);
+
+void main()
+{
+	material = materials[vMaterialIndex];
+
+	vec4 diffuseSample = sampleMaterial(diffuseMap, vTexCoords);
+
+	// transparency
+	if((material.features & featureAlphaTest) != 0u && diffuseSample.a < 0.5)
+	{
+		discard;
+	}
+
+	// sample textures
+	vec3 diffuseTexture = diffuseSample.rgb;
+	vec3 ambientTexture = sampleMaterial(ambientMap, vTexCoords).rgb;
+	vec3 specularTexture = sampleMaterial(specularMap, vTexCoords).rgb;
+
+	// ambient lighting
+	vec3 ambient = material.ambient * ambientTexture;
+
+	// use normals
+	vec3 N = TBN[2];
+
+	if((material.features & featureNormalMap) != 0u && material.useNormalMap)
+	{
+		// normal maps may only have x and y (BC5), so z is rebuilt from them
+		vec2 normalXY = sampleMaterial(normalMap, vTexCoords).rg * 2.0 - 1.0;
+		N = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+	}
+
+	// direction from fragment position to camera position
+	vec3 V = normalize(cameraPosition.xyz - vPosition.xyz);
+
+	vec3 diffuse = vec3(0, 0, 0);
+	vec3 specular = vec3(0, 0, 0);
+
+	// point lights
+	for(int i = 0; i < pointLightCount; i++)
+	{
+		// diffuse lighting
+		// direction from fragment position to light position
+		vec3 L = normalize(pointLights[i].position.xyz - vPosition.xyz);
+		float lambertTerm = max(dot(N, L), 0.0);
+		diffuse += pointLights[i].diffuse.xyz * material.diffuse * lambertTerm * diffuseTexture;
+
+		// specular lighting
+		vec3 R = reflect(-L, N);
+		float specularTerm = pow(max(dot(R, V), 0.0), material.specularPower);
+		specular += pointLights[i].specular.xyz * material.specular * specularTerm * specularTexture;
+	}
+
+	// directional lights
+	for(int i = 0; i < directionalLightCount; i++)
+	{
+		// diffuse lighting
+		vec3 L = normalize(-directionalLights[i].direction.xyz);
+		float lambertTerm = max(dot(N, L), 0.0);
+		diffuse += directionalLights[i].diffuse.xyz * material.diffuse * lambertTerm * diffuseTexture;
+
+		// specular lighting
+		vec3 R = reflect(-L, N);
+		float specularTerm = pow(max(dot(R, V), 0.0), material.specularPower);
+		specular += directionalLights[i].specular.xyz * material.specular * specularTerm * specularTexture;
+	}
+
+	// spot lights
+	for(int i = 0; i < spotLightCount; i++)
+	{
+		vec3 L = normalize(spotLights[i].position.xyz - vPosition.xyz);
+
+		// fade from the inner to the outer cone
+		float cosAngle = dot(-L, normalize(spotLights[i].direction.xyz));
+		float cone = smoothstep(spotLights[i].cosAngles.y, spotLights[i].cosAngles.x, cosAngle);
+
+		// diffuse lighting
+		float lambertTerm = max(dot(N, L), 0.0);
+		diffuse += spotLights[i].diffuse.xyz * material.diffuse * lambertTerm * diffuseTexture * cone;
+
+		// specular lighting
+		vec3 R = reflect(-L, N);
+		float specularTerm = pow(max(dot(R, V), 0.0), material.specularPower);
+		specular += spotLights[i].specular.xyz * material.specular * specularTerm * specularTexture * cone;
+	}
+
+	vec3 emissive = vec3(0, 0, 0);
+
+	if((material.features & featureEmissive) != 0u)
+	{
+		emissive = sampleMaterial(emissiveMap, vTexCoords).rgb * vec3(1, 0, 0);
+	}
+
+	FragColor = vec4(ambient + diffuse + specular + emissive, 1.0);
+
+	// gamma correction (if needed)
+	if(correctGamma)
+	{
+		FragColor = gammaCorrection(FragColor);
+	}
+}
+
+// applys gamma correction
+vec4 gammaCorrection(vec4 color)
+{
+	return vec4(pow(color.xyz, vec3(1.0 / 2.2)), color.w);
+}
@@ -0,0 +1,54 @@
+// phong shader (multi draw indirect)
+#version 430
+layout(location = 0) in vec4 Position;
+layout(location = 1) in vec4 Normal;
+layout(location = 2) in vec2 TexCoords;
+layout(location = 3) in vec4 Tangent;
+layout(location = 4) in vec4 Color;
+
+// index of the draw inside the multi draw, comes from baseInstance (see GeometryPool.h)
+layout(location = 5) in uint DrawID;
+
+out vec4 vPosition;
+out mat3 TBN;
+out vec2 vTexCoords;
+out vec4 vColor;
+flat out uint vMaterialIndex;
+
+#include "include/frameConstants.glsl"
+
+// per draw constants (see GPUDrawData in MultiDrawQueue.h)
+struct DrawData
+{
+	mat4 model;
+	uint materialIndex;
+};
+layout(std430, binding = 4) readonly buffer DrawBuffer
+{
+	DrawData draws[];
+};
+
+void main()
+{
+	DrawData draw = draws[DrawID];
+	vMaterialIndex = draw.materialIndex;
+
+	mat4 ModelMatrix = draw.model;
+
+	// the normal matrix is cheaper to work out here than to upload per draw
+	mat3 NormalMatrix = transpose(inverse(mat3(ModelMatrix)));
+
+	vPosition = ModelMatrix * Position;
+	
+	// calculate TBN in vertex shader for efficiency
+	vec3 N = normalize(NormalMatrix * Normal.xyz);
+	vec3 T = normalize(NormalMatrix * Tangent.xyz);
+	vec3 B = cross(N, T) * Tangent.w;
+
+	TBN = mat3(T, B, N);
+
+	vTexCoords = TexCoords;
+	vColor = Color;
+
+	gl_Position = projectionView * vPosition;
+}
\ No newline at end of file
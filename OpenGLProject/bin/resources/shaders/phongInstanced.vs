@@ -0,0 +1,42 @@
+// phong shader (instanced)
+#version 430
+layout(location = 0) in vec4 Position;
+layout(location = 1) in vec4 Normal;
+layout(location = 2) in vec2 TexCoords;
+layout(location = 3) in vec4 Tangent;
+layout(location = 4) in vec4 Color;
+
+out vec4 vPosition;
+out mat3 TBN;
+out vec2 vTexCoords;
+out vec4 vColor;
+
+#include "include/frameConstants.glsl"
+
+// per instance model matrices (see InstanceBuffer.h)
+layout(std430, binding = 3) readonly buffer InstanceBuffer
+{
+	mat4 instanceTransforms[];
+};
+
+void main()
+{
+	mat4 ModelMatrix = instanceTransforms[gl_InstanceID];
+
+	// the normal matrix is cheaper to work out here than to upload per instance
+	mat3 NormalMatrix = transpose(inverse(mat3(ModelMatrix)));
+
+	vPosition = ModelMatrix * Position;
+	
+	// calculate TBN in vertex shader for efficiency
+	vec3 N = normalize(NormalMatrix * Normal.xyz);
+	vec3 T = normalize(NormalMatrix * Tangent.xyz);
+	vec3 B = cross(N, T) * Tangent.w;
+
+	TBN = mat3(T, B, N);
+
+	vTexCoords = TexCoords;
+	vColor = Color;
+
+	gl_Position = projectionView * vPosition;
+}
\ No newline at end of file
@@ -10,7 +10,7 @@ uniform sampler2D specularTexture;
 uniform sampler2D normalTexture;
 uniform sampler2D alphaTexture;
 
-uniform float time;
+#include "include/frameConstants.glsl"
 
 // effects
 vec4 BoxBlur();
@@ -5,10 +5,13 @@ layout(location = 2) in vec2 TexCoords;
 
 out vec2 vTexCoords;
 
-uniform mat4 ProjectionViewModel;
+#include "include/frameConstants.glsl"
+
+// used to transform position
+uniform mat4 ModelMatrix;
 
 void main()
 {
-	gl_Position = ProjectionViewModel * Position;
+	gl_Position = projectionView * ModelMatrix * Position;
 	vTexCoords = TexCoords;
 }
\ No newline at end of file
@@ -8,14 +8,14 @@ out vec4 vPosition;
 out vec4 vNormal;
 out vec3 vTexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+#include "include/frameConstants.glsl"
 
 void main()
 {
 	vTexCoords = Position.xyz;
 	vNormal = Normal;
-	vec4 pos = projection * view * vec4(Position.xyz, 1.0);
+	// remove the translation component of the view matrix so the skybox follows the camera
+	vec4 pos = projection * mat4(mat3(view)) * vec4(Position.xyz, 1.0);
 	vPosition = pos.xyww;
 	gl_Position = pos.xyww;
 }
\ No newline at end of file
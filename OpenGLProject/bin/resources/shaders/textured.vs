@@ -5,10 +5,13 @@ layout(location = 2) in vec2 TexCoord;
 
 out vec2 vTexCoord;
 
-uniform mat4 ProjectionViewModel;
+#include "include/frameConstants.glsl"
+
+// used to transform position
+uniform mat4 ModelMatrix;
 
 void main()
 {
 	vTexCoord = TexCoord;
-	gl_Position = ProjectionViewModel * Position;
+	gl_Position = projectionView * ModelMatrix * Position;
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "AssetLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include "Texture.h"
+#include "Cubemap.h"
+#include "OBJMesh.h"
+#include "RenderStats.h"
+
+AssetLoader& AssetLoader::getInstance()
+{
+	static AssetLoader instance;
+	return instance;
+}
+
+// decoding is mostly waiting on files and stb, obj imports also spread out over the default pool themselves
+AssetLoader::AssetLoader() :
+	m_pending(0),
+	m_pool(std::max(1u, std::thread::hardware_concurrency() / 2))
+{
+}
+
+void AssetLoader::load(const void* owner, std::function<UploadFunction()> decode, std::shared_ptr<void> keepAlive)
+{
+	OwnerState& state = m_owners[owner];
+	state.pending++;
+	m_pending++;
+
+	if (keepAlive != nullptr)
+	{
+		state.keepAlive = std::move(keepAlive);
+	}
+
+	unsigned int generation = state.generation;
+
+	m_pool.enqueue([this, owner, generation, decode]()
+	{
+		CompletedLoad completed;
+		completed.owner = owner;
+		completed.generation = generation;
+		completed.upload = decode();
+
+		m_completed.push(std::move(completed));
+	});
+}
+
+void AssetLoader::loadTexture(const std::shared_ptr<Texture>& texture, const std::string& filename, Color placeholder, const TextureOptions& options)
+{
+	texture->createDummy(placeholder);
+
+	Texture* target = texture.get();
+
+	load(target, [target, filename, options]() -> UploadFunction
+	{
+		// shared so the upload function can still be copied
+		std::shared_ptr<TextureImage> image = std::make_shared<TextureImage>();
+
+		if (!image->decode(filename.c_str(), options.flipVertically))
+		{
+			return [filename]() { std::cout << "Failed to load a texture from " << filename << std::endl; };
+		}
+
+		return [target, image, options]() { target->upload(*image, options); };
+	}, texture);
+}
+
+void AssetLoader::loadCubemap(Cubemap& cubemap, const std::vector<std::string>& filenames, Color placeholder)
+{
+	cubemap.createDummy(placeholder);
+
+	if (filenames.size() != 6)
+	{
+		std::cout << "Cubemap must use 6 textures\n";
+		return;
+	}
+
+	Cubemap* target = &cubemap;
+
+	load(target, [target, filenames]() -> UploadFunction
+	{
+		std::shared_ptr<std::vector<TextureImage>> faces = std::make_shared<std::vector<TextureImage>>(filenames.size());
+
+		for (size_t i = 0; i < filenames.size(); i++)
+		{
+			if (!(*faces)[i].decode(filenames[i].c_str(), false))
+			{
+				std::cout << "Failed to load a texture from " << filenames[i] << std::endl;
+			}
+		}
+
+		return [target, faces]() { target->upload(*faces); };
+	});
+}
+
+void AssetLoader::loadMesh(OBJMesh& mesh, const std::string& filename, GeometryPool* pool, VertexFormat format)
+{
+	// pooled meshes use the layout of the pool
+	if (pool != nullptr)
+	{
+		format = pool->getFormat();
+	}
+
+	OBJMesh* target = &mesh;
+
+	load(target, [target, filename, pool, format]() -> UploadFunction
+	{
+		std::shared_ptr<MeshData> data = std::make_shared<MeshData>();
+
+		if (!OBJMesh::readData(filename, format, *data))
+		{
+			return [filename]() { std::cout << "Failed to load a mesh from " << filename << std::endl; };
+		}
+
+		return [target, filename, pool, data]() { target->create(filename, *data, pool, true); };
+	});
+}
+
+void AssetLoader::cancel(const void* owner)
+{
+	auto state = m_owners.find(owner);
+	if (state != m_owners.end())
+	{
+		state->second.generation++;
+	}
+}
+
+void AssetLoader::update(float budgetMilliseconds)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	FrameStats& stats = RenderStats::getInstance().current();
+
+	CompletedLoad completed;
+	while (m_completed.tryPop(completed))
+	{
+		m_pending--;
+
+		OwnerState& state = m_owners[completed.owner];
+		bool cancelled = state.generation != completed.generation;
+
+		if (!cancelled && completed.upload)
+		{
+			completed.upload();
+			stats.assetUploads++;
+		}
+
+		// nothing else in flight so there is nothing left to cancel (or keep alive)
+		auto owner = m_owners.find(completed.owner);
+		if (--owner->second.pending == 0)
+		{
+			m_owners.erase(owner);
+		}
+
+		completed = CompletedLoad();
+
+		if (std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= budgetMilliseconds)
+		{
+			break;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Color.h"
+#include "LockFreeQueue.h"
+#include "ThreadPool.h"
+#include "VertexLayout.h"
+
+class Texture;
+struct TextureOptions;
+class Cubemap;
+class OBJMesh;
+class GeometryPool;
+
+// singleton background asset loader
+// files are read and decoded on loader threads, the results come back through a lock free queue
+// and the GL objects are created on the main thread within a per frame time budget
+class AssetLoader
+{
+public:
+
+	static AssetLoader& getInstance();
+
+	// GL work run on the main thread once a decode has finished
+	typedef std::function<void()> UploadFunction;
+
+	// run decode on a loader thread, the upload it returns is run on the main thread by update()
+	// owner is what the upload writes into, cancel(owner) drops uploads that haven't happened yet
+	// keepAlive is held on the main thread until the owner has nothing in flight, so it is never released on a loader thread
+	void load(const void* owner, std::function<UploadFunction()> decode, std::shared_ptr<void> keepAlive = nullptr);
+
+	// the texture is a 1x1 placeholder of the given color until the image has been uploaded
+	// the load keeps the texture alive, so there is nothing to cancel (see TextureCache::stream)
+	void loadTexture(const std::shared_ptr<Texture>& texture, const std::string& filename, Color placeholder, const TextureOptions& options);
+
+	// 6 faces (+x, -x, +y, -y, +z, -z), the cubemap is a single color until they are uploaded
+	void loadCubemap(Cubemap& cubemap, const std::vector<std::string>& filenames, Color placeholder);
+
+	// the mesh draws nothing until its geometry is uploaded, its textures then stream in as placeholders
+	void loadMesh(OBJMesh& mesh, const std::string& filename, GeometryPool* pool = nullptr, VertexFormat format = VertexFormat::Full);
+
+	// call before destroying something that still has loads in flight
+	void cancel(const void* owner);
+
+	// run finished uploads until the budget is used up, at least one per call so loading always moves on
+	void update(float budgetMilliseconds);
+
+	// loads still decoding or waiting to be uploaded
+	unsigned int getPendingCount() const { return m_pending; }
+
+private:
+
+	AssetLoader();
+	~AssetLoader() {};
+
+	struct CompletedLoad
+	{
+		const void* owner = nullptr;
+		unsigned int generation = 0;
+		UploadFunction upload;
+	};
+
+	// loads in flight per owner, cancelling bumps the generation so older loads are dropped
+	// only touched on the main thread, entries go away once an owner has nothing in flight
+	struct OwnerState
+	{
+		unsigned int generation = 0;
+		unsigned int pending = 0;
+		std::shared_ptr<void> keepAlive;
+	};
+
+	std::unordered_map<const void*, OwnerState> m_owners;
+	LockFreeQueue<CompletedLoad> m_completed;
+	std::atomic<unsigned int> m_pending;
+
+	// declared last so the workers are joined before anything they push into goes away
+	ThreadPool m_pool;
+};
\ No newline at end of file
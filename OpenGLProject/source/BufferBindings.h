@@ -0,0 +1,27 @@
+#pragma once
+
+// uniform buffer binding points shared by every shader (must match the binding = N in the shaders)
+namespace UniformBlockBinding
+{
+	enum : unsigned int
+	{
+		FrameConstants = 0
+	};
+}
+
+// shader storage buffer binding points shared by every shader (must match the binding = N in the shaders)
+namespace StorageBufferBinding
+{
+	enum : unsigned int
+	{
+		DirectionalLights = 0,
+		PointLights = 1,
+		SpotLights = 2,
+		Instances = 3,
+		DrawData = 4,
+		Materials = 5,
+		DrawBounds = 6,
+		DrawCommands = 7,
+		CullStats = 8
+	};
+}
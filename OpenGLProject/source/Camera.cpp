@@ -31,6 +31,11 @@ void Camera::updateProjectionMatrix()
 	m_projectionMatrix = glm::perspective(glm::radians(m_fieldOfView), (float)m_screenWidth / (float)m_screenHeight, m_nearPlane, m_farPlane);
 }
 
+float Camera::getProjectedScale() const
+{
+	return (float)m_screenHeight / (2.0f * tanf(glm::radians(m_fieldOfView) * 0.5f));
+}
+
 // update the view matrix (done when needed)
 void Camera::updateViewMatrix()
 {
@@ -21,7 +21,13 @@ public:
 	void setPosition(const glm::vec3 position);
 	void setLookAt(const glm::vec3 lookAt);
 
-	const glm::vec3 getPosition() { return m_position; }
+	const glm::vec3 getPosition() const { return m_position; }
+
+	float getNearPlane() const { return m_nearPlane; }
+	float getFarPlane() const { return m_farPlane; }
+
+	// screen pixels one world unit covers at a distance of one unit (divide by the distance for further away)
+	float getProjectedScale() const;
 
 protected:
 
@@ -2,74 +2,98 @@
 #include <cassert>
 #include <iostream>
 #include <glad\glad.h>
-#include <stb\stb_image.h>
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "SamplerCache.h"
+#include "TextureMemoryTracker.h"
 
-// use one file for all sides
-void Cubemap::load(std::string filename)
+Cubemap::~Cubemap()
 {
-	// don't try to load if this cubemap is already initialised
-	assert(m_glHandle == 0);
-
-	// generate textures
-	glGenTextures(1, &m_glHandle);
-
-	// bind the cube map
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+	if (m_glHandle != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Texture, m_glHandle);
+		GLState::getInstance().textureDeleted(m_glHandle);
+		glDeleteTextures(1, &m_glHandle);
+	}
+	TextureMemoryTracker::getInstance().remove(this);
+}
 
-	// create variables for texture size and format
-	int x = 0, y = 0, comp = 0;
-	unsigned char* data;
+// take ownership of another cubemap's GL texture
+Cubemap::Cubemap(Cubemap&& other) noexcept :
+	m_filenames(std::move(other.m_filenames)),
+	m_glHandle(other.m_glHandle),
+	m_format(other.m_format),
+	m_sampler(other.m_sampler),
+	m_memorySize(other.m_memorySize)
+{
+	other.m_glHandle = 0;
 
-	// attempt to read texture
-	data = stbi_load(filename.c_str(), &x, &y, &comp, 0);
+	TextureMemoryTracker::getInstance().remove(&other);
+	trackMemory();
+}
 
-	// if data was read succesfully
-	if (data)
+// release this cubemap and take ownership of another one
+Cubemap& Cubemap::operator = (Cubemap&& other) noexcept
+{
+	if (this != &other)
 	{
-		// determine texture format
-		switch (comp)
+		if (m_glHandle != 0)
 		{
-			// 1 channel texture
-		case(1):
-			m_format = GL_RED;
-			break;
-			// 3 channel rgb texture
-		case(3):
-			m_format = GL_RGB;
-			break;
-			// 4 channel rgba texture
-		case(4):
-			m_format = GL_RGBA;
-			break;
-		default:
-			std::cout << "Unknown number of channels\n";
-			break;
+			GL_TRACK_DELETED(GLObjectType::Texture, m_glHandle);
+			GLState::getInstance().textureDeleted(m_glHandle);
+			glDeleteTextures(1, &m_glHandle);
 		}
 
-		// transfer texture data to gpu
-		for (int i = 0; i < 6; i++)
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, m_format, x, y, 0, m_format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
-		}
+		m_filenames = std::move(other.m_filenames);
+		m_glHandle = other.m_glHandle;
+		m_format = other.m_format;
+		m_sampler = other.m_sampler;
+		m_memorySize = other.m_memorySize;
+
+		other.m_glHandle = 0;
 
-		// free image data (it is already on the GPU)
-		stbi_image_free(data);
+		TextureMemoryTracker::getInstance().remove(&other);
+		trackMemory();
 	}
-	else
+
+	return *this;
+}
+
+// GL format of decoded pixels, 0 if there is none for the channel count
+static GLenum getPixelFormat(unsigned int components)
+{
+	switch (components)
+	{
+	case 1:
+		return GL_RED;
+	case 2:
+		return GL_RG;
+	case 3:
+		return GL_RGB;
+	case 4:
+		return GL_RGBA;
+	default:
+		return 0;
+	}
+}
+
+// use one file for all sides
+void Cubemap::load(std::string filename)
+{
+	// don't try to load if this cubemap is already initialised
+	assert(m_glHandle == 0);
+
+	TextureImage image;
+	if (!image.decode(filename.c_str(), false))
 	{
 		std::cout << "Failed to load a texture from " << filename << std::endl;
-		stbi_image_free(data);
+		return;
 	}
 
-	// enable texture filtering
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	m_filenames.assign(1, filename);
 
-	// enable texture clamp
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	const TextureImage* faces[6] = { &image, &image, &image, &image, &image, &image };
+	upload(faces);
 }
 
 void Cubemap::load(std::vector<std::string> filenames)
@@ -77,83 +101,209 @@ void Cubemap::load(std::vector<std::string> filenames)
 	// don't try to load if this cubemap is already initialised
 	assert(m_glHandle == 0);
 
-	stbi_set_flip_vertically_on_load(false);
-
 	if (filenames.size() != 6)
 	{
 		std::cout << "Cubemap must use 6 textures\n";
 		return;
 	}
 
+	// read every face, failed ones are left empty
+	std::vector<TextureImage> faces(filenames.size());
+	for (size_t i = 0; i < filenames.size(); i++)
+	{
+		if (!faces[i].decode(filenames[i].c_str(), false))
+		{
+			std::cout << "Failed to load a texture from " << filenames[i] << std::endl;
+		}
+	}
+
 	// store filenames
 	m_filenames = filenames;
 
+	upload(faces);
+}
+
+void Cubemap::upload(const std::vector<TextureImage>& faces)
+{
+	assert(faces.size() == 6);
+
+	const TextureImage* pointers[6];
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		pointers[i] = &faces[i];
+	}
+
+	upload(pointers);
+}
+
+void Cubemap::upload(const TextureImage* const (&faces)[6])
+{
+	// the immutable storage is sized from the first face that loaded, the others have to match it
+	const TextureImage* first = nullptr;
+	for (const TextureImage* face : faces)
+	{
+		if (face->isCompressed() || face->pixels != nullptr)
+		{
+			first = face;
+			break;
+		}
+	}
+
+	if (first == nullptr)
+	{
+		std::cout << "None of the cubemap faces could be loaded\n";
+		return;
+	}
+
+	bool compressed = first->isCompressed();
+	unsigned int width = compressed ? first->compressed.width : first->width;
+	unsigned int height = compressed ? first->compressed.height : first->height;
+	unsigned int levelCount = 0;
+	GLenum pixelFormat = 0;
+
+	if (compressed)
+	{
+		m_format = Texture::getCompressedFormat(first->compressed.format);
+		if (m_format == 0)
+		{
+			std::cout << "Block compressed textures aren't supported by this driver\n";
+			return;
+		}
+
+		levelCount = first->compressed.getLevelCount();
+	}
+	else
+	{
+		pixelFormat = getPixelFormat(first->components);
+		if (pixelFormat == 0)
+		{
+			std::cout << "Unknown number of channels\n";
+			return;
+		}
+
+		m_format = Texture::getSizedFormat(pixelFormat);
+		levelCount = Texture::getLevelCount(width, height);
+	}
+
+	// replace the placeholder if there is one
+	if (m_glHandle != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Texture, m_glHandle);
+		GLState::getInstance().textureDeleted(m_glHandle);
+		glDeleteTextures(1, &m_glHandle);
+	}
+
 	// generate textures
 	glGenTextures(1, &m_glHandle);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Cubemap");
 
 	// bind the cube map
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_CUBE_MAP, m_glHandle);
 
-	// create variables for texture size and format
-	int x = 0, y = 0, comp = 0;
-	unsigned char* data;
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, levelCount, m_format, width, height);
+
+	m_memorySize = 0;
 
 	// for each texture
-	for (GLuint i = 0; i < filenames.size(); i++)
+	for (GLuint i = 0; i < 6; i++)
 	{
-		// attempt to read texture
-		data = stbi_load(filenames[i].c_str(), &x, &y, &comp, 0);
+		const TextureImage& face = *faces[i];
 
-		// if data was read succesfully
-		if (data)
+		// block compressed faces come with their mips
+		if (compressed)
 		{
-			// determine texture format
-			switch (comp)
+			const CompressedImage& image = face.compressed;
+			if (image.format != first->compressed.format || image.width != width || image.height != height || image.getLevelCount() != levelCount)
 			{
-				// 1 channel texture
-			case(1):
-				m_format = GL_RED;
-				break;
-				// 3 channel rgb texture
-			case(3):
-				m_format = GL_RGB;
-				break;
-				// 4 channel rgba texture
-			case(4):
-				m_format = GL_RGBA;
-				break;
-			default:
-				std::cout << "Unknown number of channels\n";
-				break;
+				std::cout << "Cubemap face " << face.filename << " doesn't match the other faces\n";
+				continue;
 			}
 
-			// transfer texture data to gpu
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, m_format, x, y, 0, m_format, GL_UNSIGNED_BYTE, data);
-
-			glGenerateMipmap(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+			for (unsigned int level = 0; level < levelCount; level++)
+			{
+				glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, 0, 0, image.getLevelWidth(level), image.getLevelHeight(level), m_format,
+					(GLsizei)image.getLevelSize(level), image.getLevelData(level));
+				m_memorySize += image.getLevelSize(level);
+			}
+			continue;
+		}
 
-			// free image data (it is already on the GPU)
-			stbi_image_free(data);
+		if (face.pixels == nullptr || face.components != first->components || face.width != width || face.height != height)
+		{
+			std::cout << "Cubemap face " << face.filename << " doesn't match the other faces\n";
+			continue;
 		}
-		else
+
+		// transfer texture data to gpu
+		glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, width, height, pixelFormat, GL_UNSIGNED_BYTE, face.pixels);
+
+		size_t faceSize = (size_t)width * height * Texture::getBytesPerPixel(m_format);
+		m_memorySize += faceSize + faceSize / 3;
+	}
+
+	if (!compressed)
+	{
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+	}
+
+	// streamed faces never went through load, name the cubemap after them for the memory stats
+	if (m_filenames.empty())
+	{
+		for (const TextureImage* face : faces)
 		{
-			std::cout << "Failed to load a texture from " << filenames[i] << std::endl;
-			stbi_image_free(data);
+			m_filenames.push_back(face->filename);
 		}
 	}
 
-	// enable texture filtering
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	trackMemory();
+
+	// filtered and clamped so the seams don't show
+	m_sampler = SamplerCache::getInstance().get(SamplerDesc::get(GL_LINEAR, GL_CLAMP_TO_EDGE, levelCount > 1));
+}
+
+void Cubemap::createDummy(Color color)
+{
+	if (m_glHandle != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Texture, m_glHandle);
+		GLState::getInstance().textureDeleted(m_glHandle);
+		glDeleteTextures(1, &m_glHandle);
+	}
+
+	m_format = GL_RGBA8;
+
+	glGenTextures(1, &m_glHandle);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Cubemap");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_CUBE_MAP, m_glHandle);
+
+	unsigned char pixels[4] { color.r, color.g, color.b, color.a };
+
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, m_format, 1, 1);
+	for (GLuint i = 0; i < 6; i++)
+	{
+		glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+
+	m_memorySize = 6 * sizeof(pixels);
+	trackMemory();
 
-	// enable texture clamp
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	m_sampler = SamplerCache::getInstance().get(SamplerType::Nearest);
 }
 
 void Cubemap::bind(unsigned int slot) const
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_glHandle);
+	GLState::getInstance().bindTexture(slot, GL_TEXTURE_CUBE_MAP, m_glHandle);
+	GLState::getInstance().bindSampler(slot, m_sampler);
 }
+
+
+void Cubemap::trackMemory()
+{
+	if (m_glHandle == 0)
+	{
+		TextureMemoryTracker::getInstance().remove(this);
+		return;
+	}
+
+	TextureMemoryTracker::getInstance().set(this, m_filenames.empty() ? "cubemap" : m_filenames.front(), 0, m_memorySize);
+}
\ No newline at end of file
@@ -3,21 +3,47 @@
 #include <string>
 #include "Texture.h"
 
+// cubemap texture, owns its GL texture so it can be moved but not copied
 class Cubemap
 {
 public:
 
+	Cubemap() {};
+	~Cubemap();
+
+	Cubemap(Cubemap&& other) noexcept;
+	Cubemap& operator = (Cubemap&& other) noexcept;
+
+	Cubemap(const Cubemap&) = delete;
+	Cubemap& operator = (const Cubemap&) = delete;
+
 	void load(std::string filename);
 	void load(std::vector<std::string> filenames);
 
+	// create the GL cubemap from 6 decoded faces (+x, -x, +y, -y, +z, -z), replacing the current one
+	void upload(const std::vector<TextureImage>& faces);
+
+	// 1x1 cubemap of a single color, used until the real faces are loaded
+	void createDummy(Color color);
+
 	void bind(unsigned int slot) const;
 
 	unsigned int getHandle() const { return m_glHandle; }
 
+	// bytes of GPU memory used by all 6 faces and their mips
+	size_t getMemorySize() const { return m_memorySize; }
+
 protected:
 
+	// every face uploaded into one immutable storage, the faces can be the same image
+	void upload(const TextureImage* const (&faces)[6]);
+
+	void trackMemory();
+
+
 	std::vector<std::string> m_filenames;
 	unsigned int m_glHandle = 0;
 	unsigned int m_format = 0;
-	unsigned char* m_loadedPixels = nullptr;
+	unsigned int m_sampler = 0;
+	size_t m_memorySize = 0;
 };
\ No newline at end of file
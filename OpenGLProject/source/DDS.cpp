@@ -0,0 +1,416 @@
+#include "DDS.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include "MappedFile.h"
+
+// "DDS " read as a little endian int
+static const uint32_t DDSMagic = 0x20534444;
+
+static uint32_t makeFourCC(const char* code)
+{
+	return (uint32_t)code[0] | ((uint32_t)code[1] << 8) | ((uint32_t)code[2] << 16) | ((uint32_t)code[3] << 24);
+}
+
+// header flags / caps used when writing
+static const uint32_t FlagCaps = 0x1;
+static const uint32_t FlagHeight = 0x2;
+static const uint32_t FlagWidth = 0x4;
+static const uint32_t FlagPixelFormat = 0x1000;
+static const uint32_t FlagMipMapCount = 0x20000;
+static const uint32_t FlagLinearSize = 0x80000;
+static const uint32_t PixelFormatFourCC = 0x4;
+static const uint32_t CapsComplex = 0x8;
+static const uint32_t CapsTexture = 0x1000;
+static const uint32_t CapsMipMap = 0x400000;
+
+// dxgi formats of the block compressed textures (UNORM and SRGB / TYPELESS variants)
+static const uint32_t DXGIBC1[] = { 70, 71, 72 };
+static const uint32_t DXGIBC2[] = { 73, 74, 75 };
+static const uint32_t DXGIBC3[] = { 76, 77, 78 };
+static const uint32_t DXGIBC4[] = { 79, 80 };
+static const uint32_t DXGIBC5[] = { 82, 83 };
+static const uint32_t DXGIBC7[] = { 97, 98, 99 };
+
+struct DDSPixelFormat
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t masks[4];
+};
+
+struct DDSHeader
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DDSPixelFormat pixelFormat;
+	uint32_t caps[4];
+	uint32_t reserved2;
+};
+static_assert(sizeof(DDSHeader) == 124, "DDSHeader must match the file layout");
+
+struct DDSHeaderDX10
+{
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+template<size_t N>
+static bool contains(const uint32_t (&values)[N], uint32_t value)
+{
+	return std::find(values, values + N, value) != values + N;
+}
+
+size_t CompressedImage::getLevelSize(unsigned int level) const
+{
+	return DDS::getLevelSize(format, getLevelWidth(level), getLevelHeight(level));
+}
+
+unsigned int DDS::getBlockSize(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t DDS::getLevelSize(BlockFormat format, unsigned int width, unsigned int height)
+{
+	size_t blocksWide = std::max(1u, (width + 3) / 4);
+	size_t blocksHigh = std::max(1u, (height + 3) / 4);
+	return blocksWide * blocksHigh * getBlockSize(format);
+}
+
+std::string DDS::getPath(const std::string& imagePath)
+{
+	size_t slash = imagePath.find_last_of("\\/");
+	size_t dot = imagePath.find_last_of('.');
+
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return imagePath + ".dds";
+	}
+
+	return imagePath.substr(0, dot) + ".dds";
+}
+
+// check the headers of a mapped file, fills in the image's format, size and levels, returns the offset of the data (0 on failure)
+static size_t parseHeader(const MappedFile& file, CompressedImage& image)
+{
+	if (file.size() < 4 + sizeof(DDSHeader))
+	{
+		return 0;
+	}
+
+	const unsigned char* data = file.data();
+
+	uint32_t magic;
+	DDSHeader header;
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + 4, sizeof(header));
+
+	if (magic != DDSMagic || header.size != sizeof(DDSHeader) || (header.pixelFormat.flags & PixelFormatFourCC) == 0)
+	{
+		return 0;
+	}
+
+	size_t offset = 4 + sizeof(DDSHeader);
+	BlockFormat format = BlockFormat::None;
+	uint32_t fourCC = header.pixelFormat.fourCC;
+
+	if (fourCC == makeFourCC("DXT1"))
+		format = BlockFormat::BC1;
+	else if (fourCC == makeFourCC("DXT3"))
+		format = BlockFormat::BC2;
+	else if (fourCC == makeFourCC("DXT5"))
+		format = BlockFormat::BC3;
+	else if (fourCC == makeFourCC("ATI1") || fourCC == makeFourCC("BC4U"))
+		format = BlockFormat::BC4;
+	else if (fourCC == makeFourCC("ATI2") || fourCC == makeFourCC("BC5U"))
+		format = BlockFormat::BC5;
+	else if (fourCC == makeFourCC("DX10"))
+	{
+		if (file.size() < offset + sizeof(DDSHeaderDX10))
+		{
+			return 0;
+		}
+
+		DDSHeaderDX10 extended;
+		memcpy(&extended, data + offset, sizeof(extended));
+		offset += sizeof(extended);
+
+		// only plain 2D textures
+		if (extended.arraySize > 1)
+		{
+			return 0;
+		}
+
+		if (contains(DXGIBC1, extended.dxgiFormat))
+			format = BlockFormat::BC1;
+		else if (contains(DXGIBC2, extended.dxgiFormat))
+			format = BlockFormat::BC2;
+		else if (contains(DXGIBC3, extended.dxgiFormat))
+			format = BlockFormat::BC3;
+		else if (contains(DXGIBC4, extended.dxgiFormat))
+			format = BlockFormat::BC4;
+		else if (contains(DXGIBC5, extended.dxgiFormat))
+			format = BlockFormat::BC5;
+		else if (contains(DXGIBC7, extended.dxgiFormat))
+			format = BlockFormat::BC7;
+	}
+
+	if (format == BlockFormat::None || header.width == 0 || header.height == 0)
+	{
+		return 0;
+	}
+
+	image.format = format;
+	image.width = header.width;
+	image.height = header.height;
+	image.data.clear();
+	image.levelOffsets.clear();
+
+	// the count is optional, 0 means just the top level
+	unsigned int levelCount = std::max(1u, header.mipMapCount);
+
+	size_t size = 0;
+	for (unsigned int level = 0; level < levelCount; level++)
+	{
+		image.levelOffsets.push_back(size);
+		size += image.getLevelSize(level);
+	}
+
+	if (file.size() < offset + size)
+	{
+		image.levelOffsets.clear();
+		return 0;
+	}
+
+	return offset;
+}
+
+bool DDS::read(const std::string& filename, CompressedImage& image)
+{
+	return readLevels(filename, 0, ~0u, image);
+}
+
+bool DDS::readHeader(const std::string& filename, CompressedImage& image)
+{
+	MappedFile file;
+	return file.open(filename) && parseHeader(file, image) > 0;
+}
+
+bool DDS::readLevels(const std::string& filename, unsigned int firstLevel, unsigned int count, CompressedImage& image)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	CompressedImage whole;
+	size_t offset = parseHeader(file, whole);
+	if (offset == 0 || firstLevel >= whole.getLevelCount())
+	{
+		return false;
+	}
+
+	unsigned int endLevel = firstLevel + std::min(count, whole.getLevelCount() - firstLevel);
+
+	// only the requested levels are copied out of the mapping, the rest is never paged in
+	size_t begin = whole.levelOffsets[firstLevel];
+	size_t end = whole.levelOffsets[endLevel - 1] + whole.getLevelSize(endLevel - 1);
+
+	image.format = whole.format;
+	image.width = whole.getLevelWidth(firstLevel);
+	image.height = whole.getLevelHeight(firstLevel);
+	image.levelOffsets.clear();
+	for (unsigned int level = firstLevel; level < endLevel; level++)
+	{
+		image.levelOffsets.push_back(whole.levelOffsets[level] - begin);
+	}
+
+	image.data.assign(file.data() + offset + begin, file.data() + offset + end);
+	return true;
+}
+
+bool DDS::write(const std::string& filename, const CompressedImage& image)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = FlagCaps | FlagHeight | FlagWidth | FlagPixelFormat | FlagMipMapCount | FlagLinearSize;
+	header.height = image.height;
+	header.width = image.width;
+	header.pitchOrLinearSize = (uint32_t)image.getLevelSize(0);
+	header.mipMapCount = image.getLevelCount();
+	header.pixelFormat.size = sizeof(DDSPixelFormat);
+	header.pixelFormat.flags = PixelFormatFourCC;
+	header.caps[0] = CapsTexture | (image.getLevelCount() > 1 ? CapsComplex | CapsMipMap : 0);
+
+	DDSHeaderDX10 extended = {};
+	bool useExtended = false;
+
+	switch (image.format)
+	{
+	case BlockFormat::BC1:
+		header.pixelFormat.fourCC = makeFourCC("DXT1");
+		break;
+	case BlockFormat::BC2:
+		header.pixelFormat.fourCC = makeFourCC("DXT3");
+		break;
+	case BlockFormat::BC3:
+		header.pixelFormat.fourCC = makeFourCC("DXT5");
+		break;
+	case BlockFormat::BC4:
+		header.pixelFormat.fourCC = makeFourCC("ATI1");
+		break;
+	case BlockFormat::BC5:
+		header.pixelFormat.fourCC = makeFourCC("ATI2");
+		break;
+	case BlockFormat::BC7:
+		// BC7 only exists in the dx10 extension
+		header.pixelFormat.fourCC = makeFourCC("DX10");
+		extended.dxgiFormat = 98;
+		extended.resourceDimension = 3;
+		extended.arraySize = 1;
+		useExtended = true;
+		break;
+	default:
+		return false;
+	}
+
+	file.write((const char*)&DDSMagic, sizeof(DDSMagic));
+	file.write((const char*)&header, sizeof(header));
+	if (useExtended)
+	{
+		file.write((const char*)&extended, sizeof(extended));
+	}
+	file.write((const char*)image.data.data(), image.data.size());
+
+	return file.good();
+}
+
+// reverse the first rows rows (a byte of 2 bit indices each) of a BC1 color block
+static void flipColorBlock(unsigned char* block, unsigned int rows)
+{
+	std::reverse(block + 4, block + 4 + rows);
+}
+
+// reverse the first rows 12 bit (4 x 3 bit) index rows of a BC4 style alpha block
+static void flipAlphaBlock(unsigned char* block, unsigned int rows)
+{
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		bits |= (uint64_t)block[2 + i] << (8 * i);
+	}
+
+	uint64_t flipped = bits & ~((1ull << (12 * rows)) - 1);
+	for (unsigned int row = 0; row < rows; row++)
+	{
+		uint64_t rowBits = (bits >> (12 * row)) & 0xFFF;
+		flipped |= rowBits << (12 * (rows - 1 - row));
+	}
+
+	for (int i = 0; i < 6; i++)
+	{
+		block[2 + i] = (unsigned char)(flipped >> (8 * i));
+	}
+}
+
+// reverse the first rows 16 bit rows of a BC2 explicit alpha block
+static void flipExplicitAlphaBlock(unsigned char* block, unsigned int rows)
+{
+	uint16_t values[4];
+	memcpy(values, block, sizeof(values));
+	std::reverse(values, values + rows);
+	memcpy(block, values, sizeof(values));
+}
+
+// flip the texel rows inside a block, rows is how many of the 4 are part of the image
+static void flipBlock(BlockFormat format, unsigned char* block, unsigned int rows)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		flipColorBlock(block, rows);
+		break;
+	case BlockFormat::BC2:
+		flipExplicitAlphaBlock(block, rows);
+		flipColorBlock(block + 8, rows);
+		break;
+	case BlockFormat::BC3:
+		flipAlphaBlock(block, rows);
+		flipColorBlock(block + 8, rows);
+		break;
+	case BlockFormat::BC4:
+		flipAlphaBlock(block, rows);
+		break;
+	case BlockFormat::BC5:
+		flipAlphaBlock(block, rows);
+		flipAlphaBlock(block + 8, rows);
+		break;
+	default:
+		break;
+	}
+}
+
+bool DDS::canFlipVertically(BlockFormat format)
+{
+	return format != BlockFormat::BC7 && format != BlockFormat::None;
+}
+
+// exact for heights that are a multiple of 4 (and levels under 4 high), otherwise off by the padding rows
+bool DDS::flipVertically(CompressedImage& image)
+{
+	if (!canFlipVertically(image.format))
+	{
+		return false;
+	}
+
+	unsigned int blockSize = getBlockSize(image.format);
+	std::vector<unsigned char> row;
+
+	for (unsigned int level = 0; level < image.getLevelCount(); level++)
+	{
+		unsigned int width = image.getLevelWidth(level);
+		unsigned int height = image.getLevelHeight(level);
+		unsigned int blocksWide = std::max(1u, (width + 3) / 4);
+		unsigned int blocksHigh = std::max(1u, (height + 3) / 4);
+		unsigned int rows = std::min(height, 4u);
+
+		unsigned char* data = image.data.data() + image.levelOffsets[level];
+		size_t rowSize = (size_t)blocksWide * blockSize;
+		row.resize(rowSize);
+
+		// swap block rows top to bottom
+		for (unsigned int top = 0, bottom = blocksHigh - 1; top < bottom; top++, bottom--)
+		{
+			memcpy(row.data(), data + top * rowSize, rowSize);
+			memcpy(data + top * rowSize, data + bottom * rowSize, rowSize);
+			memcpy(data + bottom * rowSize, row.data(), rowSize);
+		}
+
+		for (size_t block = 0; block < (size_t)blocksWide * blocksHigh; block++)
+		{
+			flipBlock(image.format, data + block * blockSize, rows);
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// block compressed formats, every 4x4 block of texels is 8 (BC1, BC4) or 16 bytes
+enum class BlockFormat
+{
+	None,
+	BC1,	// rgb + 1 bit alpha
+	BC2,	// rgb + explicit 4 bit alpha
+	BC3,	// rgb + interpolated alpha
+	BC4,	// one channel
+	BC5,	// two channels, used for normal maps
+	BC7		// high quality rgba
+};
+
+// block compressed image with its mip chain in one allocation, no GL so tools can use it
+struct CompressedImage
+{
+	BlockFormat format = BlockFormat::None;
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	std::vector<unsigned char> data;
+	std::vector<size_t> levelOffsets; // start of each mip level in data
+
+	unsigned int getLevelCount() const { return (unsigned int)levelOffsets.size(); }
+	unsigned int getLevelWidth(unsigned int level) const { return width >> level > 0 ? width >> level : 1; }
+	unsigned int getLevelHeight(unsigned int level) const { return height >> level > 0 ? height >> level : 1; }
+	size_t getLevelSize(unsigned int level) const;
+	const unsigned char* getLevelData(unsigned int level) const { return data.data() + levelOffsets[level]; }
+};
+
+// reading and writing .dds files
+namespace DDS
+{
+	unsigned int getBlockSize(BlockFormat format);
+
+	// bytes of one mip level
+	size_t getLevelSize(BlockFormat format, unsigned int width, unsigned int height);
+
+	// path of the dds file the TextureConverter writes for an image (same name, .dds extension)
+	std::string getPath(const std::string& imagePath);
+
+	bool read(const std::string& filename, CompressedImage& image);
+
+	// format, size and mip count only, the image gets its level offsets but no data
+	bool readHeader(const std::string& filename, CompressedImage& image);
+
+	// read levels [firstLevel, firstLevel + count) as an image whose top level is firstLevel
+	bool readLevels(const std::string& filename, unsigned int firstLevel, unsigned int count, CompressedImage& image);
+
+	bool write(const std::string& filename, const CompressedImage& image);
+
+	// flip every level upside down by reordering rows of blocks and the rows inside each block
+	// (BC7 blocks can't be flipped that way, returns false for them)
+	bool flipVertically(CompressedImage& image);
+
+	// whether flipVertically can flip images of a format
+	bool canFlipVertically(BlockFormat format);
+}
\ No newline at end of file
@@ -21,6 +21,13 @@ public:
 	void processKeyboard(Camera_Movement direction);
 	void processMouseMovement(float xoffset, float yoffset);
 
+	// ray to pick with, through the crosshair since the cursor is locked to the window
+	void getPickRay(glm::vec3& origin, glm::vec3& direction) const
+	{
+		origin = m_position;
+		direction = m_front;
+	}
+
 private:
 
 	void updateViewMatrix();
@@ -0,0 +1,36 @@
+#include "FrameConstants.h"
+#include <glad\glad.h>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+
+static_assert(sizeof(FrameConstants) == 240, "FrameConstants must match the std140 block size");
+
+FrameConstantBuffer::~FrameConstantBuffer()
+{
+	if (m_buffer != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+}
+
+// upload this frame's constants
+void FrameConstantBuffer::update(const FrameConstants& constants)
+{
+	if (m_buffer == 0)
+	{
+		glGenBuffers(1, &m_buffer);
+		GL_TRACK_CREATED(GLObjectType::Buffer, m_buffer, "FrameConstantBuffer");
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		// the binding point never changes so every program sees this buffer without further binds
+		glBindBufferBase(GL_UNIFORM_BUFFER, UniformBlockBinding::FrameConstants, m_buffer);
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <glm\glm.hpp>
+
+// std140 layout of the FrameConstants uniform block declared at the top of every shader
+struct FrameConstants
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 projectionView;
+	glm::vec4 cameraPosition;
+	float time = 0.0f;
+	int correctGamma = 0;
+	int directionalLightCount = 0;
+	int pointLightCount = 0;
+	int spotLightCount = 0;
+	int padding[3] = {}; // std140 rounds the block up to a multiple of 16 bytes
+};
+
+// uniform buffer holding the FrameConstants, written once per frame and shared by every shader program
+class FrameConstantBuffer
+{
+public:
+
+	FrameConstantBuffer() {};
+	~FrameConstantBuffer();
+
+	FrameConstantBuffer(const FrameConstantBuffer&) = delete;
+	FrameConstantBuffer& operator = (const FrameConstantBuffer&) = delete;
+
+	// upload this frame's constants
+	void update(const FrameConstants& constants);
+
+private:
+
+	unsigned int m_buffer = 0;
+};
@@ -0,0 +1,157 @@
+#include "Frustum.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE
+#endif
+
+void BoxList::clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+// add the world space box around an object space box moved by a transform
+void BoxList::add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform)
+{
+	glm::vec3 center = glm::vec3(transform * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	glm::vec3 halfSize = (boundsMax - boundsMin) * 0.5f;
+
+	// each world axis gets the length of the rotated / scaled box along it
+	glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+	glm::vec3 extents = absolute * halfSize;
+
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extents.x);
+	extentY.push_back(extents.y);
+	extentZ.push_back(extents.z);
+}
+
+void BoxList::add(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	glm::vec3 extents = (boundsMax - boundsMin) * 0.5f;
+
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extents.x);
+	extentY.push_back(extents.y);
+	extentZ.push_back(extents.z);
+}
+
+// pull the planes out of a projection view matrix (Gribb / Hartmann), rows of the matrix added / subtracted
+void Frustum::extract(const glm::mat4& projectionView)
+{
+	glm::vec4 rowX = glm::vec4(projectionView[0][0], projectionView[1][0], projectionView[2][0], projectionView[3][0]);
+	glm::vec4 rowY = glm::vec4(projectionView[0][1], projectionView[1][1], projectionView[2][1], projectionView[3][1]);
+	glm::vec4 rowZ = glm::vec4(projectionView[0][2], projectionView[1][2], projectionView[2][2], projectionView[3][2]);
+	glm::vec4 rowW = glm::vec4(projectionView[0][3], projectionView[1][3], projectionView[2][3], projectionView[3][3]);
+
+	m_planes[0] = rowW + rowX; // left
+	m_planes[1] = rowW - rowX; // right
+	m_planes[2] = rowW + rowY; // bottom
+	m_planes[3] = rowW - rowY; // top
+	m_planes[4] = rowW + rowZ; // near
+	m_planes[5] = rowW - rowZ; // far
+
+	// normalised so sphere radii can be compared against the distances
+	for (glm::vec4& plane : m_planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+// box given by its center and half extents
+bool Frustum::intersects(const glm::vec3& center, const glm::vec3& extents) const
+{
+	for (const glm::vec4& plane : m_planes)
+	{
+		// distance of the center against how far the box reaches towards the plane
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		float reach = glm::dot(glm::abs(glm::vec3(plane)), extents);
+
+		if (distance + reach < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// sphere
+bool Frustum::intersects(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : m_planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// whether each box touches the frustum (1) or is fully outside a plane (0)
+void Frustum::cull(const BoxList& boxes, std::vector<unsigned char>& visible) const
+{
+	size_t count = boxes.size();
+	visible.resize(count);
+
+	size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+	// the same test as intersects, with a box per lane
+	__m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&boxes.centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&boxes.centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&boxes.centerZ[i]);
+		__m128 extentX = _mm_loadu_ps(&boxes.extentX[i]);
+		__m128 extentY = _mm_loadu_ps(&boxes.extentY[i]);
+		__m128 extentZ = _mm_loadu_ps(&boxes.extentZ[i]);
+
+		// lanes of boxes outside any plane so far
+		__m128 outside = zero;
+
+		for (const glm::vec4& plane : m_planes)
+		{
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+				_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+			__m128 reach = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(fabsf(plane.x))), _mm_mul_ps(extentY, _mm_set1_ps(fabsf(plane.y)))),
+				_mm_mul_ps(extentZ, _mm_set1_ps(fabsf(plane.z))));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		visible[i] = (mask & 1) == 0;
+		visible[i + 1] = (mask & 2) == 0;
+		visible[i + 2] = (mask & 4) == 0;
+		visible[i + 3] = (mask & 8) == 0;
+	}
+#endif
+
+	// whatever doesn't fill a group of 4
+	for (; i < count; i++)
+	{
+		glm::vec3 center = glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+		glm::vec3 extents = glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+
+		visible[i] = intersects(center, extents) ? 1 : 0;
+	}
+}
\ No newline at end of file
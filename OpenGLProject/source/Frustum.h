@@ -0,0 +1,48 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <vector>
+
+// world space boxes kept as separate center / half extent arrays, the layout Frustum::cull reads 4 at a time
+struct BoxList
+{
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	void clear();
+
+	// add the world space box around an object space box moved by a transform
+	void add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform);
+
+	// add a box that is already in world space
+	void add(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+	size_t size() const { return centerX.size(); }
+};
+
+// the six planes of a camera's view volume, normals pointing inwards
+class Frustum
+{
+public:
+
+	Frustum() {};
+	explicit Frustum(const glm::mat4& projectionView) { extract(projectionView); }
+
+	// pull the planes out of a projection view matrix (e.g. Camera::getProjectionViewMatrix)
+	void extract(const glm::mat4& projectionView);
+
+	// box given by its center and half extents
+	bool intersects(const glm::vec3& center, const glm::vec3& extents) const;
+
+	// sphere
+	bool intersects(const glm::vec3& center, float radius) const;
+
+	// whether each box touches the frustum (1) or is fully outside a plane (0), SSE tests 4 boxes at once
+	void cull(const BoxList& boxes, std::vector<unsigned char>& visible) const;
+
+	// xyz normal, w distance, a point p is inside when dot(xyz, p) + w >= 0
+	const glm::vec4& getPlane(unsigned int index) const { return m_planes[index]; }
+
+private:
+
+	glm::vec4 m_planes[6];
+};
\ No newline at end of file
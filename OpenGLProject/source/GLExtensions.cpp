@@ -0,0 +1,29 @@
+#include "GLExtensions.h"
+#include <glad\glad.h>
+#include <GLFW\glfw3.h>
+#include <string>
+#include <unordered_set>
+
+bool GLExtensions::has(const char* name)
+{
+	static const std::unordered_set<std::string> extensions = []()
+	{
+		std::unordered_set<std::string> names;
+
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			names.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+		}
+
+		return names;
+	}();
+
+	return extensions.count(name) > 0;
+}
+
+void* GLExtensions::getProcAddress(const char* name)
+{
+	return (void*)glfwGetProcAddress(name);
+}
\ No newline at end of file
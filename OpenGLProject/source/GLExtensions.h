@@ -0,0 +1,12 @@
+#pragma once
+
+// optional GL extensions, glad is generated for the core profile only so these are looked up by hand
+// (needs a current context)
+namespace GLExtensions
+{
+	// whether the driver lists the extension, the list is read once
+	bool has(const char* name);
+
+	// address of an extension function, null if the driver doesn't have it
+	void* getProcAddress(const char* name);
+}
\ No newline at end of file
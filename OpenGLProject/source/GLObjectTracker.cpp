@@ -0,0 +1,90 @@
+#include "GLObjectTracker.h"
+#include <iostream>
+
+GLObjectTracker& GLObjectTracker::getInstance()
+{
+	static GLObjectTracker instance;
+	return instance;
+}
+
+// the tracker is destroyed after the application so anything left alive has leaked
+GLObjectTracker::~GLObjectTracker()
+{
+	reportLeaks();
+}
+
+// record a newly generated GL object
+void GLObjectTracker::created(GLObjectType type, unsigned int handle, const char* owner)
+{
+	// 0 is never a real object
+	if (handle == 0)
+	{
+		return;
+	}
+
+	auto result = m_liveObjects.insert(std::make_pair(std::make_pair(type, handle), owner));
+
+	if (!result.second)
+	{
+		std::cout << typeName(type) << " " << handle << " created by " << owner << " is already owned by " << result.first->second << std::endl;
+	}
+}
+
+// remove a deleted GL object, deleting one that isn't alive is a double delete
+void GLObjectTracker::deleted(GLObjectType type, unsigned int handle)
+{
+	// deleting 0 is a no-op in GL
+	if (handle == 0)
+	{
+		return;
+	}
+
+	auto iter = m_liveObjects.find(std::make_pair(type, handle));
+
+	if (iter == m_liveObjects.end())
+	{
+		std::cout << "Double delete (or delete of an untracked object) of " << typeName(type) << " " << handle << std::endl;
+		return;
+	}
+
+	m_liveObjects.erase(iter);
+}
+
+// print every object that is still alive
+void GLObjectTracker::reportLeaks() const
+{
+	if (m_liveObjects.empty())
+	{
+		return;
+	}
+
+	std::cout << m_liveObjects.size() << " GL object(s) leaked:" << std::endl;
+
+	for (auto& object : m_liveObjects)
+	{
+		std::cout << "\t" << typeName(object.first.first) << " " << object.first.second << " owned by " << object.second << std::endl;
+	}
+}
+
+const char* GLObjectTracker::typeName(GLObjectType type)
+{
+	switch (type)
+	{
+	case GLObjectType::Buffer:
+		return "buffer";
+	case GLObjectType::VertexArray:
+		return "vertex array";
+	case GLObjectType::Texture:
+		return "texture";
+	case GLObjectType::Framebuffer:
+		return "framebuffer";
+	case GLObjectType::Renderbuffer:
+		return "renderbuffer";
+	case GLObjectType::Program:
+		return "program";
+	case GLObjectType::Sampler:
+		return "sampler";
+	default:
+		return "object";
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <map>
+#include <utility>
+
+// kinds of GL object that are tracked
+enum class GLObjectType
+{
+	Buffer,
+	VertexArray,
+	Texture,
+	Framebuffer,
+	Renderbuffer,
+	Program,
+	Sampler
+};
+
+// debug only record of every live GL object, reports double deletes as they happen and leaks at shutdown
+class GLObjectTracker
+{
+public:
+
+	static GLObjectTracker& getInstance();
+
+	void created(GLObjectType type, unsigned int handle, const char* owner);
+	void deleted(GLObjectType type, unsigned int handle);
+
+	// print every object that is still alive
+	void reportLeaks() const;
+
+private:
+
+	GLObjectTracker() {};
+	~GLObjectTracker();
+
+	static const char* typeName(GLObjectType type);
+
+	// owner of each live object keyed by type and handle
+	std::map<std::pair<GLObjectType, unsigned int>, const char*> m_liveObjects;
+};
+
+// tracking compiles away unless GL_OBJECT_TRACKING is defined (debug configurations)
+#ifdef GL_OBJECT_TRACKING
+#define GL_TRACK_CREATED(type, handle, owner) GLObjectTracker::getInstance().created(type, handle, owner)
+#define GL_TRACK_DELETED(type, handle) GLObjectTracker::getInstance().deleted(type, handle)
+#else
+#define GL_TRACK_CREATED(type, handle, owner)
+#define GL_TRACK_DELETED(type, handle)
+#endif
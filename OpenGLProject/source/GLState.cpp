@@ -0,0 +1,250 @@
+#include "GLState.h"
+#include "RenderStats.h"
+
+GLState& GLState::getInstance()
+{
+	static GLState instance;
+	return instance;
+}
+
+GLState::GLState()
+{
+	invalidate();
+}
+
+void GLState::useProgram(unsigned int program)
+{
+	if (change(m_program, program))
+	{
+		RenderStats::getInstance().current().programBinds++;
+		glUseProgram(program);
+	}
+}
+
+void GLState::bindVertexArray(unsigned int vao)
+{
+	if (change(m_vertexArray, vao))
+	{
+		RenderStats::getInstance().current().vertexArrayBinds++;
+		glBindVertexArray(vao);
+	}
+}
+
+void GLState::bindFramebuffer(unsigned int fbo)
+{
+	if (change(m_framebuffer, fbo))
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	}
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+	int index = targetIndex(target);
+
+	// bindings of untracked targets / units always go through
+	if (index < 0 || unit >= MaxTextureUnits)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		m_activeTextureUnit = unit;
+		RenderStats::getInstance().current().textureBinds++;
+		return;
+	}
+
+	if (change(m_textures[unit][index], texture))
+	{
+		// the active unit only matters when a bind is actually issued
+		if (change(m_activeTextureUnit, unit))
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+		}
+
+		RenderStats::getInstance().current().textureBinds++;
+		glBindTexture(target, texture);
+	}
+}
+
+// samplers are bound to units directly, no active unit involved
+void GLState::bindSampler(unsigned int unit, unsigned int sampler)
+{
+	if (unit >= MaxTextureUnits)
+	{
+		glBindSampler(unit, sampler);
+		RenderStats::getInstance().current().samplerBinds++;
+		return;
+	}
+
+	if (change(m_samplers[unit], sampler))
+	{
+		RenderStats::getInstance().current().samplerBinds++;
+		glBindSampler(unit, sampler);
+	}
+}
+
+void GLState::setDepthTest(bool enabled)
+{
+	setCapability(GL_DEPTH_TEST, m_depthTest, enabled);
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+	if (change(m_depthFunc, func))
+	{
+		glDepthFunc(func);
+	}
+}
+
+void GLState::setCullFace(bool enabled)
+{
+	setCapability(GL_CULL_FACE, m_cullFace, enabled);
+}
+
+void GLState::setBlend(bool enabled)
+{
+	setCapability(GL_BLEND, m_blend, enabled);
+}
+
+void GLState::setBlendFunc(GLenum source, GLenum destination)
+{
+	// evaluate both so the cache always ends up holding the pair that was set
+	bool sourceChanged = change(m_blendSource, source);
+	bool destinationChanged = change(m_blendDestination, destination);
+
+	if (sourceChanged || destinationChanged)
+	{
+		glBlendFunc(source, destination);
+	}
+}
+
+void GLState::setPolygonMode(GLenum mode)
+{
+	if (change(m_polygonMode, mode))
+	{
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+}
+
+// a deleted program stays in use until another one is bound, so just stop trusting the cache
+void GLState::programDeleted(unsigned int program)
+{
+	if (m_program == program)
+	{
+		m_program = Unknown;
+	}
+}
+
+// deleting the bound vertex array binds 0
+void GLState::vertexArrayDeleted(unsigned int vao)
+{
+	if (m_vertexArray == vao)
+	{
+		m_vertexArray = 0;
+	}
+}
+
+// deleting the bound framebuffer binds the default framebuffer
+void GLState::framebufferDeleted(unsigned int fbo)
+{
+	if (m_framebuffer == fbo)
+	{
+		m_framebuffer = 0;
+	}
+}
+
+// deleting a texture unbinds it from every unit
+void GLState::textureDeleted(unsigned int texture)
+{
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+	{
+		for (int target = 0; target < TextureTargetCount; target++)
+		{
+			if (m_textures[unit][target] == texture)
+			{
+				m_textures[unit][target] = 0;
+			}
+		}
+	}
+}
+
+// deleting a sampler unbinds it from every unit
+void GLState::samplerDeleted(unsigned int sampler)
+{
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+	{
+		if (m_samplers[unit] == sampler)
+		{
+			m_samplers[unit] = 0;
+		}
+	}
+}
+
+// forget everything, for use after code that talks to GL directly
+void GLState::invalidate()
+{
+	m_program = Unknown;
+	m_vertexArray = Unknown;
+	m_framebuffer = Unknown;
+	m_activeTextureUnit = Unknown;
+
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+	{
+		for (int target = 0; target < TextureTargetCount; target++)
+		{
+			m_textures[unit][target] = Unknown;
+		}
+
+		m_samplers[unit] = Unknown;
+	}
+
+	m_depthTest = Unknown;
+	m_depthFunc = Unknown;
+	m_cullFace = Unknown;
+	m_blend = Unknown;
+	m_blendSource = Unknown;
+	m_blendDestination = Unknown;
+	m_polygonMode = Unknown;
+}
+
+bool GLState::change(unsigned int& cached, unsigned int value)
+{
+	if (cached == value)
+	{
+		RenderStats::getInstance().current().redundantStateCalls++;
+		return false;
+	}
+
+	cached = value;
+	RenderStats::getInstance().current().stateCalls++;
+	return true;
+}
+
+int GLState::targetIndex(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:
+		return Texture2D;
+	case GL_TEXTURE_CUBE_MAP:
+		return TextureCubeMap;
+	case GL_TEXTURE_2D_ARRAY:
+		return Texture2DArray;
+	default:
+		return -1;
+	}
+}
+
+void GLState::setCapability(GLenum capability, unsigned int& cached, bool enabled)
+{
+	if (change(cached, enabled ? 1 : 0))
+	{
+		if (enabled)
+		{
+			glEnable(capability);
+		}
+		else
+		{
+			glDisable(capability);
+		}
+	}
+}
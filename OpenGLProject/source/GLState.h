@@ -0,0 +1,77 @@
+#pragma once
+#include <glad\glad.h>
+
+// singleton shadow of the GL binding / fixed function state
+// every bind goes through here so calls that wouldn't change anything never reach the driver
+class GLState
+{
+public:
+
+	static const unsigned int MaxTextureUnits = 16;
+
+	static GLState& getInstance();
+
+	// objects
+	void useProgram(unsigned int program);
+	void bindVertexArray(unsigned int vao);
+	void bindFramebuffer(unsigned int fbo);
+	void bindTexture(unsigned int unit, GLenum target, unsigned int texture);
+	void bindSampler(unsigned int unit, unsigned int sampler);
+
+	// fixed function state
+	void setDepthTest(bool enabled);
+	void setDepthFunc(GLenum func);
+	void setCullFace(bool enabled);
+	void setBlend(bool enabled);
+	void setBlendFunc(GLenum source, GLenum destination);
+	void setPolygonMode(GLenum mode);
+
+	// GL unbinds deleted objects, so forget them too (otherwise a recycled name would look bound)
+	void programDeleted(unsigned int program);
+	void vertexArrayDeleted(unsigned int vao);
+	void framebufferDeleted(unsigned int fbo);
+	void textureDeleted(unsigned int texture);
+	void samplerDeleted(unsigned int sampler);
+
+	// forget everything, for use after code that talks to GL directly
+	void invalidate();
+
+private:
+
+	GLState();
+	~GLState() {};
+
+	// returns true (and counts the call) if the cached value has to change, otherwise counts a redundant call
+	bool change(unsigned int& cached, unsigned int value);
+
+	// texture targets with a cached binding per unit
+	enum TextureTarget
+	{
+		Texture2D,
+		TextureCubeMap,
+		Texture2DArray,
+		TextureTargetCount
+	};
+
+	static int targetIndex(GLenum target);
+
+	void setCapability(GLenum capability, unsigned int& cached, bool enabled);
+
+	// value that never matches a real GL value so the first call always goes through
+	static const unsigned int Unknown = 0xFFFFFFFF;
+
+	unsigned int m_program = Unknown;
+	unsigned int m_vertexArray = Unknown;
+	unsigned int m_framebuffer = Unknown;
+	unsigned int m_activeTextureUnit = Unknown;
+	unsigned int m_textures[MaxTextureUnits][TextureTargetCount];
+	unsigned int m_samplers[MaxTextureUnits];
+
+	unsigned int m_depthTest = Unknown;
+	unsigned int m_depthFunc = Unknown;
+	unsigned int m_cullFace = Unknown;
+	unsigned int m_blend = Unknown;
+	unsigned int m_blendSource = Unknown;
+	unsigned int m_blendDestination = Unknown;
+	unsigned int m_polygonMode = Unknown;
+};
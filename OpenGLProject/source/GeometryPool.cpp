@@ -0,0 +1,257 @@
+#include "GeometryPool.h"
+#include <glad\glad.h>
+#include <algorithm>
+#include "GLObjectTracker.h"
+#include "GLState.h"
+
+// starting sizes, the buffers grow when they fill up
+static const size_t InitialVertexCapacity = 64 * 1024;
+static const size_t InitialIndexCapacity = 256 * 1024;
+static const size_t InitialDrawIDCapacity = 1024;
+
+GeometryPool::~GeometryPool()
+{
+	if (m_vao != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::VertexArray, m_vao);
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_vbo);
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_ibo);
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_drawIDs);
+
+		GLState::getInstance().vertexArrayDeleted(m_vao);
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ibo);
+		glDeleteBuffers(1, &m_drawIDs);
+	}
+}
+
+// copy the vertices / indices into the pool, indices stay relative to the first vertex
+GeometryAllocation GeometryPool::allocate(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	VertexLayout::get(m_format).pack(vertices, vertexCount, m_packed);
+
+	return allocatePacked(m_packed.data(), vertexCount, indices, indexCount);
+}
+
+// copy vertices that are already in the pool's vertex format into the pool
+GeometryAllocation GeometryPool::allocatePacked(const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	if (m_vao == 0)
+	{
+		create();
+	}
+
+	size_t stride = VertexLayout::get(m_format).getStride();
+
+	size_t vertexOffset = 0;
+	if (!allocateRange(m_freeVertices, m_vertexEnd, m_vertexCapacity, vertexCount, vertexOffset))
+	{
+		size_t capacity = std::max(m_vertexCapacity + m_vertexCapacity / 2, m_vertexEnd + vertexCount);
+		grow(m_vbo, m_vertexEnd * stride, capacity * stride);
+		m_vertexCapacity = capacity;
+
+		// the vertex array has to point at the new buffer
+		GLState::getInstance().bindVertexArray(m_vao);
+		glBindVertexBuffer(0, m_vbo, 0, (GLsizei)stride);
+
+		allocateRange(m_freeVertices, m_vertexEnd, m_vertexCapacity, vertexCount, vertexOffset);
+	}
+
+	size_t indexOffset = 0;
+	if (!allocateRange(m_freeIndices, m_indexEnd, m_indexCapacity, indexCount, indexOffset))
+	{
+		size_t capacity = std::max(m_indexCapacity + m_indexCapacity / 2, m_indexEnd + indexCount);
+		grow(m_ibo, m_indexEnd * sizeof(unsigned int), capacity * sizeof(unsigned int));
+		m_indexCapacity = capacity;
+
+		GLState::getInstance().bindVertexArray(m_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+
+		allocateRange(m_freeIndices, m_indexEnd, m_indexCapacity, indexCount, indexOffset);
+	}
+
+	// upload through the copy target so the element array binding of whatever vertex array is bound isn't touched
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * stride, vertexCount * stride, vertices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_ibo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GeometryAllocation allocation;
+	allocation.baseVertex = (unsigned int)vertexOffset;
+	allocation.vertexCount = (unsigned int)vertexCount;
+	allocation.firstIndex = (unsigned int)indexOffset;
+	allocation.indexCount = (unsigned int)indexCount;
+
+	return allocation;
+}
+
+// give the space back so later allocations can reuse it
+void GeometryPool::free(const GeometryAllocation& allocation)
+{
+	freeRange(m_freeVertices, m_vertexEnd, allocation.baseVertex, allocation.vertexCount);
+	freeRange(m_freeIndices, m_indexEnd, allocation.firstIndex, allocation.indexCount);
+}
+
+// make sure draw ids 0..count-1 can be fetched by the draw id attribute
+void GeometryPool::reserveDrawIDs(size_t count)
+{
+	if (m_vao == 0)
+	{
+		create();
+	}
+
+	if (count <= m_drawIDCapacity)
+	{
+		return;
+	}
+
+	m_drawIDCapacity = std::max(m_drawIDCapacity * 2, count);
+
+	std::vector<unsigned int> ids(m_drawIDCapacity);
+	for (size_t i = 0; i < ids.size(); i++)
+	{
+		ids[i] = (unsigned int)i;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_drawIDs);
+	glBufferData(GL_COPY_WRITE_BUFFER, ids.size() * sizeof(unsigned int), ids.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// first fit search of the free list, then the end of the buffer
+bool GeometryPool::allocateRange(std::vector<Range>& freeRanges, size_t& end, size_t capacity, size_t count, size_t& offset)
+{
+	for (size_t i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].count >= count)
+		{
+			offset = freeRanges[i].offset;
+			freeRanges[i].offset += count;
+			freeRanges[i].count -= count;
+
+			if (freeRanges[i].count == 0)
+			{
+				freeRanges.erase(freeRanges.begin() + i);
+			}
+
+			return true;
+		}
+	}
+
+	if (end + count <= capacity)
+	{
+		offset = end;
+		end += count;
+		return true;
+	}
+
+	return false;
+}
+
+void GeometryPool::freeRange(std::vector<Range>& freeRanges, size_t& end, size_t offset, size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// keep the list sorted by offset so neighbouring holes can be merged
+	auto position = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset, [](const Range& range, size_t value)
+	{
+		return range.offset < value;
+	});
+
+	Range range = { offset, count };
+	position = freeRanges.insert(position, range);
+
+	// merge with the following hole
+	auto next = position + 1;
+	if (next != freeRanges.end() && position->offset + position->count == next->offset)
+	{
+		position->count += next->count;
+		freeRanges.erase(next);
+	}
+
+	// merge with the previous hole
+	if (position != freeRanges.begin())
+	{
+		auto previous = position - 1;
+		if (previous->offset + previous->count == position->offset)
+		{
+			previous->count += position->count;
+			position = freeRanges.erase(position) - 1;
+		}
+	}
+
+	// a hole at the end just moves the end back
+	if (position->offset + position->count == end)
+	{
+		end = position->offset;
+		freeRanges.erase(position);
+	}
+}
+
+void GeometryPool::create()
+{
+	m_vertexCapacity = InitialVertexCapacity;
+	m_indexCapacity = InitialIndexCapacity;
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
+	glGenBuffers(1, &m_ibo);
+	glGenBuffers(1, &m_drawIDs);
+	GL_TRACK_CREATED(GLObjectType::VertexArray, m_vao, "GeometryPool");
+	GL_TRACK_CREATED(GLObjectType::Buffer, m_vbo, "GeometryPool");
+	GL_TRACK_CREATED(GLObjectType::Buffer, m_ibo, "GeometryPool");
+	GL_TRACK_CREATED(GLObjectType::Buffer, m_drawIDs, "GeometryPool");
+
+	GLState::getInstance().bindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, m_vertexCapacity * VertexLayout::get(m_format).getStride(), nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+	// the vertex format is separate from the buffer so the buffer can be swapped when it grows
+	const VertexLayout& layout = VertexLayout::get(m_format);
+	layout.apply(0);
+	glBindVertexBuffer(0, m_vbo, 0, layout.getStride());
+
+	// one id per instance, so a draw with baseInstance = n reads id n
+	glEnableVertexAttribArray(DrawIDAttribute);
+	glVertexAttribIFormat(DrawIDAttribute, 1, GL_UNSIGNED_INT, 0);
+	glVertexAttribBinding(DrawIDAttribute, 1);
+	glVertexBindingDivisor(1, 1);
+
+	glBindVertexBuffer(1, m_drawIDs, 0, sizeof(unsigned int));
+
+	GLState::getInstance().bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	reserveDrawIDs(InitialDrawIDCapacity);
+}
+
+// move the contents of a buffer into a bigger one
+void GeometryPool::grow(unsigned int& buffer, size_t usedBytes, size_t newBytes)
+{
+	unsigned int bigger = 0;
+	glGenBuffers(1, &bigger);
+	GL_TRACK_CREATED(GLObjectType::Buffer, bigger, "GeometryPool");
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GL_TRACK_DELETED(GLObjectType::Buffer, buffer);
+	glDeleteBuffers(1, &buffer);
+	buffer = bigger;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include "Vertex.h"
+#include "VertexLayout.h"
+
+// where a mesh's vertices / indices live inside a geometry pool
+struct GeometryAllocation
+{
+	unsigned int baseVertex = 0;
+	unsigned int vertexCount = 0;
+	unsigned int firstIndex = 0;
+	unsigned int indexCount = 0;
+};
+
+// large shared vertex / index buffers that many meshes are suballocated from
+// everything in the pool is drawn with one vertex array, so meshes can be batched without vertex array switches
+class GeometryPool
+{
+public:
+
+	// vertex attribute holding the index of a multi draw (fed through baseInstance, see MultiDrawQueue)
+	static const unsigned int DrawIDAttribute = 5;
+
+	// every mesh in the pool is stored in the same vertex format
+	GeometryPool(VertexFormat format = VertexFormat::Full) : m_format(format) {};
+	~GeometryPool();
+
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator = (const GeometryPool&) = delete;
+
+	// copy the vertices / indices into the pool, indices stay relative to the first vertex
+	GeometryAllocation allocate(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+
+	// same but the vertices are already in the pool's vertex format (e.g. from a mesh cache)
+	GeometryAllocation allocatePacked(const void* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+
+	// give the space back so later allocations can reuse it
+	void free(const GeometryAllocation& allocation);
+
+	// make sure draw ids 0..count-1 can be fetched by the draw id attribute
+	void reserveDrawIDs(size_t count);
+
+	unsigned int getVertexArray() const { return m_vao; }
+	VertexFormat getFormat() const { return m_format; }
+
+	size_t getVertexCapacity() const { return m_vertexCapacity; }
+	size_t getIndexCapacity() const { return m_indexCapacity; }
+
+private:
+
+	// range of free space in one of the buffers (in elements)
+	struct Range
+	{
+		size_t offset;
+		size_t count;
+	};
+
+	// first fit search of the free list, then the end of the buffer
+	static bool allocateRange(std::vector<Range>& freeRanges, size_t& end, size_t capacity, size_t count, size_t& offset);
+	static void freeRange(std::vector<Range>& freeRanges, size_t& end, size_t offset, size_t count);
+
+	void create();
+
+	// move the contents of a buffer into a bigger one
+	static void grow(unsigned int& buffer, size_t usedBytes, size_t newBytes);
+
+	VertexFormat m_format;
+
+	// vertices converted to the pool's layout before upload
+	std::vector<unsigned char> m_packed;
+
+	unsigned int m_vao = 0;
+	unsigned int m_vbo = 0;
+	unsigned int m_ibo = 0;
+	unsigned int m_drawIDs = 0;
+
+	size_t m_vertexCapacity = 0;
+	size_t m_indexCapacity = 0;
+	size_t m_drawIDCapacity = 0;
+
+	// everything past the end is free, the free lists hold the holes before it
+	size_t m_vertexEnd = 0;
+	size_t m_indexEnd = 0;
+	std::vector<Range> m_freeVertices;
+	std::vector<Range> m_freeIndices;
+};
@@ -12,7 +12,12 @@ void Input::update()
 	for (auto iter = m_keyStates.begin(); iter != m_keyStates.end(); iter++)
 	{
 		iter->second.previous = iter->second.current;
-		iter->second.current = glfwGetKey(m_window, iter->first);
+
+		// mouse buttons share the map, their codes are below every key's
+		if (iter->first <= GLFW_MOUSE_BUTTON_LAST)
+			iter->second.current = glfwGetMouseButton(m_window, iter->first) == GLFW_PRESS;
+		else
+			iter->second.current = glfwGetKey(m_window, iter->first) == GLFW_PRESS;
 	}
 }
 
@@ -0,0 +1,41 @@
+#include "InstanceBuffer.h"
+#include <glad\glad.h>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (m_buffer != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+}
+
+// copy the transforms into the buffer and bind it to the instance binding point
+void InstanceBuffer::upload(const glm::mat4* transforms, size_t count)
+{
+	if (m_buffer == 0)
+	{
+		glGenBuffers(1, &m_buffer);
+		GL_TRACK_CREATED(GLObjectType::Buffer, m_buffer, "InstanceBuffer");
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+
+	// grow with some headroom so a slowly growing instance count doesn't need a bigger size every frame
+	if (count > m_capacity)
+	{
+		m_capacity = count + count / 2;
+	}
+
+	// always respecify the storage, this orphans the old one so a draw still reading it doesn't stall the upload
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(glm::mat4), transforms);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::Instances, m_buffer);
+
+	m_count = count;
+}
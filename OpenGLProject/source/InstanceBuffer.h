@@ -0,0 +1,26 @@
+#pragma once
+#include <glm\glm.hpp>
+
+// per instance model matrices for instanced draws
+// stored in a shader storage buffer, the instanced vertex shaders index it with gl_InstanceID
+class InstanceBuffer
+{
+public:
+
+	InstanceBuffer() {};
+	~InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator = (const InstanceBuffer&) = delete;
+
+	// copy the transforms into the buffer and bind it to the instance binding point
+	void upload(const glm::mat4* transforms, size_t count);
+
+	size_t getCount() const { return m_count; }
+
+private:
+
+	unsigned int m_buffer = 0;
+	size_t m_capacity = 0; // in instances
+	size_t m_count = 0;
+};
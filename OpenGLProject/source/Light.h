@@ -1,12 +1,37 @@
 #pragma once
-#include <glm\vec3.hpp>
-#include "Shader.h"
+#include <glm\glm.hpp>
+#include <cmath>
+
+// std430 layouts of the lights in the light buffers (see phong.fs / pbr.fs)
+struct GPUDirectionalLight
+{
+	glm::vec4 direction;
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+};
+
+struct GPUPointLight
+{
+	glm::vec4 position; // w = falloff distance
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+};
+
+struct GPUSpotLight
+{
+	glm::vec4 position; // w = falloff distance
+	glm::vec4 direction;
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+	glm::vec4 cosAngles; // x = cos(theta), y = cos(phi)
+};
 
 // generic Light struct
 struct Light
 {
-	virtual void bind(Shader shader, int index) = 0;
-
 	glm::vec3 ambient = glm::vec3(1);
 	glm::vec3 diffuse = glm::vec3(1);
 	glm::vec3 specular = glm::vec3(1);
@@ -15,12 +40,15 @@ struct Light
 // directional light
 struct DirectionalLight : public Light
 {
-	virtual void bind(Shader shader, int index)
+	// convert to the layout used by the light buffer
+	GPUDirectionalLight pack() const
 	{
-		shader.setVec3(std::string("directionalLights[" + std::to_string(index) + "].ambient").c_str(), ambient);
-		shader.setVec3(std::string("directionalLights[" + std::to_string(index) + "].diffuse").c_str(), diffuse);
-		shader.setVec3(std::string("directionalLights[" + std::to_string(index) + "].specular").c_str(), specular);
-		shader.setVec3(std::string("directionalLights[" + std::to_string(index) + "].direction").c_str(), direction);
+		GPUDirectionalLight packed;
+		packed.direction = glm::vec4(direction, 0);
+		packed.ambient = glm::vec4(ambient, 1);
+		packed.diffuse = glm::vec4(diffuse, 1);
+		packed.specular = glm::vec4(specular, 1);
+		return packed;
 	}
 
 	glm::vec3 direction = glm::vec3(0, -1, 0);
@@ -29,13 +57,15 @@ struct DirectionalLight : public Light
 // point light
 struct PointLight : public Light
 {
-	virtual void bind(Shader shader, int index)
+	// convert to the layout used by the light buffer
+	GPUPointLight pack() const
 	{
-		shader.setVec3(std::string("pointLights[" + std::to_string(index) + "].ambient").c_str(), ambient);
-		shader.setVec3(std::string("pointLights[" + std::to_string(index) + "].diffuse").c_str(), diffuse);
-		shader.setVec3(std::string("pointLights[" + std::to_string(index) + "].specular").c_str(), specular);
-		shader.setVec3(std::string("pointLights[" + std::to_string(index) + "].position").c_str(), position);
-		shader.setFloat(std::string("pointLights[" + std::to_string(index) + "].falloffDistance").c_str(), falloffDistance);
+		GPUPointLight packed;
+		packed.position = glm::vec4(position, falloffDistance);
+		packed.ambient = glm::vec4(ambient, 1);
+		packed.diffuse = glm::vec4(diffuse, 1);
+		packed.specular = glm::vec4(specular, 1);
+		return packed;
 	}
 
 	glm::vec3 position = glm::vec3(0);
@@ -45,19 +75,22 @@ struct PointLight : public Light
 // spot light
 struct SpotLight : public Light
 {
-	virtual void bind(Shader shader, int index)
+	// convert to the layout used by the light buffer
+	GPUSpotLight pack() const
 	{
-		shader.setVec3(std::string("spotLights[" + std::to_string(index) + "].ambient").c_str(), ambient);
-		shader.setVec3(std::string("spotLights[" + std::to_string(index) + "].diffuse").c_str(), diffuse);
-		shader.setVec3(std::string("spotLights[" + std::to_string(index) + "].specular").c_str(), specular);
-		shader.setVec3(std::string("spotLights[" + std::to_string(index) + "].position").c_str(), position);
-		shader.setFloat(std::string("spotLights[" + std::to_string(index) + "].falloffDistance").c_str(), falloffDistance);
-		shader.setFloat(std::string("spotLights[" + std::to_string(index) + "].theta").c_str(), theta);
-		shader.setFloat(std::string("spotLights[" + std::to_string(index) + "].phi").c_str(), phi);
+		GPUSpotLight packed;
+		packed.position = glm::vec4(position, falloffDistance);
+		packed.direction = glm::vec4(direction, 0);
+		packed.ambient = glm::vec4(ambient, 1);
+		packed.diffuse = glm::vec4(diffuse, 1);
+		packed.specular = glm::vec4(specular, 1);
+		packed.cosAngles = glm::vec4(std::cos(theta), std::cos(phi), 0, 0);
+		return packed;
 	}
 
 	glm::vec3 position = glm::vec3(0);
+	glm::vec3 direction = glm::vec3(0, -1, 0);
 	float falloffDistance = 10.0f;
-	float theta = glm::radians(30.0f);
-	float phi = glm::radians(60.0f);
-};
\ No newline at end of file
+	float theta = glm::radians(30.0f); // inner cone angle
+	float phi = glm::radians(60.0f); // outer cone angle
+};
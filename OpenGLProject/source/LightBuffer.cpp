@@ -0,0 +1,111 @@
+#include "LightBuffer.h"
+#include <glad\glad.h>
+#include <algorithm>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+
+LightBuffer::~LightBuffer()
+{
+	if (m_buffer != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+}
+
+size_t LightBuffer::addDirectionalLight(const DirectionalLight& light)
+{
+	m_directionalLights.push_back(light);
+	m_dirty = true;
+	return m_directionalLights.size() - 1;
+}
+
+size_t LightBuffer::addPointLight(const PointLight& light)
+{
+	m_pointLights.push_back(light);
+	m_dirty = true;
+	return m_pointLights.size() - 1;
+}
+
+size_t LightBuffer::addSpotLight(const SpotLight& light)
+{
+	m_spotLights.push_back(light);
+	m_dirty = true;
+	return m_spotLights.size() - 1;
+}
+
+// remove every light
+void LightBuffer::clear()
+{
+	m_directionalLights.clear();
+	m_pointLights.clear();
+	m_spotLights.clear();
+	m_dirty = true;
+}
+
+// upload and bind the lights if anything changed since the last update
+void LightBuffer::update()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+
+	if (m_buffer == 0)
+	{
+		glGenBuffers(1, &m_buffer);
+		GL_TRACK_CREATED(GLObjectType::Buffer, m_buffer, "LightBuffer");
+
+		GLint alignment = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		m_offsetAlignment = alignment > 0 ? (size_t)alignment : 16;
+	}
+
+	// pack every light type one after the other
+	m_packed.clear();
+	size_t directionalOffset = packBlock<GPUDirectionalLight>(m_directionalLights);
+	size_t pointOffset = packBlock<GPUPointLight>(m_pointLights);
+	size_t spotOffset = packBlock<GPUSpotLight>(m_spotLights);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+
+	// grow the buffer with some headroom so adding a few lights doesn't reallocate every time
+	if (m_packed.size() > m_capacity)
+	{
+		m_capacity = m_packed.size() + m_packed.size() / 2;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_packed.size(), m_packed.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// binding points are global state so they only need to change when the layout does
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::DirectionalLights, m_buffer,
+		directionalOffset, pointOffset - directionalOffset);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::PointLights, m_buffer,
+		pointOffset, spotOffset - pointOffset);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::SpotLights, m_buffer,
+		spotOffset, m_packed.size() - spotOffset);
+
+	m_dirty = false;
+}
+
+// append one std430 "Light lights[];" block to the packed data, returns its offset
+// the light counts live in the FrameConstants block
+template<typename Packed, typename LightType>
+size_t LightBuffer::packBlock(const std::vector<LightType>& lights)
+{
+	// every block has to start on the binding offset alignment
+	size_t offset = (m_packed.size() + m_offsetAlignment - 1) / m_offsetAlignment * m_offsetAlignment;
+
+	// always leave room for one light as binding an empty range is an error
+	m_packed.resize(offset + std::max(lights.size(), (size_t)1) * sizeof(Packed), 0);
+
+	Packed* packedLights = (Packed*)&m_packed[offset];
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		packedLights[i] = lights[i].pack();
+	}
+
+	return offset;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include "Light.h"
+
+// owns every light in the scene and mirrors them into shader storage buffers
+// all lights are packed into one contiguous array and uploaded with a single call, only when they change
+class LightBuffer
+{
+public:
+
+	LightBuffer() {};
+	~LightBuffer();
+
+	LightBuffer(const LightBuffer&) = delete;
+	LightBuffer& operator = (const LightBuffer&) = delete;
+
+	// add lights, returning their index
+	size_t addDirectionalLight(const DirectionalLight& light);
+	size_t addPointLight(const PointLight& light);
+	size_t addSpotLight(const SpotLight& light);
+
+	// modifiable access marks the buffer as changed
+	DirectionalLight& getDirectionalLight(size_t index) { m_dirty = true; return m_directionalLights[index]; }
+	PointLight& getPointLight(size_t index) { m_dirty = true; return m_pointLights[index]; }
+	SpotLight& getSpotLight(size_t index) { m_dirty = true; return m_spotLights[index]; }
+
+	const DirectionalLight& getDirectionalLight(size_t index) const { return m_directionalLights[index]; }
+	const PointLight& getPointLight(size_t index) const { return m_pointLights[index]; }
+	const SpotLight& getSpotLight(size_t index) const { return m_spotLights[index]; }
+
+	size_t getDirectionalLightCount() const { return m_directionalLights.size(); }
+	size_t getPointLightCount() const { return m_pointLights.size(); }
+	size_t getSpotLightCount() const { return m_spotLights.size(); }
+
+	void clear();
+
+	// upload and bind the lights if anything changed since the last update
+	void update();
+
+private:
+
+	// append one std430 "Light lights[];" block to the packed data
+	template<typename Packed, typename LightType>
+	size_t packBlock(const std::vector<LightType>& lights);
+
+	std::vector<DirectionalLight> m_directionalLights;
+	std::vector<PointLight> m_pointLights;
+	std::vector<SpotLight> m_spotLights;
+
+	// CPU copy of the buffer contents
+	std::vector<unsigned char> m_packed;
+
+	unsigned int m_buffer = 0;
+	size_t m_capacity = 0;
+	size_t m_offsetAlignment = 0;
+	bool m_dirty = true;
+};
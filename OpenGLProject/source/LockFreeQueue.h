@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+// unbounded queue any number of threads can push to without locking, only one thread may pop
+// (a linked list where producers swap in the new head and the consumer walks from the tail)
+template<typename T>
+class LockFreeQueue
+{
+public:
+
+	LockFreeQueue()
+	{
+		Node* stub = new Node();
+		m_head.store(stub);
+		m_tail = stub;
+	}
+
+	~LockFreeQueue()
+	{
+		while (m_tail != nullptr)
+		{
+			Node* next = m_tail->next.load();
+			delete m_tail;
+			m_tail = next;
+		}
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator = (const LockFreeQueue&) = delete;
+
+	// any thread
+	void push(T value)
+	{
+		Node* node = new Node();
+		node->value = std::move(value);
+
+		// the previous head is only linked to the new node after the swap, until then the consumer just sees the queue end early
+		Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	// consumer thread only, false if there is nothing (visible) to pop
+	bool tryPop(T& value)
+	{
+		Node* next = m_tail->next.load(std::memory_order_acquire);
+		if (next == nullptr)
+		{
+			return false;
+		}
+
+		// the popped node becomes the new stub
+		value = std::move(next->value);
+		next->value = T();
+
+		delete m_tail;
+		m_tail = next;
+		return true;
+	}
+
+private:
+
+	struct Node
+	{
+		std::atomic<Node*> next{ nullptr };
+		T value;
+	};
+
+	std::atomic<Node*> m_head;
+	Node* m_tail;
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+// take over another file's mapping
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	m_data(other.m_data),
+	m_size(other.m_size)
+#ifdef _WIN32
+	, m_file(other.m_file),
+	m_mapping(other.m_mapping)
+#endif
+{
+	other.m_data = nullptr;
+	other.m_size = 0;
+#ifdef _WIN32
+	other.m_file = nullptr;
+	other.m_mapping = nullptr;
+#endif
+}
+
+// unmap this file and take over another one's mapping
+MappedFile& MappedFile::operator = (MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+
+		m_data = other.m_data;
+		m_size = other.m_size;
+		other.m_data = nullptr;
+		other.m_size = 0;
+#ifdef _WIN32
+		m_file = other.m_file;
+		m_mapping = other.m_mapping;
+		other.m_file = nullptr;
+		other.m_mapping = nullptr;
+#endif
+	}
+
+	return *this;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = (const unsigned char*)view;
+	m_size = (size_t)size.QuadPart;
+#else
+	int file = ::open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// the mapping stays valid after the descriptor is closed
+	::close(file);
+
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_data = (const unsigned char*)view;
+	m_size = (size_t)info.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	CloseHandle(m_file);
+	m_file = nullptr;
+	m_mapping = nullptr;
+#else
+	munmap((void*)m_data, m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+// read only memory mapping of a whole file, the contents are paged in by the OS on first touch
+class MappedFile
+{
+public:
+
+	MappedFile() {};
+	~MappedFile();
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator = (MappedFile&& other) noexcept;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+
+	const unsigned char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,16 @@
+#include "Material.h"
+#include "MaterialTable.h"
+
+// point a shader at the material's entry in the material table and bind its textures
+void Material::bind(const Shader& shader) const
+{
+	MaterialTable& table = MaterialTable::getInstance();
+
+	// queues add every material before drawing, so this is normally just a lookup
+	unsigned int index = table.add(*this);
+	table.upload();
+
+	shader.set(MaterialUniform::index, (int)index);
+
+	bindTextures();
+}
\ No newline at end of file
@@ -1,10 +1,64 @@
 #pragma once
 #include <glm\glm.hpp>
-#include "Texture.h"
+#include "TextureCache.h"
 #include "Shader.h"
+#include "GLState.h"
+#include "SamplerCache.h"
 
+// material uniform names, hashed at compile time
+namespace MaterialUniform
+{
+	// the material's entry in the frame's material table (see MaterialTable)
+	constexpr UniformID index("materialIndex");
+}
+
+// optional parts of the material shaders, worked out from the material when it's loaded
+// the forward shaders compile a permutation per combination (see MaterialShader), the indirect ones branch on them
+namespace MaterialFeature
+{
+	enum : unsigned int
+	{
+		NormalMap = 1,	// HAS_NORMAL_MAP
+		Emissive = 2,	// HAS_EMISSIVE
+		AlphaTest = 4,	// ALPHA_TEST
+
+		PermutationCount = 8
+	};
+}
+
+// material constants as laid out in the std430 material table every material shader reads
+struct GPUMaterial
+{
+	glm::vec3 ambient;
+	float specularPower;
+	glm::vec3 diffuse;
+	float opacity;
+	glm::vec3 specular;
+	float roughness;
+	glm::vec3 emissive;
+	float reflectionCoefficient;
+	int useNormalMap;
+	unsigned int features; // MaterialFeature bits
+	int padding[2];
+	glm::uvec2 textures[8]; // texture references in slot order (see MaterialTextureTable)
+};
+static_assert(sizeof(GPUMaterial) == 144, "GPUMaterial must match the std430 layout in the shaders");
+
+// material properties and textures, the textures are shared through the texture cache
+// can be moved but never copied so its id stays unique
 struct Material
 {
+	Material() {};
+
+	// unique id used to sort draws by material (moves keep it, copies aren't allowed)
+	unsigned int id = nextID();
+
+	Material(Material&& other) = default;
+	Material& operator = (Material&& other) = default;
+
+	Material(const Material&) = delete;
+	Material& operator = (const Material&) = delete;
+
 	// lighting
 	glm::vec3 ambient = glm::vec3(1.0f); // ambient color
 	glm::vec3 diffuse = glm::vec3(1.0f); // diffuse color
@@ -18,62 +72,116 @@ struct Material
 	float roughness = 0.5f; // roughness (for physically based lighting)
 	float reflectionCoefficient = 0.5f; // reflection coefficient (for physically based lighting)
 
-	// textures
-	Texture diffuseTexture; // 0
-	Texture alphaTexture; // 1
-	Texture ambientTexture; // 2
-	Texture specularTexture; // 3
-	Texture specularHighlightTexture; // 4
-	Texture normalTexture; // 5
-	Texture displacementTexture; // 6
-	Texture emissiveTexture; // 7
-
-	// create dummy textures
-	void createDummyTextures()
+	// textures (null binds nothing, see setDefaultTextures)
+	TextureHandle diffuseTexture; // 0
+	TextureHandle alphaTexture; // 1
+	TextureHandle ambientTexture; // 2
+	TextureHandle specularTexture; // 3
+	TextureHandle specularHighlightTexture; // 4
+	TextureHandle normalTexture; // 5
+	TextureHandle displacementTexture; // 6
+	TextureHandle emissiveTexture; // 7
+
+	static const unsigned int TextureCount = 8;
+
+	// filtering every texture of the material is sampled with, overrides the textures' own
+	SamplerType sampler = SamplerType::LinearMipLinear;
+
+	// MaterialFeature bits set from the textures and constants in setDefaultTextures, AlphaTest is added by getFeatures
+	unsigned int features = 0;
+
+	static unsigned int nextID()
 	{
-		diffuseTexture.createDummy(Color::White());
-		alphaTexture.createDummy(Color::White());
-		ambientTexture.createDummy(Color::White());
-		specularTexture.createDummy(Color::Black());
-		specularHighlightTexture.createDummy(Color::Black());
-		normalTexture.createDummy(Color(128, 128, 255, 255));
-		displacementTexture.createDummy(Color::Black());
-		emissiveTexture.createDummy(Color::Black());
+		static unsigned int counter = 0;
+		return ++counter;
+	}
+
+	// work out the features from what the material was loaded with, then
+	// fill any empty slot with the shared default texture for it
+	void setDefaultTextures()
+	{
+		features = 0;
+
+		if (normalTexture)
+			features |= MaterialFeature::NormalMap;
+
+		if (emissiveTexture)
+			features |= MaterialFeature::Emissive;
+
+		TextureCache& cache = TextureCache::getInstance();
+
+		if (!diffuseTexture) diffuseTexture = cache.getWhite();
+		if (!alphaTexture) alphaTexture = cache.getWhite();
+		if (!ambientTexture) ambientTexture = cache.getWhite();
+		if (!specularTexture) specularTexture = cache.getBlack();
+		if (!specularHighlightTexture) specularHighlightTexture = cache.getBlack();
+		if (!normalTexture) normalTexture = cache.getFlatNormal();
+		if (!displacementTexture) displacementTexture = cache.getBlack();
+		if (!emissiveTexture) emissiveTexture = cache.getBlack();
 	};
 
-	// send material information to a shader
-	void bind(Shader shader)
+	// features to draw with, cutouts follow the diffuse texture's data as a streamed one is only a placeholder at first
+	unsigned int getFeatures() const
+	{
+		unsigned int result = features;
+
+		if (diffuseTexture && diffuseTexture->isTransparent())
+			result |= MaterialFeature::AlphaTest;
+
+		return result;
+	}
+
+	static unsigned int getHandle(const TextureHandle& texture)
+	{
+		return texture ? texture->getHandle() : 0;
+	}
+
+	// constants for the material buffer
+	GPUMaterial pack() const
+	{
+		GPUMaterial packed = {};
+		packed.ambient = ambient;
+		packed.specularPower = specularPower;
+		packed.diffuse = diffuse;
+		packed.opacity = opacity;
+		packed.specular = specular;
+		packed.roughness = roughness;
+		packed.emissive = emissive;
+		packed.reflectionCoefficient = reflectionCoefficient;
+		packed.useNormalMap = useNormalMap ? 1 : 0;
+		packed.features = getFeatures();
+		return packed;
+	}
+
+	// GL handles of the textures in slot order, materials with the same handles can share a draw
+	void getTextureHandles(unsigned int (&handles)[TextureCount]) const
+	{
+		handles[0] = getHandle(diffuseTexture);
+		handles[1] = getHandle(alphaTexture);
+		handles[2] = getHandle(ambientTexture);
+		handles[3] = getHandle(specularTexture);
+		handles[4] = getHandle(specularHighlightTexture);
+		handles[5] = getHandle(normalTexture);
+		handles[6] = getHandle(displacementTexture);
+		handles[7] = getHandle(emissiveTexture);
+	}
+
+	// bind the textures and the material's sampler to slots 0 - 7
+	void bindTextures() const
 	{
-		shader.setVec3("material.ambient", ambient);
-		shader.setVec3("material.diffuse", diffuse);
-		shader.setVec3("material.specular", specular);
-		shader.setVec3("material.emissive", emissive);
-
-		shader.setFloat("material.specularPower", specularPower);
-		shader.setFloat("material.opacity", opacity);
-
-		shader.setBool("material.useNormalMap", useNormalMap);
-
-		shader.setFloat("material.roughness", roughness);
-		shader.setFloat("material.reflectionCoefficient", reflectionCoefficient);
-
-		// set textures
-		shader.setInt("material.diffuseTexture", 0);
-		shader.setInt("material.alphaTexture", 1);
-		shader.setInt("material.ambientTexture", 2);
-		shader.setInt("material.specularTexture", 3);
-		shader.setInt("material.specularHighlightTexture", 4);
-		shader.setInt("material.normalTexture", 5);
-		shader.setInt("material.displacementTexture", 6);
-		shader.setInt("material.emissiveTexture", 7);
-
-		diffuseTexture.bind(0);
-		alphaTexture.bind(1);
-		ambientTexture.bind(2);
-		specularTexture.bind(3);
-		specularHighlightTexture.bind(4);
-		normalTexture.bind(5);
-		displacementTexture.bind(6);
-		emissiveTexture.bind(7);
+		unsigned int handles[TextureCount];
+		getTextureHandles(handles);
+
+		unsigned int samplerHandle = SamplerCache::getInstance().get(sampler);
+
+		for (unsigned int slot = 0; slot < TextureCount; slot++)
+		{
+			GLState::getInstance().bindTexture(slot, GL_TEXTURE_2D, handles[slot]);
+			GLState::getInstance().bindSampler(slot, samplerHandle);
+		}
 	}
+
+	// point a shader at the material's entry in the material table and bind its textures
+	// (the constants are read from the table, so the only uniform is the index)
+	void bind(const Shader& shader) const;
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "MaterialShader.h"
+
+MaterialShader::MaterialShader(const std::string& vertexPath, const std::string& fragmentPath)
+	: m_vertexPath(vertexPath), m_fragmentPath(fragmentPath)
+{
+}
+
+// the permutation for a set of features, compiled the first time it is asked for
+Shader& MaterialShader::get(unsigned int features)
+{
+	Shader& permutation = m_permutations[features & (MaterialFeature::PermutationCount - 1)];
+
+	if (permutation.ID == 0)
+	{
+		permutation = Shader(m_vertexPath.c_str(), m_fragmentPath.c_str(), nullptr, nullptr, nullptr, getDefines(features));
+	}
+
+	return permutation;
+}
+
+// start every permutation compiling, so none compiles mid frame
+void MaterialShader::compileAll()
+{
+	for (unsigned int features = 0; features < MaterialFeature::PermutationCount; features++)
+	{
+		get(features);
+	}
+}
+
+// wait for every permutation started so far to link
+void MaterialShader::finishLinking()
+{
+	for (Shader& permutation : m_permutations)
+	{
+		if (permutation.ID != 0)
+		{
+			permutation.finishLinking();
+		}
+	}
+}
+
+// #define lines for a set of features
+std::string MaterialShader::getDefines(unsigned int features)
+{
+	std::string defines;
+
+	if (features & MaterialFeature::NormalMap)
+		defines += "#define HAS_NORMAL_MAP\n";
+
+	if (features & MaterialFeature::Emissive)
+		defines += "#define HAS_EMISSIVE\n";
+
+	if (features & MaterialFeature::AlphaTest)
+		defines += "#define ALPHA_TEST\n";
+
+	return defines;
+}
+
+unsigned int MaterialShader::getPermutationCount() const
+{
+	unsigned int count = 0;
+
+	for (const Shader& permutation : m_permutations)
+	{
+		if (permutation.ID != 0)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include "Shader.h"
+#include "Material.h"
+
+// a forward material shader compiled once per combination of MaterialFeature bits it is drawn with
+// so materials without a normal map, emission or cutouts don't pay for them, permutations compile on first use
+// unless compileAll starts them up front
+class MaterialShader
+{
+public:
+
+	MaterialShader() {};
+	MaterialShader(const std::string& vertexPath, const std::string& fragmentPath);
+
+	// the permutation for a set of features, compiled the first time it is asked for
+	Shader& get(unsigned int features);
+
+	// start every permutation compiling (in parallel where the driver can), so none compiles mid frame
+	void compileAll();
+
+	// wait for every permutation started so far to link
+	void finishLinking();
+
+	// the permutation a material needs, no material gets the plainest one
+	Shader& get(const Material* material) { return get(material != nullptr ? material->getFeatures() : 0); }
+
+	// #define lines for a set of features
+	static std::string getDefines(unsigned int features);
+
+	unsigned int getPermutationCount() const;
+
+private:
+
+	std::string m_vertexPath;
+	std::string m_fragmentPath;
+
+	Shader m_permutations[MaterialFeature::PermutationCount];
+};
\ No newline at end of file
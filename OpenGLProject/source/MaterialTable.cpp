@@ -0,0 +1,90 @@
+#include "MaterialTable.h"
+#include <glad\glad.h>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+#include "MaterialTextureTable.h"
+
+MaterialTable& MaterialTable::getInstance()
+{
+	static MaterialTable instance;
+	return instance;
+}
+
+// start a new frame of materials
+void MaterialTable::begin()
+{
+	m_materials.clear();
+	m_hasReferences.clear();
+	m_indices.clear();
+	m_dirty = false;
+}
+
+// index of a material in this frame's table, packed the first time it is seen
+unsigned int MaterialTable::add(const Material& material, bool textureReferences)
+{
+	auto found = m_indices.find(material.id);
+	if (found == m_indices.end())
+	{
+		found = m_indices.emplace(material.id, (unsigned int)m_materials.size()).first;
+		m_materials.push_back(material.pack());
+		m_hasReferences.push_back(false);
+		m_dirty = true;
+	}
+
+	unsigned int index = found->second;
+
+	// the forward shaders bind textures per material, so references are only made for the draws that need them
+	if (textureReferences && !m_hasReferences[index])
+	{
+		MaterialTextureTable::getInstance().getReferences(material, m_materials[index].textures);
+		m_hasReferences[index] = true;
+		m_dirty = true;
+	}
+
+	return index;
+}
+
+// upload the table if anything was added since the last upload
+void MaterialTable::upload()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+
+	if (m_buffer == 0)
+	{
+		glGenBuffers(1, &m_buffer);
+		GL_TRACK_CREATED(GLObjectType::Buffer, m_buffer, "MaterialTable");
+	}
+
+	size_t size = m_materials.size() * sizeof(GPUMaterial);
+	if (size > m_capacity)
+	{
+		m_capacity = size + size / 2;
+	}
+
+	// respecify (orphan) the storage, draws already made this frame keep reading the old contents
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, m_materials.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::Materials, m_buffer);
+
+	m_dirty = false;
+}
+
+// release the buffer
+void MaterialTable::clear()
+{
+	begin();
+
+	if (m_buffer != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Buffer, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		m_capacity = 0;
+	}
+}
\ No newline at end of file
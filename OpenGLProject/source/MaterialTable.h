@@ -0,0 +1,42 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Material.h"
+
+// singleton table of the materials used this frame, packed into one std430 buffer (StorageBufferBinding::Materials)
+// shaders read a draw's constants from it by index, so binding a material is an index uniform and its textures
+class MaterialTable
+{
+public:
+
+	static MaterialTable& getInstance();
+
+	// start a new frame of materials, the table only holds what is drawn so it never needs to forget one
+	void begin();
+
+	// index of a material in this frame's table, packed the first time it is seen
+	// with textureReferences its texture references are filled in as well (only the indirect shaders read them)
+	unsigned int add(const Material& material, bool textureReferences = false);
+
+	// upload the table if anything was added since the last upload, before drawing with the indices
+	void upload();
+
+	size_t size() const { return m_materials.size(); }
+
+	// release the buffer, call while the GL context is still alive
+	void clear();
+
+private:
+
+	MaterialTable() {};
+	~MaterialTable() {};
+
+	std::vector<GPUMaterial> m_materials;
+	std::vector<bool> m_hasReferences;
+	std::unordered_map<unsigned int, unsigned int> m_indices; // material id -> index
+
+	bool m_dirty = false;
+
+	unsigned int m_buffer = 0;
+	size_t m_capacity = 0;
+};
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "MaterialTextureTable.h"
+#include <algorithm>
+#include <iostream>
+#include "GLExtensions.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "SamplerCache.h"
+#include "TextureStreamer.h"
+
+// ARB_bindless_texture, glad only has the core profile
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTURESAMPLERHANDLEARBPROC)(GLuint texture, GLuint sampler);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+static PFNGLGETTEXTURESAMPLERHANDLEARBPROC getTextureSamplerHandle = nullptr;
+static PFNGLMAKETEXTUREHANDLERESIDENTARBPROC makeTextureHandleResident = nullptr;
+static PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC makeTextureHandleNonResident = nullptr;
+
+// first layer count of a new array
+static const unsigned int InitialArrayLayers = 4;
+
+MaterialTextureTable& MaterialTextureTable::getInstance()
+{
+	static MaterialTextureTable instance;
+	return instance;
+}
+
+MaterialTextureMode MaterialTextureTable::getMode()
+{
+	if (!m_modeChosen)
+	{
+		m_modeChosen = true;
+
+		if (GLExtensions::has("GL_ARB_bindless_texture"))
+		{
+			getTextureSamplerHandle = (PFNGLGETTEXTURESAMPLERHANDLEARBPROC)GLExtensions::getProcAddress("glGetTextureSamplerHandleARB");
+			makeTextureHandleResident = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)GLExtensions::getProcAddress("glMakeTextureHandleResidentARB");
+			makeTextureHandleNonResident = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)GLExtensions::getProcAddress("glMakeTextureHandleNonResidentARB");
+		}
+
+		bool bindless = getTextureSamplerHandle != nullptr && makeTextureHandleResident != nullptr && makeTextureHandleNonResident != nullptr;
+		m_mode = bindless ? MaterialTextureMode::Bindless : MaterialTextureMode::TextureArrays;
+	}
+
+	return m_mode;
+}
+
+void MaterialTextureTable::getReferences(const Material& material, glm::uvec2 (&references)[Material::TextureCount])
+{
+	const TextureHandle* textures[Material::TextureCount] =
+	{
+		&material.diffuseTexture, &material.alphaTexture, &material.ambientTexture, &material.specularTexture,
+		&material.specularHighlightTexture, &material.normalTexture, &material.displacementTexture, &material.emissiveTexture
+	};
+
+	bool bindless = getMode() == MaterialTextureMode::Bindless;
+	unsigned int sampler = SamplerCache::getInstance().get(material.sampler);
+
+	for (unsigned int slot = 0; slot < Material::TextureCount; slot++)
+	{
+		// a bindless handle of 0 would be read as a texture, so empty slots use white like the arrays do
+		TextureHandle texture = *textures[slot];
+		if (texture == nullptr || texture->getHandle() == 0)
+		{
+			texture = TextureCache::getInstance().getWhite();
+		}
+
+		references[slot] = bindless ? getBindlessReference(*texture, sampler) : getArrayReference(*texture);
+	}
+}
+
+glm::uvec2 MaterialTextureTable::getBindlessReference(const Texture& texture, unsigned int sampler)
+{
+	std::vector<std::pair<unsigned int, GLuint64>>& handles = m_handles[texture.getHandle()];
+
+	GLuint64 handle = 0;
+	for (const auto& entry : handles)
+	{
+		if (entry.first == sampler)
+		{
+			handle = entry.second;
+			break;
+		}
+	}
+
+	// the texture and sampler can't change once there is a handle, which immutable storage and the cached samplers never do
+	if (handle == 0)
+	{
+		handle = getTextureSamplerHandle(texture.getHandle(), sampler);
+		makeTextureHandleResident(handle);
+		handles.emplace_back(sampler, handle);
+		m_residentHandles++;
+	}
+
+	return glm::uvec2((unsigned int)(handle & 0xFFFFFFFF), (unsigned int)(handle >> 32));
+}
+
+glm::uvec2 MaterialTextureTable::getArrayReference(const Texture& texture)
+{
+	unsigned int name = texture.getHandle();
+
+	auto found = m_layers.find(name);
+	if (found != m_layers.end())
+	{
+		return found->second;
+	}
+
+	unsigned int width = texture.getWidth();
+	unsigned int height = texture.getHeight();
+	unsigned int levels = 0;
+	unsigned int firstLevel = 0; // array level of the texture's finest level
+	unsigned int sourceLevel = 0; // GL level of the texture that holds it
+
+	// a streamed texture goes in the array of its whole chain so it keeps to one array as its mips page in and out,
+	// its layer only has the resident levels filled and the shaders don't sample above them
+	StreamedChain chain;
+	if (TextureStreamer::getInstance().getChain(&texture, chain) && chain.residentLevel < chain.levelCount)
+	{
+		width = chain.width;
+		height = chain.height;
+		levels = chain.levelCount;
+		firstLevel = chain.residentLevel;
+		sourceLevel = chain.residentLevel - chain.storageLevel;
+	}
+	else
+	{
+		// every texture has immutable storage, so the level count can be read back
+		GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, name);
+		GLint immutableLevels = 0;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &immutableLevels);
+		levels = (unsigned int)immutableLevels;
+	}
+
+	// find the array of the texture's format and size, or a free slot to start one in
+	unsigned int index = 0;
+	while (index < m_arrays.size() &&
+		!(m_arrays[index].format == texture.getFormat() && m_arrays[index].width == width &&
+		m_arrays[index].height == height && m_arrays[index].levels == levels))
+	{
+		index++;
+	}
+
+	if (index == m_arrays.size())
+	{
+		index = 0;
+		while (index < m_arrays.size() && m_arrays[index].levels != 0)
+		{
+			index++;
+		}
+
+		if (index == MaxTextureArrays || levels == 0)
+		{
+			if (m_missing++ == 0)
+			{
+				std::cout << "Material texture arrays are full, " << texture.getFilename() << " will sample as white" << std::endl;
+			}
+
+			glm::uvec2 reference(MissingArray, 0);
+			m_layers[name] = reference;
+			return reference;
+		}
+
+		if (index == m_arrays.size())
+		{
+			m_arrays.emplace_back();
+		}
+
+		TextureArray& textureArray = m_arrays[index];
+		textureArray.format = texture.getFormat();
+		textureArray.width = width;
+		textureArray.height = height;
+		textureArray.levels = levels;
+	}
+
+	TextureArray& textureArray = m_arrays[index];
+
+	unsigned int layer = 0;
+	if (!textureArray.freeLayers.empty())
+	{
+		layer = textureArray.freeLayers.back();
+		textureArray.freeLayers.pop_back();
+	}
+	else
+	{
+		if (textureArray.used == textureArray.capacity)
+		{
+			grow(textureArray);
+		}
+
+		layer = textureArray.used++;
+	}
+
+	// a GPU side copy, the texture stays usable on its own
+	for (unsigned int level = firstLevel; level < textureArray.levels; level++)
+	{
+		GLsizei levelWidth = std::max(1u, textureArray.width >> level);
+		GLsizei levelHeight = std::max(1u, textureArray.height >> level);
+		glCopyImageSubData(name, GL_TEXTURE_2D, sourceLevel + level - firstLevel, 0, 0, 0,
+			textureArray.handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelWidth, levelHeight, 1);
+	}
+
+	glm::uvec2 reference(index, layer | (firstLevel << LayerBits));
+	m_layers[name] = reference;
+	return reference;
+}
+
+void MaterialTextureTable::grow(TextureArray& textureArray)
+{
+	unsigned int capacity = std::max(InitialArrayLayers, textureArray.capacity * 2);
+
+	GLuint handle = 0;
+	glGenTextures(1, &handle);
+	GL_TRACK_CREATED(GLObjectType::Texture, handle, "MaterialTextureTable");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D_ARRAY, handle);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.levels, textureArray.format, textureArray.width, textureArray.height, capacity);
+
+	if (textureArray.handle != 0)
+	{
+		for (unsigned int level = 0; level < textureArray.levels; level++)
+		{
+			GLsizei width = std::max(1u, textureArray.width >> level);
+			GLsizei height = std::max(1u, textureArray.height >> level);
+			glCopyImageSubData(textureArray.handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, handle, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, textureArray.used);
+		}
+
+		GL_TRACK_DELETED(GLObjectType::Texture, textureArray.handle);
+		GLState::getInstance().textureDeleted(textureArray.handle);
+		glDeleteTextures(1, &textureArray.handle);
+	}
+
+	textureArray.handle = handle;
+	textureArray.capacity = capacity;
+}
+
+void MaterialTextureTable::bind()
+{
+	if (getMode() == MaterialTextureMode::Bindless)
+	{
+		return;
+	}
+
+	// one sampler for every array, the material's own choice only applies to bindless handles
+	unsigned int sampler = SamplerCache::getInstance().get(SamplerType::LinearMipLinear);
+
+	for (unsigned int i = 0; i < MaxTextureArrays; i++)
+	{
+		unsigned int handle = i < m_arrays.size() ? m_arrays[i].handle : 0;
+		GLState::getInstance().bindTexture(FirstArrayUnit + i, GL_TEXTURE_2D_ARRAY, handle);
+		GLState::getInstance().bindSampler(FirstArrayUnit + i, sampler);
+	}
+}
+
+void MaterialTextureTable::textureDeleted(unsigned int texture)
+{
+	auto handles = m_handles.find(texture);
+	if (handles != m_handles.end())
+	{
+		for (const auto& entry : handles->second)
+		{
+			makeTextureHandleNonResident(entry.second);
+			m_residentHandles--;
+		}
+
+		m_handles.erase(handles);
+	}
+
+	auto layer = m_layers.find(texture);
+	if (layer != m_layers.end())
+	{
+		if (layer->second.x != MissingArray)
+		{
+			TextureArray& textureArray = m_arrays[layer->second.x];
+			textureArray.freeLayers.push_back(layer->second.y & ((1u << LayerBits) - 1));
+
+			// nothing left in it, give the slot back for another format or size
+			if (textureArray.freeLayers.size() == textureArray.used)
+			{
+				release(textureArray);
+			}
+		}
+
+		m_layers.erase(layer);
+	}
+}
+
+void MaterialTextureTable::release(TextureArray& textureArray)
+{
+	if (textureArray.handle != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Texture, textureArray.handle);
+		GLState::getInstance().textureDeleted(textureArray.handle);
+		glDeleteTextures(1, &textureArray.handle);
+	}
+
+	textureArray = TextureArray();
+}
+
+size_t MaterialTextureTable::getArraySize(const TextureArray& textureArray) const
+{
+	size_t size = 0;
+	for (unsigned int level = 0; level < textureArray.levels; level++)
+	{
+		unsigned int width = std::max(1u, textureArray.width >> level);
+		unsigned int height = std::max(1u, textureArray.height >> level);
+
+		BlockFormat blocks = Texture::getBlockFormat(textureArray.format);
+		size += blocks != BlockFormat::None ? DDS::getLevelSize(blocks, width, height) : (size_t)width * height * Texture::getBytesPerPixel(textureArray.format);
+	}
+
+	return size * textureArray.capacity;
+}
+
+MaterialTextureStats MaterialTextureTable::getStats() const
+{
+	MaterialTextureStats stats;
+	stats.mode = m_mode;
+	stats.residentHandles = m_residentHandles;
+	stats.missing = m_missing;
+
+	for (const TextureArray& textureArray : m_arrays)
+	{
+		stats.arrays += textureArray.levels != 0 ? 1 : 0;
+		stats.layers += textureArray.used - (unsigned int)textureArray.freeLayers.size();
+		stats.arrayBytes += getArraySize(textureArray);
+	}
+
+	return stats;
+}
+
+void MaterialTextureTable::printStats() const
+{
+	MaterialTextureStats stats = getStats();
+
+	std::cout << "---- material textures ----" << std::endl;
+	if (stats.mode == MaterialTextureMode::Bindless)
+	{
+		std::cout << "bindless, resident handles: " << stats.residentHandles << std::endl;
+	}
+	else
+	{
+		std::cout << "texture arrays: " << stats.arrays << ", layers: " << stats.layers << " (" << stats.arrayBytes / 1024 << " KB)" << std::endl;
+		std::cout << "textures that didn't fit: " << stats.missing << std::endl;
+	}
+}
+
+void MaterialTextureTable::clear()
+{
+	for (const auto& handles : m_handles)
+	{
+		for (const auto& entry : handles.second)
+		{
+			makeTextureHandleNonResident(entry.second);
+		}
+	}
+
+	m_handles.clear();
+	m_residentHandles = 0;
+
+	for (TextureArray& textureArray : m_arrays)
+	{
+		release(textureArray);
+	}
+
+	m_arrays.clear();
+	m_layers.clear();
+	m_missing = 0;
+}
\ No newline at end of file
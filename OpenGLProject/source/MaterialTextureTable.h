@@ -0,0 +1,103 @@
+#pragma once
+#include <glad\glad.h>
+#include <glm\glm.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Material.h"
+
+// how the indirect shaders reach material textures without them being bound per material
+enum class MaterialTextureMode
+{
+	Bindless,		// ARB_bindless_texture handles, one per texture + sampler
+	TextureArrays	// a copy of each texture in a layer of a shared 2D array per format and size
+};
+
+// counters of the material texture table
+struct MaterialTextureStats
+{
+	MaterialTextureMode mode = MaterialTextureMode::TextureArrays;
+	unsigned int residentHandles = 0;
+	unsigned int arrays = 0;
+	unsigned int layers = 0;
+	size_t arrayBytes = 0; // GPU bytes of the array copies
+	unsigned int missing = 0; // textures that didn't fit in any array
+};
+
+// singleton table of texture references the indirect shaders read from the material buffer
+// a reference is a uvec2, the 64 bit bindless handle (low, high) or the array index and layer
+// the GLSL side picks the same mode through #ifdef GL_ARB_bindless_texture, so both follow the driver
+class MaterialTextureTable
+{
+public:
+
+	// texture arrays bound after the material units, as the shaders' materialArrays[] expect
+	static const unsigned int MaxTextureArrays = 8;
+	static const unsigned int FirstArrayUnit = 8;
+
+	// array index of a texture that didn't fit, the shaders sample it as white
+	static const unsigned int MissingArray = 0xFFFFFFFF;
+
+	// the second word of an array reference is the layer, with the finest level the layer holds above these bits
+	static const unsigned int LayerBits = 16;
+
+	static MaterialTextureTable& getInstance();
+
+	// needs a current context the first time
+	MaterialTextureMode getMode();
+
+	// texture references of a material in slot order, made resident / copied into an array the first time they are seen
+	void getReferences(const Material& material, glm::uvec2 (&references)[Material::TextureCount]);
+
+	// bind the texture arrays (nothing in bindless mode), once before drawing with the references
+	void bind();
+
+	// a GL texture is about to be deleted, its handles / layer go with it
+	// (a streamed texture gets a new GL texture as mips page in and out, so its references are fetched again)
+	void textureDeleted(unsigned int texture);
+
+	MaterialTextureStats getStats() const;
+	void printStats() const;
+
+	// release every handle and array, call while the GL context is still alive
+	void clear();
+
+private:
+
+	MaterialTextureTable() {};
+	~MaterialTextureTable() {};
+
+	struct TextureArray
+	{
+		unsigned int handle = 0;
+		GLenum format = 0;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int levels = 0; // 0 while the slot is free
+		unsigned int capacity = 0;
+		unsigned int used = 0; // layers ever handed out, freed ones are reused first
+		std::vector<unsigned int> freeLayers;
+	};
+
+	glm::uvec2 getBindlessReference(const Texture& texture, unsigned int sampler);
+	glm::uvec2 getArrayReference(const Texture& texture);
+
+	// make room for at least one more layer, copying the existing layers into bigger storage
+	void grow(TextureArray& textureArray);
+
+	// delete the array's storage and free its slot
+	void release(TextureArray& textureArray);
+
+	size_t getArraySize(const TextureArray& textureArray) const;
+
+	bool m_modeChosen = false;
+	MaterialTextureMode m_mode = MaterialTextureMode::TextureArrays;
+
+	// resident handles of each GL texture, with the sampler they were made with
+	std::unordered_map<unsigned int, std::vector<std::pair<unsigned int, GLuint64>>> m_handles;
+	unsigned int m_residentHandles = 0;
+
+	std::vector<TextureArray> m_arrays;
+	std::unordered_map<unsigned int, glm::uvec2> m_layers; // GL texture -> array and layer
+	unsigned int m_missing = 0;
+};
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include <glad\glad.h>
 #include <math.h>
+#include <cfloat>
 #include "Color.h"
+#include "GLObjectTracker.h"
+#include "RenderStats.h"
+#include "GLState.h"
 #include <experimental\filesystem>
 namespace fs = std::experimental::filesystem;
 
@@ -13,12 +18,17 @@ namespace fs = std::experimental::filesystem;
 
 Mesh::~Mesh()
 {
-	glDeleteVertexArrays(1, &vbo);
+	GL_TRACK_DELETED(GLObjectType::VertexArray, vao);
+	GL_TRACK_DELETED(GLObjectType::Buffer, vbo);
+	GL_TRACK_DELETED(GLObjectType::Buffer, ibo);
+
+	GLState::getInstance().vertexArrayDeleted(vao);
+	glDeleteVertexArrays(1, &vao);
 	glDeleteBuffers(1, &vbo);
 	glDeleteBuffers(1, &ibo);
 }
 
-void Mesh::initialise(std::vector<Vertex> verts, std::vector<unsigned int>* indices)
+void Mesh::initialise(std::vector<Vertex> verts, std::vector<unsigned int>* indices, VertexFormat format)
 {
 	assert(vao == 0);
 
@@ -29,57 +39,89 @@ void Mesh::initialise(std::vector<Vertex> verts, std::vector<unsigned int>* indi
 		m_indices = *indices;
 	}
 
+	// the generators walk rows and fans, reorder the triangles for the vertex cache and overdraw
+	// and the vertices into the order the triangles first use them
+	if (!m_indices.empty() && !m_verts.empty())
+	{
+		unsigned int vertexCount = (unsigned int)m_verts.size();
+		MeshOptimizer::optimizeVertexCache(m_indices.data(), m_indices.size(), vertexCount);
+		MeshOptimizer::optimizeOverdraw(m_indices.data(), m_indices.size(), &m_verts[0].position.x, vertexCount, sizeof(Vertex));
+
+		vertexCount = MeshOptimizer::optimizeVertexFetch((unsigned char*)m_verts.data(), vertexCount, sizeof(Vertex),
+			m_indices.data(), m_indices.size());
+		m_verts.resize(vertexCount);
+	}
+
+	// object space bounds, the sphere is centered on the box and reaches the furthest vertex
+	m_boundsMin = glm::vec3(FLT_MAX);
+	m_boundsMax = glm::vec3(-FLT_MAX);
+	for (const Vertex& vertex : m_verts)
+	{
+		m_boundsMin = glm::min(m_boundsMin, glm::vec3(vertex.position));
+		m_boundsMax = glm::max(m_boundsMax, glm::vec3(vertex.position));
+	}
+
+	glm::vec3 center = getBoundsCenter();
+	m_boundsRadius = 0.0f;
+	for (const Vertex& vertex : m_verts)
+	{
+		m_boundsRadius = glm::max(m_boundsRadius, glm::length(glm::vec3(vertex.position) - center));
+	}
+
 	// generate buffers
 	glGenBuffers(1, &vbo);
 	glGenVertexArrays(1, &vao);
+	GL_TRACK_CREATED(GLObjectType::Buffer, vbo, "Mesh");
+	GL_TRACK_CREATED(GLObjectType::VertexArray, vao, "Mesh");
 
 	// bind vertex array aka a mesh wrapper
-	glBindVertexArray(vao);
+	GLState::getInstance().bindVertexArray(vao);
+
+	// convert the vertices to the mesh's layout
+	const VertexLayout& layout = VertexLayout::get(format);
+
+	std::vector<unsigned char> packed;
+	layout.pack(m_verts.data(), m_verts.size(), packed);
 
 	// bind vertex buffer
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
 	// fill vertex buffer
-	glBufferData(GL_ARRAY_BUFFER, m_verts.size() * sizeof(Vertex),
-		&m_verts[0], GL_STATIC_DRAW);
-
-	// enable first element as position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-
-	// enable second element as normal
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-
-	// enable third element as texCoord
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
+	glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
 
-	// enable fourth element as tangent
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
-
-	// enable fifth element as color
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 5, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+	// set up the attributes from the layout
+	layout.apply(0);
+	glBindVertexBuffer(0, vbo, 0, layout.getStride());
 
 	// bind indices if there are any
 	if (m_indices.size() != 0)
 	{
 		glGenBuffers(1, &ibo);
+		GL_TRACK_CREATED(GLObjectType::Buffer, ibo, "Mesh");
 
 		// bind vertex buffer
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 
-		// fill vertex buffer
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW);
+		// fill index buffer, 16 bit when every vertex fits
+		if (m_verts.size() < 65536)
+		{
+			std::vector<unsigned short> shortIndices(m_indices.begin(), m_indices.end());
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+				shortIndices.size() * sizeof(unsigned short), &shortIndices[0], GL_STATIC_DRAW);
+			m_indexType = GL_UNSIGNED_SHORT;
+		}
+		else
+		{
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+				m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW);
+			m_indexType = GL_UNSIGNED_INT;
+		}
 	}
 
-	m_material.createDummyTextures();
+	m_material.setDefaultTextures();
 
 	// unbind buffers
-	glBindVertexArray(0);
+	GLState::getInstance().bindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -384,17 +426,19 @@ void Mesh::initialiseIcosahedron()
 	initialise(verts, &indices);
 }
 
-void Mesh::draw(Shader shader)
+void Mesh::draw(const Shader& shader)
 {
 	m_material.bind(shader);
 
-	glBindVertexArray(vao);
+	GLState::getInstance().bindVertexArray(vao);
+	RenderStats::getInstance().current().materialBinds++;
+	RenderStats::getInstance().current().drawCalls++;
 
 	// using indices or just vertices
 	if (ibo != 0)
 	{
 		glDrawElements(GL_TRIANGLES, (GLsizei)m_indices.size(),
-			GL_UNSIGNED_INT, 0);
+			m_indexType, 0);
 	}
 	else
 	{
@@ -1,9 +1,11 @@
 #pragma once
 #include "Vertex.h"
+#include "VertexLayout.h"
 #include "Material.h"
 #include "Shader.h"
 #include <vector>
 
+// procedural mesh, owns its GL buffers so it can't be copied
 class Mesh
 {
 public:
@@ -11,7 +13,12 @@ public:
 	Mesh() {}
 	virtual ~Mesh();
 
-	void initialise(std::vector<Vertex> verts, std::vector<unsigned int>* indices = nullptr);
+	Mesh(const Mesh&) = delete;
+	Mesh& operator = (const Mesh&) = delete;
+
+	// the vertices are kept as Vertex on the CPU and stored on the GPU in the given format
+	void initialise(std::vector<Vertex> verts, std::vector<unsigned int>* indices = nullptr,
+		VertexFormat format = VertexFormat::Full);
 
 	void initialiseQuad();
 	void initialiseBox();
@@ -20,22 +27,36 @@ public:
 	void initialiseSphere(float radius, int rows, int columns);
 	void initialiseIcosahedron();
 
-	virtual void draw(Shader shader);
+	virtual void draw(const Shader& shader);
 
 	const unsigned int getVertexArrayObject() { return vao; }
 	const unsigned int getVertexBufferObject() { return vbo; }
 	const unsigned int getIndexBufferObject() { return ibo; }
+	GLenum getIndexType() const { return m_indexType; }
 
 	Material& material() { return m_material; }
 
+	// object space bounds, set by initialise
+	const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+	const glm::vec3& getBoundsMax() const { return m_boundsMax; }
+	glm::vec3 getBoundsCenter() const { return (m_boundsMin + m_boundsMax) * 0.5f; }
+	float getBoundsRadius() const { return m_boundsRadius; }
+
 protected:
 
 	unsigned int vao = 0;
 	unsigned int vbo = 0;
 	unsigned int ibo = 0;
 
+	// GL_UNSIGNED_SHORT unless there are too many vertices
+	GLenum m_indexType = GL_UNSIGNED_INT;
+
 	std::vector<Vertex> m_verts;
 	std::vector<unsigned int> m_indices;
 
 	Material m_material;
+
+	glm::vec3 m_boundsMin = glm::vec3(0.0f);
+	glm::vec3 m_boundsMax = glm::vec3(0.0f);
+	float m_boundsRadius = 0.0f;
 };
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+// "OMC1" read as a little endian int
+static const uint32_t CacheMagic = 0x31434D4F;
+
+// bump whenever the layout below (or the meaning of the data) changes
+static const uint32_t CacheVersion = 6;
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t vertexFormat;
+	uint32_t vertexStride;
+	uint32_t chunkCount;
+	uint32_t materialCount;
+	uint64_t chunkTableOffset;
+	uint64_t materialTableOffset;
+	uint64_t stringTableOffset;
+	uint64_t stringTableSize;
+	uint64_t fileSize;
+};
+
+struct CacheChunk
+{
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	int32_t materialID;
+	float uvDensity;
+	float boundsMin[3];
+	float boundsMax[3];
+	float boundsRadius;
+	uint32_t lodCount;
+	uint32_t lodFirstIndex[MaxMeshLods];
+	uint32_t lodIndexCount[MaxMeshLods];
+	float lodError[MaxMeshLods];
+};
+
+struct CacheMaterial
+{
+	float ambient[3];
+	float diffuse[3];
+	float specular[3];
+	float emissive[3];
+	float specularPower;
+	float opacity;
+	uint32_t textures[MeshTextureCount]; // offsets into the string table
+};
+
+static uint64_t align16(uint64_t offset)
+{
+	return (offset + 15) & ~(uint64_t)15;
+}
+
+static void hashBytes(uint64_t& hash, const unsigned char* bytes, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+// path of the cache file kept next to a source mesh
+std::string MeshCache::getCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".cache";
+}
+
+// 64 bit FNV-1a hash of an obj file and the mtl files it references (0 if it can't be read)
+unsigned long long MeshCache::hashSource(const std::string& sourcePath)
+{
+	MappedFile source;
+	if (!source.open(sourcePath))
+	{
+		return 0;
+	}
+
+	uint64_t hash = 14695981039346656037ull;
+	hashBytes(hash, source.data(), source.size());
+
+	// material libraries are resolved relative to the obj's folder, like the importer does
+	std::string folder = sourcePath.substr(0, sourcePath.find_last_of("\\/") + 1);
+
+	const char* text = (const char*)source.data();
+	const char* end = text + source.size();
+
+	for (const char* line = text; line < end;)
+	{
+		const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+		if (lineEnd == nullptr)
+		{
+			lineEnd = end;
+		}
+
+		if (lineEnd - line > 7 && strncmp(line, "mtllib ", 7) == 0)
+		{
+			std::string name(line + 7, lineEnd);
+			while (!name.empty() && (name.back() == '\r' || name.back() == ' '))
+			{
+				name.pop_back();
+			}
+
+			MappedFile library;
+			if (library.open(folder + name))
+			{
+				hashBytes(hash, library.data(), library.size());
+			}
+		}
+
+		line = lineEnd + 1;
+	}
+
+	return hash;
+}
+
+// map a cache file, fails if it is missing, corrupt, from another version or out of date
+bool MeshCache::load(const std::string& cachePath, unsigned long long sourceHash, VertexFormat format, MeshData& data)
+{
+	MappedFile file;
+	if (!file.open(cachePath) || file.size() < sizeof(CacheHeader))
+	{
+		return false;
+	}
+
+	const unsigned char* base = file.data();
+	const CacheHeader& header = *(const CacheHeader*)base;
+
+	const VertexLayout& layout = VertexLayout::get(format);
+
+	if (header.magic != CacheMagic || header.version != CacheVersion || header.sourceHash != sourceHash ||
+		header.vertexFormat != (uint32_t)format || header.vertexStride != layout.getStride() ||
+		header.fileSize != file.size())
+	{
+		return false;
+	}
+
+	// every table has to be inside the file, a truncated or corrupt cache is just rebuilt
+	uint64_t size = file.size();
+	if (header.chunkTableOffset + (uint64_t)header.chunkCount * sizeof(CacheChunk) > size ||
+		header.materialTableOffset + (uint64_t)header.materialCount * sizeof(CacheMaterial) > size ||
+		header.stringTableOffset + header.stringTableSize > size || header.stringTableSize == 0 ||
+		base[header.stringTableOffset + header.stringTableSize - 1] != '\0')
+	{
+		return false;
+	}
+
+	const CacheChunk* chunks = (const CacheChunk*)(base + header.chunkTableOffset);
+	const CacheMaterial* materials = (const CacheMaterial*)(base + header.materialTableOffset);
+	const char* strings = (const char*)(base + header.stringTableOffset);
+
+	data.format = format;
+	data.chunks.clear();
+	data.materials.clear();
+	data.ownedVertices.clear();
+	data.ownedIndices.clear();
+
+	data.chunks.reserve(header.chunkCount);
+	for (uint32_t i = 0; i < header.chunkCount; i++)
+	{
+		const CacheChunk& cached = chunks[i];
+
+		if (cached.vertexOffset + (uint64_t)cached.vertexCount * header.vertexStride > size ||
+			cached.indexOffset + (uint64_t)cached.indexCount * sizeof(uint32_t) > size ||
+			cached.materialID >= (int32_t)header.materialCount ||
+			cached.lodCount == 0 || cached.lodCount > MaxMeshLods)
+		{
+			return false;
+		}
+
+		MeshChunkData chunk;
+		chunk.vertices = base + cached.vertexOffset;
+		chunk.vertexCount = cached.vertexCount;
+		chunk.indices = (const unsigned int*)(base + cached.indexOffset);
+		chunk.indexCount = cached.indexCount;
+		chunk.materialID = cached.materialID;
+		chunk.boundsMin = glm::vec3(cached.boundsMin[0], cached.boundsMin[1], cached.boundsMin[2]);
+		chunk.boundsMax = glm::vec3(cached.boundsMax[0], cached.boundsMax[1], cached.boundsMax[2]);
+		chunk.boundsRadius = cached.boundsRadius;
+		chunk.uvDensity = cached.uvDensity;
+
+		chunk.lodCount = cached.lodCount;
+		for (uint32_t l = 0; l < cached.lodCount; l++)
+		{
+			if ((uint64_t)cached.lodFirstIndex[l] + cached.lodIndexCount[l] > cached.indexCount)
+			{
+				return false;
+			}
+
+			chunk.lods[l].firstIndex = cached.lodFirstIndex[l];
+			chunk.lods[l].indexCount = cached.lodIndexCount[l];
+			chunk.lods[l].error = cached.lodError[l];
+		}
+
+		data.chunks.push_back(chunk);
+	}
+
+	data.materials.resize(header.materialCount);
+	for (uint32_t i = 0; i < header.materialCount; i++)
+	{
+		const CacheMaterial& cached = materials[i];
+		MeshMaterialData& material = data.materials[i];
+
+		material.ambient = glm::vec3(cached.ambient[0], cached.ambient[1], cached.ambient[2]);
+		material.diffuse = glm::vec3(cached.diffuse[0], cached.diffuse[1], cached.diffuse[2]);
+		material.specular = glm::vec3(cached.specular[0], cached.specular[1], cached.specular[2]);
+		material.emissive = glm::vec3(cached.emissive[0], cached.emissive[1], cached.emissive[2]);
+		material.specularPower = cached.specularPower;
+		material.opacity = cached.opacity;
+
+		for (unsigned int t = 0; t < MeshTextureCount; t++)
+		{
+			if (cached.textures[t] >= header.stringTableSize)
+			{
+				return false;
+			}
+
+			material.textures[t] = strings + cached.textures[t];
+		}
+	}
+
+	// the chunks point into the mapping, so the mesh data keeps it open
+	data.mappedFile = std::move(file);
+
+	return true;
+}
+
+bool MeshCache::save(const std::string& cachePath, unsigned long long sourceHash, const MeshData& data)
+{
+	const VertexLayout& layout = VertexLayout::get(data.format);
+
+	// string table, offset 0 is the empty string
+	std::vector<char> strings(1, '\0');
+	std::vector<CacheMaterial> materials(data.materials.size());
+
+	for (size_t i = 0; i < data.materials.size(); i++)
+	{
+		const MeshMaterialData& material = data.materials[i];
+		CacheMaterial& cached = materials[i];
+
+		memcpy(cached.ambient, &material.ambient[0], sizeof(cached.ambient));
+		memcpy(cached.diffuse, &material.diffuse[0], sizeof(cached.diffuse));
+		memcpy(cached.specular, &material.specular[0], sizeof(cached.specular));
+		memcpy(cached.emissive, &material.emissive[0], sizeof(cached.emissive));
+		cached.specularPower = material.specularPower;
+		cached.opacity = material.opacity;
+
+		for (unsigned int t = 0; t < MeshTextureCount; t++)
+		{
+			if (material.textures[t].empty())
+			{
+				cached.textures[t] = 0;
+				continue;
+			}
+
+			cached.textures[t] = (uint32_t)strings.size();
+			strings.insert(strings.end(), material.textures[t].begin(), material.textures[t].end());
+			strings.push_back('\0');
+		}
+	}
+
+	// lay out the file
+	CacheHeader header = {};
+	header.magic = CacheMagic;
+	header.version = CacheVersion;
+	header.sourceHash = sourceHash;
+	header.vertexFormat = (uint32_t)data.format;
+	header.vertexStride = layout.getStride();
+	header.chunkCount = (uint32_t)data.chunks.size();
+	header.materialCount = (uint32_t)data.materials.size();
+
+	header.chunkTableOffset = align16(sizeof(CacheHeader));
+	header.materialTableOffset = align16(header.chunkTableOffset + data.chunks.size() * sizeof(CacheChunk));
+	header.stringTableOffset = align16(header.materialTableOffset + materials.size() * sizeof(CacheMaterial));
+	header.stringTableSize = strings.size();
+
+	uint64_t offset = align16(header.stringTableOffset + header.stringTableSize);
+
+	std::vector<CacheChunk> chunks(data.chunks.size());
+	for (size_t i = 0; i < data.chunks.size(); i++)
+	{
+		const MeshChunkData& chunk = data.chunks[i];
+
+		chunks[i].vertexOffset = offset;
+		chunks[i].vertexCount = chunk.vertexCount;
+		offset = align16(offset + (uint64_t)chunk.vertexCount * header.vertexStride);
+
+		chunks[i].indexOffset = offset;
+		chunks[i].indexCount = chunk.indexCount;
+		offset = align16(offset + (uint64_t)chunk.indexCount * sizeof(uint32_t));
+
+		chunks[i].materialID = chunk.materialID;
+		chunks[i].uvDensity = chunk.uvDensity;
+		memcpy(chunks[i].boundsMin, &chunk.boundsMin[0], sizeof(chunks[i].boundsMin));
+		memcpy(chunks[i].boundsMax, &chunk.boundsMax[0], sizeof(chunks[i].boundsMax));
+		chunks[i].boundsRadius = chunk.boundsRadius;
+
+		chunks[i].lodCount = chunk.lodCount;
+		for (unsigned int l = 0; l < MaxMeshLods; l++)
+		{
+			chunks[i].lodFirstIndex[l] = chunk.lods[l].firstIndex;
+			chunks[i].lodIndexCount[l] = chunk.lods[l].indexCount;
+			chunks[i].lodError[l] = chunk.lods[l].error;
+		}
+	}
+
+	header.fileSize = offset;
+
+	// write everything with zero padding in between
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	uint64_t written = 0;
+	auto writeAt = [&](uint64_t position, const void* bytes, size_t size)
+	{
+		static const char zeros[16] = {};
+		while (written < position)
+		{
+			size_t padding = (size_t)std::min<uint64_t>(position - written, sizeof(zeros));
+			file.write(zeros, padding);
+			written += padding;
+		}
+
+		file.write((const char*)bytes, size);
+		written += size;
+	};
+
+	writeAt(0, &header, sizeof(header));
+	writeAt(header.chunkTableOffset, chunks.data(), chunks.size() * sizeof(CacheChunk));
+	writeAt(header.materialTableOffset, materials.data(), materials.size() * sizeof(CacheMaterial));
+	writeAt(header.stringTableOffset, strings.data(), strings.size());
+
+	for (size_t i = 0; i < data.chunks.size(); i++)
+	{
+		writeAt(chunks[i].vertexOffset, data.chunks[i].vertices, (size_t)data.chunks[i].vertexCount * header.vertexStride);
+		writeAt(chunks[i].indexOffset, data.chunks[i].indices, (size_t)data.chunks[i].indexCount * sizeof(uint32_t));
+	}
+
+	writeAt(header.fileSize, nullptr, 0);
+
+	return file.good();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include "MeshData.h"
+
+// binary mesh cache, written the first time a mesh is imported and memory mapped after that
+//
+// layout (version 6, little endian, blobs 16 byte aligned):
+//   header		magic, version, source hash, vertex format / stride, table offsets, file size
+//   chunk table	per chunk vertex / index blob offsets and counts, material id, bounds (box and sphere radius), uv density
+//			and the index range and error of each level of detail
+//   material table	constants and string table offsets of the texture names
+//   string table	null terminated texture names
+//   blobs		vertices already in the vertex format, 32 bit indices, both in the optimised draw order
+//
+// the vertex / index blobs are used in place, so they go from the page cache to glBufferData without a copy
+namespace MeshCache
+{
+	// path of the cache file kept next to a source mesh
+	std::string getCachePath(const std::string& sourcePath);
+
+	// 64 bit FNV-1a hash of an obj file and the mtl files it references (0 if it can't be read)
+	unsigned long long hashSource(const std::string& sourcePath);
+
+	// map a cache file, fails if it is missing, corrupt, from another version or out of date
+	bool load(const std::string& cachePath, unsigned long long sourceHash, VertexFormat format, MeshData& data);
+
+	bool save(const std::string& cachePath, unsigned long long sourceHash, const MeshData& data);
+}
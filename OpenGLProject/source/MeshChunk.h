@@ -1,8 +1,38 @@
 #pragma once
+#include <glm\glm.hpp>
+#include "GeometryPool.h"
+#include "MeshData.h"
+
+// 4 triangles as their first corner and the two edges leaving it, one triangle per SSE lane (see SceneBVH::raycast)
+// unused lanes are left zero, a degenerate triangle no ray can hit
+struct TrianglePacket
+{
+	float v0x[4], v0y[4], v0z[4];
+	float e1x[4], e1y[4], e1z[4];
+	float e2x[4], e2y[4], e2z[4];
+};
 
 struct MeshChunk
 {
 	unsigned int	vao, vbo, ibo;
-	unsigned int	indexCount;
+	unsigned int	indexCount; // of the full mesh, level of detail 0
 	int				materialID;
+
+	// GL_UNSIGNED_SHORT when every vertex can be indexed with 16 bits, pooled chunks share the pool's 32 bit indices
+	GLenum			indexType;
+
+	size_t indexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int); }
+
+	// ranges of the chunk's indices to draw at each level of detail, the error is in object space units
+	MeshLod			lods[MaxMeshLods];
+	unsigned int	lodCount;
+
+	// object space bounds and uv distance per object space unit, used to cull and to pick texture mips
+	// (the bounding sphere is centered on the box)
+	glm::vec3		boundsMin, boundsMax;
+	float			boundsRadius;
+	float			uvDensity;
+
+	// chunks loaded into a geometry pool share its vertex array (vbo / ibo stay 0) and draw from their allocation
+	GeometryAllocation	geometry;
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <string>
+#include <vector>
+#include "VertexLayout.h"
+#include "MappedFile.h"
+
+// number of material textures, in the slot order used by Material
+// (diffuse, alpha, ambient, specular, specular highlight, normal, displacement, emissive)
+static const unsigned int MeshTextureCount = 8;
+
+// most levels of detail a chunk keeps, level 0 is the full mesh
+static const unsigned int MaxMeshLods = 4;
+
+// a level of detail, a range of its chunk's indices drawn instead of the full set
+struct MeshLod
+{
+	unsigned int firstIndex = 0;
+	unsigned int indexCount = 0;
+	float error = 0.0f; // object space distance the simplified surface may be away from the full one
+};
+
+// material read from an mtl file, texture names are relative to the mesh's folder (empty if unused)
+struct MeshMaterialData
+{
+	glm::vec3 ambient = glm::vec3(1.0f);
+	glm::vec3 diffuse = glm::vec3(1.0f);
+	glm::vec3 specular = glm::vec3(1.0f);
+	glm::vec3 emissive = glm::vec3(0.0f);
+
+	float specularPower = 128.0f;
+	float opacity = 1.0f;
+
+	std::string textures[MeshTextureCount];
+};
+
+// one shape of a mesh, the vertices are already in the mesh's vertex format
+// the indices hold every level of detail back to back, the full mesh first
+struct MeshChunkData
+{
+	const unsigned char* vertices = nullptr;
+	unsigned int vertexCount = 0;
+	const unsigned int* indices = nullptr;
+	unsigned int indexCount = 0;
+	int materialID = -1;
+
+	// object space bounds, and the average uv distance per object space unit (0 without texture coordinates)
+	// the bounding sphere is centered on the box, its radius reaches the furthest vertex
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	float boundsRadius = 0.0f;
+	float uvDensity = 0.0f;
+
+	MeshLod lods[MaxMeshLods];
+	unsigned int lodCount = 0;
+};
+
+// mesh ready to be uploaded, either imported (owning its arrays) or mapped straight from a cache file
+struct MeshData
+{
+	VertexFormat format = VertexFormat::Full;
+
+	std::vector<MeshChunkData> chunks;
+	std::vector<MeshMaterialData> materials;
+
+	// storage the chunk pointers point into
+	std::vector<std::vector<unsigned char>> ownedVertices;
+	std::vector<std::vector<unsigned int>> ownedIndices;
+	MappedFile mappedFile;
+};
@@ -0,0 +1,468 @@
+#include "MeshOptimizer.h"
+#include <glm\geometric.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// cache positions the vertex scores reward, a little bigger than real caches so no particular size is tuned for
+const unsigned int ScoreCacheSize = 32;
+
+// Forsyth's scoring: how fast the reward falls off down the cache, what the last triangle's vertices are worth
+// (less than the next few so strips don't keep turning back on themselves) and how much vertices with few triangles left are pushed
+const float CacheDecayPower = 1.5f;
+const float LastTriangleScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+// vertices with more triangles left than this share the last valence score
+const unsigned int MaxScoredValence = 32;
+
+// FIFO size used to find where the cache optimised order can be cut into clusters
+const unsigned int OverdrawCacheSize = 16;
+
+static const glm::vec3& positionOf(const float* positions, size_t positionStride, unsigned int vertex)
+{
+	return *(const glm::vec3*)((const unsigned char*)positions + vertex * positionStride);
+}
+
+// FIFO cache as a timestamp per vertex, a vertex is still cached if fewer than cacheSize misses came after it
+// flush by moving time on by more than the cache size
+struct FIFOCache
+{
+	std::vector<unsigned int> timestamps;
+	unsigned int time;
+	unsigned int size;
+
+	FIFOCache(unsigned int vertexCount, unsigned int cacheSize) : timestamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+	// returns 1 on a miss
+	unsigned int touch(unsigned int vertex)
+	{
+		if (time - timestamps[vertex] > size)
+		{
+			timestamps[vertex] = time++;
+			return 1;
+		}
+		return 0;
+	}
+
+	void flush() { time += size + 1; }
+};
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const unsigned int* indices, size_t indexCount, unsigned int vertexCount,
+	unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangles = (unsigned int)(indexCount / 3);
+
+	FIFOCache cache(vertexCount, cacheSize);
+	std::vector<bool> used(vertexCount, false);
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int vertex = indices[i];
+		assert(vertex < vertexCount);
+
+		stats.transforms += cache.touch(vertex);
+
+		if (!used[vertex])
+		{
+			used[vertex] = true;
+			stats.vertices++;
+		}
+	}
+
+	return stats;
+}
+
+void MeshOptimizer::optimizeVertexCache(unsigned int* indices, size_t indexCount, unsigned int vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	float cacheScores[ScoreCacheSize];
+	for (unsigned int i = 0; i < ScoreCacheSize; i++)
+	{
+		cacheScores[i] = i < 3 ? LastTriangleScore : powf(1.0f - (float)(i - 3) / (ScoreCacheSize - 3), CacheDecayPower);
+	}
+
+	float valenceScores[MaxScoredValence + 1];
+	valenceScores[0] = 0.0f;
+	for (unsigned int i = 1; i <= MaxScoredValence; i++)
+	{
+		valenceScores[i] = ValenceBoostScale * powf((float)i, -ValenceBoostPower);
+	}
+
+	// the triangles of each vertex, the ones not drawn yet are kept at the front of its range
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	auto scoreVertex = [&](unsigned int vertex)
+	{
+		int position = cachePositions[vertex];
+		float score = position >= 0 ? cacheScores[position] : 0.0f;
+		return score + valenceScores[std::min(remaining[vertex], MaxScoredValence)];
+	};
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = scoreVertex(v);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+
+	// room for the cache plus the 3 vertices pushed out of it by a new triangle
+	unsigned int cache[ScoreCacheSize + 3];
+	unsigned int nextCache[ScoreCacheSize + 3];
+	unsigned int cacheCount = 0;
+
+	// start from the best triangle, after that only triangles of cached vertices are looked at
+	size_t best = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+	size_t deadEndCursor = 0;
+
+	while (best < triangleCount)
+	{
+		const unsigned int* triangle = indices + best * 3;
+		emitted[best] = true;
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int vertex = triangle[k];
+			result.push_back(vertex);
+
+			// swap the triangle out of the vertex's remaining triangles
+			unsigned int* first = adjacency.data() + offsets[vertex];
+			unsigned int* last = first + remaining[vertex] - 1;
+			*std::find(first, last + 1, (unsigned int)best) = *last;
+			remaining[vertex]--;
+		}
+
+		// the triangle's vertices go to the front, the rest of the cache moves down behind them
+		unsigned int nextCount = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			nextCache[nextCount++] = triangle[k];
+		}
+
+		for (unsigned int i = 0; i < cacheCount; i++)
+		{
+			unsigned int vertex = cache[i];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+			{
+				nextCache[nextCount++] = vertex;
+			}
+		}
+
+		for (unsigned int i = 0; i < nextCount; i++)
+		{
+			unsigned int vertex = nextCache[i];
+			cachePositions[vertex] = i < ScoreCacheSize ? (int)i : -1;
+			vertexScores[vertex] = scoreVertex(vertex);
+		}
+
+		// rescore the triangles the changed vertices are part of and take the best one still in the cache
+		best = triangleCount;
+		float bestScore = -1.0f;
+
+		for (unsigned int i = 0; i < nextCount; i++)
+		{
+			unsigned int vertex = nextCache[i];
+			const unsigned int* first = adjacency.data() + offsets[vertex];
+
+			for (unsigned int a = 0; a < remaining[vertex]; a++)
+			{
+				unsigned int t = first[a];
+				float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+
+				if (i < ScoreCacheSize && score > bestScore)
+				{
+					best = t;
+					bestScore = score;
+				}
+			}
+		}
+
+		cacheCount = std::min(nextCount, ScoreCacheSize);
+		memcpy(cache, nextCache, cacheCount * sizeof(unsigned int));
+
+		// dead end, nothing in the cache has triangles left so carry on from the next triangle not drawn yet
+		if (best == triangleCount)
+		{
+			while (deadEndCursor < triangleCount && emitted[deadEndCursor])
+			{
+				deadEndCursor++;
+			}
+			best = deadEndCursor;
+		}
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void MeshOptimizer::optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, unsigned int vertexCount,
+	size_t positionStride, float threshold)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	// where all three vertices of a triangle miss, the order has moved on to another part of the mesh
+	std::vector<unsigned int> misses(triangleCount);
+	{
+		FIFOCache cache(vertexCount, OverdrawCacheSize);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			misses[t] = cache.touch(indices[t * 3]) + cache.touch(indices[t * 3 + 1]) + cache.touch(indices[t * 3 + 2]);
+		}
+	}
+
+	std::vector<size_t> hardStarts;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		if (t == 0 || misses[t] == 3)
+		{
+			hardStarts.push_back(t);
+		}
+	}
+	hardStarts.push_back(triangleCount);
+
+	// cut each of those further wherever the part so far already beats the limit, the next part then starts on a cold cache
+	// and so does the whole cluster the limit comes from, once sorted it won't follow what it followed here
+	std::vector<size_t> clusterStarts;
+	FIFOCache cache(vertexCount, OverdrawCacheSize);
+
+	for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+	{
+		size_t start = hardStarts[h];
+		size_t end = hardStarts[h + 1];
+
+		cache.flush();
+
+		unsigned int clusterMisses = 0;
+		for (size_t t = start; t < end; t++)
+		{
+			clusterMisses += cache.touch(indices[t * 3]) + cache.touch(indices[t * 3 + 1]) + cache.touch(indices[t * 3 + 2]);
+		}
+
+		float limit = threshold * clusterMisses / (float)(end - start);
+
+		cache.flush();
+		clusterStarts.push_back(start);
+
+		unsigned int partMisses = 0;
+		unsigned int partTriangles = 0;
+
+		for (size_t t = start; t < end; t++)
+		{
+			partMisses += cache.touch(indices[t * 3]) + cache.touch(indices[t * 3 + 1]) + cache.touch(indices[t * 3 + 2]);
+			partTriangles++;
+
+			if (t + 1 < end && partMisses <= limit * partTriangles)
+			{
+				cache.flush();
+				clusterStarts.push_back(t + 1);
+				partMisses = 0;
+				partTriangles = 0;
+			}
+		}
+
+		// a leftover part that never got under the limit is cheaper to keep joined to the one before it
+		if (partMisses > limit * partTriangles && clusterStarts.back() != start)
+		{
+			clusterStarts.pop_back();
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	size_t clusterCount = clusterStarts.size() - 1;
+	if (clusterCount < 2)
+	{
+		return;
+	}
+
+	// area weighted centroid and normal of each cluster and the centroid of the whole mesh
+	std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float clusterArea = 0.0f;
+
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const glm::vec3& p0 = positionOf(positions, positionStride, indices[t * 3]);
+			const glm::vec3& p1 = positionOf(positions, positionStride, indices[t * 3 + 1]);
+			const glm::vec3& p2 = positionOf(positions, positionStride, indices[t * 3 + 2]);
+
+			// the cross product's length is twice the area, so it is already area weighted
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+
+			clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+
+		clusterCentroids[c] = clusterArea > 0.0f ? clusterCentroids[c] / clusterArea : positionOf(positions, positionStride, indices[clusterStarts[c] * 3]);
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	// clusters further out along their own normal are more likely to be in front of the rest, draw them first
+	std::vector<float> keys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float length = glm::length(clusterNormals[c]);
+		keys[c] = length > 0.0f ? glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length) : 0.0f;
+	}
+
+	std::vector<unsigned int> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		order[c] = (unsigned int)c;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	for (unsigned int c : order)
+	{
+		result.insert(result.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+	}
+
+	// the clusters are only measured on their own, so keep the cache optimised order if the sorted one lost too much of it
+	float cacheOptimisedACMR = analyzeVertexCache(indices, indexCount, vertexCount, OverdrawCacheSize).acmr();
+	float sortedACMR = analyzeVertexCache(result.data(), indexCount, vertexCount, OverdrawCacheSize).acmr();
+	if (sortedACMR > threshold * cacheOptimisedACMR)
+	{
+		return;
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+unsigned int MeshOptimizer::optimizeVertexFetch(unsigned char* vertices, unsigned int vertexCount, size_t stride,
+	unsigned int* indices, size_t indexCount)
+{
+	const unsigned int Unused = ~0u;
+
+	std::vector<unsigned int> remap(vertexCount, Unused);
+	unsigned int usedCount = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int& target = remap[indices[i]];
+		if (target == Unused)
+		{
+			target = usedCount++;
+		}
+		indices[i] = target;
+	}
+
+	std::vector<unsigned char> source(vertices, vertices + vertexCount * stride);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != Unused)
+		{
+			memcpy(vertices + remap[v] * stride, source.data() + v * stride, stride);
+		}
+	}
+
+	return usedCount;
+}
+
+void MeshOptimizer::optimizeChunk(std::vector<unsigned char>& vertices, const VertexLayout& layout, std::vector<unsigned int>& indices,
+	const MeshChunkData& chunk)
+{
+	unsigned int stride = layout.getStride();
+	unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+
+	if (indices.empty() || vertexCount == 0)
+	{
+		return;
+	}
+
+	// every vertex format stores the position as floats
+	unsigned int positionOffset = 0;
+	for (const VertexAttribute& attribute : layout.getAttributes())
+	{
+		if (attribute.semantic == VertexSemantic::Position)
+		{
+			assert(attribute.type == GL_FLOAT);
+			positionOffset = attribute.offset;
+		}
+	}
+
+	const float* positions = (const float*)(vertices.data() + positionOffset);
+
+	// the levels index the same vertices but are drawn on their own, so each gets its own triangle order
+	MeshLod whole = { 0, (unsigned int)indices.size(), 0.0f };
+	const MeshLod* lods = chunk.lodCount > 0 ? chunk.lods : &whole;
+	unsigned int lodCount = chunk.lodCount > 0 ? chunk.lodCount : 1;
+
+	std::vector<unsigned int> original;
+
+	for (unsigned int l = 0; l < lodCount; l++)
+	{
+		unsigned int* first = indices.data() + lods[l].firstIndex;
+		original.assign(first, first + lods[l].indexCount);
+
+		optimizeVertexCache(first, lods[l].indexCount, vertexCount);
+		optimizeOverdraw(first, lods[l].indexCount, positions, vertexCount, stride);
+
+		// exported orders can already be cache friendly, never leave one worse off than it came in
+		if (analyzeVertexCache(first, lods[l].indexCount, vertexCount).transforms >
+			analyzeVertexCache(original.data(), original.size(), vertexCount).transforms)
+		{
+			std::copy(original.begin(), original.end(), first);
+		}
+	}
+
+	// level 0 is first in the indices so its vertices get the front of the buffer, the coarser levels use a subset of them
+	unsigned int usedCount = optimizeVertexFetch(vertices.data(), vertexCount, stride, indices.data(), indices.size());
+	vertices.resize(usedCount * stride);
+}
\ No newline at end of file
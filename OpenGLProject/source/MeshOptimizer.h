@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "VertexLayout.h"
+#include "MeshData.h"
+
+// counts from running an index buffer through a simulated FIFO post transform cache
+struct VertexCacheStats
+{
+	unsigned int transforms = 0; // vertex shader runs, one per cache miss
+	unsigned int triangles = 0;
+	unsigned int vertices = 0; // distinct vertices the indices use
+
+	VertexCacheStats& operator += (const VertexCacheStats& other)
+	{
+		transforms += other.transforms;
+		triangles += other.triangles;
+		vertices += other.vertices;
+		return *this;
+	}
+
+	// average cache miss ratio, transforms per triangle (3 is no reuse at all, about 0.5 is the best a closed mesh can do)
+	float acmr() const { return triangles > 0 ? (float)transforms / triangles : 0.0f; }
+
+	// average transform to vertex ratio, transforms per vertex (1 is every vertex shaded once)
+	float atvr() const { return vertices > 0 ? (float)transforms / vertices : 0.0f; }
+};
+
+// reorders indexed triangle lists so the GPU shades, fetches and overdraws less, doesn't touch GL so tools can use it too
+namespace MeshOptimizer
+{
+	// simulate a FIFO cache of cacheSize vertices over the indices
+	VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, unsigned int vertexCount,
+		unsigned int cacheSize = 16);
+
+	// reorder the triangles so their vertices are reused while they are still in the post transform cache
+	// (Forsyth's linear speed vertex cache optimisation, the cache size doesn't need to match the hardware's)
+	void optimizeVertexCache(unsigned int* indices, size_t indexCount, unsigned int vertexCount);
+
+	// reorder cache optimised triangles so faces pointing out of the mesh draw before the ones they hide, from any view
+	// the order is cut into clusters where the cache misses anyway or where a cut costs less than threshold times the ACMR,
+	// then the clusters are sorted by how far out they face (the overdraw pass of Tipsify)
+	// the order is left alone if sorting costs more than threshold times its ACMR
+	// positions are float xyz, positionStride bytes apart
+	void optimizeOverdraw(unsigned int* indices, size_t indexCount, const float* positions, unsigned int vertexCount,
+		size_t positionStride, float threshold = 1.05f);
+
+	// move the vertices into the order the indices first use them and rewrite the indices to match,
+	// vertices no index uses are dropped, returns the new vertex count
+	unsigned int optimizeVertexFetch(unsigned char* vertices, unsigned int vertexCount, size_t stride,
+		unsigned int* indices, size_t indexCount);
+
+	// all of the above on an imported chunk, each level of detail is reordered within its own range of the indices
+	// and kept in its original order if that was better for the vertex cache
+	void optimizeChunk(std::vector<unsigned char>& vertices, const VertexLayout& layout, std::vector<unsigned int>& indices,
+		const MeshChunkData& chunk);
+}
\ No newline at end of file
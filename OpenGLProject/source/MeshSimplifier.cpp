@@ -0,0 +1,517 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+// normal xyz and uv
+const unsigned int AttributeCount = 5;
+
+// how much attribute differences count against position differences (positions are scaled into a unit box)
+const float NormalWeight = 0.5f;
+const float TexCoordWeight = 1.0f;
+
+// each level aims for this fraction of the triangles of the one before
+const float LodReduction = 0.5f;
+
+// a level keeping more than this fraction of the one before isn't worth its indices
+const float MinLodSaving = 0.8f;
+
+// chunks and levels this small aren't simplified any further
+const unsigned int MinLodTriangles = 64;
+
+// a collapse may not turn any remaining triangle further than this (cosine of the angle between its normals)
+const float MinNormalAgreement = 0.25f;
+
+// symmetric 4x4 matrix of a sum of squared distances, w is the summed weight so errors can be averaged
+struct Quadric
+{
+	float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f;
+	float a10 = 0.0f, a20 = 0.0f, a21 = 0.0f;
+	float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+	float c = 0.0f;
+	float w = 0.0f;
+
+	Quadric& operator += (const Quadric& other)
+	{
+		a00 += other.a00; a11 += other.a11; a22 += other.a22;
+		a10 += other.a10; a20 += other.a20; a21 += other.a21;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		w += other.w;
+		return *this;
+	}
+};
+
+// weighted gradient of an attribute over the triangles of a vertex, the part of an attribute quadric
+// that depends on the attribute value it is measured against
+struct AttributeGradient
+{
+	float gx = 0.0f, gy = 0.0f, gz = 0.0f, gw = 0.0f;
+
+	AttributeGradient& operator += (const AttributeGradient& other)
+	{
+		gx += other.gx; gy += other.gy; gz += other.gz; gw += other.gw;
+		return *this;
+	}
+};
+
+struct Collapse
+{
+	unsigned int from;
+	unsigned int to;
+	float error;
+};
+
+struct PositionHash
+{
+	size_t operator () (const glm::vec3& position) const
+	{
+		unsigned int bits[3];
+		std::memcpy(bits, &position[0], sizeof(bits));
+		return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+	}
+};
+
+// add w * (n.p + d)^2
+static void addPlane(Quadric& quadric, const glm::vec3& n, float d, float w)
+{
+	quadric.a00 += w * n.x * n.x;
+	quadric.a11 += w * n.y * n.y;
+	quadric.a22 += w * n.z * n.z;
+	quadric.a10 += w * n.y * n.x;
+	quadric.a20 += w * n.z * n.x;
+	quadric.a21 += w * n.z * n.y;
+	quadric.b0 += w * n.x * d;
+	quadric.b1 += w * n.y * d;
+	quadric.b2 += w * n.z * d;
+	quadric.c += w * d * d;
+	quadric.w += w;
+}
+
+// p'Ap + 2b.p + c
+static float evaluate(const Quadric& quadric, const glm::vec3& p)
+{
+	float rx = 2.0f * (quadric.b0 + quadric.a10 * p.y) + quadric.a00 * p.x;
+	float ry = 2.0f * (quadric.b1 + quadric.a21 * p.z) + quadric.a11 * p.y;
+	float rz = 2.0f * (quadric.b2 + quadric.a20 * p.x) + quadric.a22 * p.z;
+
+	return quadric.c + rx * p.x + ry * p.y + rz * p.z;
+}
+
+// average squared distance from the planes, plus the squared difference of each attribute from what
+// the surrounding triangles interpolate to at p
+static float evaluate(const Quadric& position, const Quadric& attribute, const AttributeGradient* gradients,
+	const glm::vec3& p, const float* attributes)
+{
+	float positionError = std::fabs(evaluate(position, p));
+
+	float attributeError = evaluate(attribute, p);
+	for (unsigned int k = 0; k < AttributeCount; k++)
+	{
+		const AttributeGradient& g = gradients[k];
+		float interpolated = g.gx * p.x + g.gy * p.y + g.gz * p.z + g.gw;
+
+		attributeError += attributes[k] * (attributes[k] * attribute.w - 2.0f * interpolated);
+	}
+	attributeError = std::fabs(attributeError);
+
+	return (position.w > 0.0f ? positionError / position.w : 0.0f) + (attribute.w > 0.0f ? attributeError / attribute.w : 0.0f);
+}
+
+float MeshSimplifier::simplify(const unsigned char* vertices, unsigned int vertexCount, const VertexLayout& layout,
+	const unsigned int* indices, unsigned int indexCount, unsigned int targetIndexCount, std::vector<unsigned int>& result)
+{
+	result.clear();
+
+	// positions scaled into a unit box so the error (and the attribute weights) don't depend on the model's size
+	std::vector<glm::vec3> positions(vertexCount);
+	std::vector<float> attributes((size_t)vertexCount * AttributeCount);
+
+	glm::vec3 boundsMin(FLT_MAX);
+	glm::vec3 boundsMax(-FLT_MAX);
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		const unsigned char* vertex = vertices + (size_t)v * layout.getStride();
+
+		positions[v] = glm::vec3(layout.read(vertex, VertexSemantic::Position));
+		boundsMin = glm::min(boundsMin, positions[v]);
+		boundsMax = glm::max(boundsMax, positions[v]);
+
+		glm::vec3 normal = glm::vec3(layout.read(vertex, VertexSemantic::Normal)) * NormalWeight;
+		glm::vec2 texcoord = glm::vec2(layout.read(vertex, VertexSemantic::TexCoord)) * TexCoordWeight;
+
+		float* destination = &attributes[(size_t)v * AttributeCount];
+		destination[0] = normal.x;
+		destination[1] = normal.y;
+		destination[2] = normal.z;
+		destination[3] = texcoord.x;
+		destination[4] = texcoord.y;
+	}
+
+	glm::vec3 extents = boundsMax - boundsMin;
+	float extent = std::max(extents.x, std::max(extents.y, extents.z));
+	float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+	for (glm::vec3& position : positions)
+	{
+		position = (position - boundsMin) * scale;
+	}
+
+	// triangles that are already degenerate are dropped
+	std::vector<unsigned int> current;
+	current.reserve(indexCount);
+
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		if (a != b && b != c && c != a)
+		{
+			current.push_back(a);
+			current.push_back(b);
+			current.push_back(c);
+		}
+	}
+
+	// vertices sharing a position with another (uv / normal seams) or on an open border can't move
+	std::vector<unsigned int> positionIDs(vertexCount);
+	std::unordered_map<glm::vec3, unsigned int, PositionHash> positionLookup;
+	std::vector<unsigned int> verticesAtPosition;
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		auto inserted = positionLookup.insert(std::make_pair(positions[v], (unsigned int)verticesAtPosition.size()));
+		if (inserted.second)
+		{
+			verticesAtPosition.push_back(0);
+		}
+
+		positionIDs[v] = inserted.first->second;
+		verticesAtPosition[positionIDs[v]]++;
+	}
+
+	std::unordered_set<unsigned long long> edges;
+	edges.reserve(current.size());
+
+	for (size_t i = 0; i < current.size(); i++)
+	{
+		unsigned long long a = positionIDs[current[i]];
+		unsigned long long b = positionIDs[current[i - i % 3 + (i + 1) % 3]];
+		edges.insert(a << 32 | b);
+	}
+
+	std::vector<unsigned char> lockedPositions(verticesAtPosition.size(), 0);
+
+	for (size_t i = 0; i < current.size(); i++)
+	{
+		unsigned long long a = positionIDs[current[i]];
+		unsigned long long b = positionIDs[current[i - i % 3 + (i + 1) % 3]];
+
+		// no triangle runs the other way along the edge
+		if (edges.find(b << 32 | a) == edges.end())
+		{
+			lockedPositions[(size_t)a] = 1;
+			lockedPositions[(size_t)b] = 1;
+		}
+	}
+
+	std::vector<unsigned char> locked(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		locked[v] = lockedPositions[positionIDs[v]] || verticesAtPosition[positionIDs[v]] > 1;
+	}
+
+	// every triangle adds its plane (weighted by area) and its attribute gradients to its corners
+	std::vector<Quadric> positionQuadrics(vertexCount);
+	std::vector<Quadric> attributeQuadrics(vertexCount);
+	std::vector<AttributeGradient> gradients((size_t)vertexCount * AttributeCount);
+
+	for (size_t i = 0; i < current.size(); i += 3)
+	{
+		const unsigned int corners[3] = { current[i], current[i + 1], current[i + 2] };
+		const glm::vec3& p0 = positions[corners[0]];
+
+		glm::vec3 e1 = positions[corners[1]] - p0;
+		glm::vec3 e2 = positions[corners[2]] - p0;
+		glm::vec3 normal = glm::cross(e1, e2);
+
+		float doubleArea = glm::length(normal);
+		if (doubleArea <= 0.0f)
+		{
+			continue;
+		}
+
+		float area = doubleArea * 0.5f;
+		normal /= doubleArea;
+
+		Quadric plane;
+		addPlane(plane, normal, -glm::dot(normal, p0), area);
+
+		// gradients of the barycentric coordinates of corners 1 and 2, the attributes are linear in them
+		float d00 = glm::dot(e1, e1), d01 = glm::dot(e1, e2), d11 = glm::dot(e2, e2);
+		float denominator = d00 * d11 - d01 * d01;
+		float inverse = denominator != 0.0f ? 1.0f / denominator : 0.0f;
+
+		glm::vec3 g1 = (d11 * e1 - d01 * e2) * inverse;
+		glm::vec3 g2 = (d00 * e2 - d01 * e1) * inverse;
+
+		Quadric attribute;
+		AttributeGradient triangleGradients[AttributeCount];
+
+		for (unsigned int k = 0; k < AttributeCount; k++)
+		{
+			float a0 = attributes[(size_t)corners[0] * AttributeCount + k];
+			float a1 = attributes[(size_t)corners[1] * AttributeCount + k];
+			float a2 = attributes[(size_t)corners[2] * AttributeCount + k];
+
+			glm::vec3 g = g1 * (a1 - a0) + g2 * (a2 - a0);
+			float gw = a0 - glm::dot(p0, g);
+
+			// (g.p + gw - a)^2, the terms without a go in the quadric
+			attribute.a00 += area * g.x * g.x;
+			attribute.a11 += area * g.y * g.y;
+			attribute.a22 += area * g.z * g.z;
+			attribute.a10 += area * g.y * g.x;
+			attribute.a20 += area * g.z * g.x;
+			attribute.a21 += area * g.z * g.y;
+			attribute.b0 += area * g.x * gw;
+			attribute.b1 += area * g.y * gw;
+			attribute.b2 += area * g.z * gw;
+			attribute.c += area * gw * gw;
+
+			triangleGradients[k].gx = area * g.x;
+			triangleGradients[k].gy = area * g.y;
+			triangleGradients[k].gz = area * g.z;
+			triangleGradients[k].gw = area * gw;
+		}
+		attribute.w = area;
+
+		for (unsigned int corner : corners)
+		{
+			positionQuadrics[corner] += plane;
+			attributeQuadrics[corner] += attribute;
+
+			for (unsigned int k = 0; k < AttributeCount; k++)
+			{
+				gradients[(size_t)corner * AttributeCount + k] += triangleGradients[k];
+			}
+		}
+	}
+
+	// error of moving a vertex onto another, with both their quadrics
+	auto collapseError = [&](unsigned int from, unsigned int to)
+	{
+		Quadric position = positionQuadrics[from];
+		position += positionQuadrics[to];
+		Quadric attribute = attributeQuadrics[from];
+		attribute += attributeQuadrics[to];
+
+		AttributeGradient summed[AttributeCount];
+		for (unsigned int k = 0; k < AttributeCount; k++)
+		{
+			summed[k] = gradients[(size_t)from * AttributeCount + k];
+			summed[k] += gradients[(size_t)to * AttributeCount + k];
+		}
+
+		return evaluate(position, attribute, summed, positions[to], &attributes[(size_t)to * AttributeCount]);
+	};
+
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+	std::vector<unsigned int> vertexTriangles;
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> collapseTargets(vertexCount);
+	std::vector<unsigned char> touched(vertexCount);
+
+	// whether moving a vertex would fold over any triangle that survives the collapse
+	auto foldsOver = [&](unsigned int from, unsigned int to)
+	{
+		for (unsigned int t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++)
+		{
+			const unsigned int* triangle = &current[(size_t)vertexTriangles[t] * 3];
+
+			unsigned int corner = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+			unsigned int b = triangle[(corner + 1) % 3];
+			unsigned int c = triangle[(corner + 2) % 3];
+
+			if (b == to || c == to)
+			{
+				continue;
+			}
+
+			glm::vec3 before = glm::cross(positions[b] - positions[from], positions[c] - positions[from]);
+			glm::vec3 after = glm::cross(positions[b] - positions[to], positions[c] - positions[to]);
+
+			if (glm::dot(before, after) <= MinNormalAgreement * glm::length(before) * glm::length(after))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	float worstError = 0.0f;
+
+	// each pass makes the cheapest collapses that don't touch a vertex twice, then rebuilds the triangles
+	while (current.size() > targetIndexCount)
+	{
+		unsigned int triangleCount = (unsigned int)(current.size() / 3);
+
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (unsigned int index : current)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		}
+
+		vertexTriangles.resize(current.size());
+		std::vector<unsigned int> filled(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				vertexTriangles[filled[current[t * 3 + corner]]++] = t;
+			}
+		}
+
+		// an inner edge is in two triangles running opposite ways, only the one where it runs from the lower index adds it
+		collapses.clear();
+		for (size_t i = 0; i < current.size(); i++)
+		{
+			unsigned int a = current[i];
+			unsigned int b = current[i - i % 3 + (i + 1) % 3];
+
+			if (a > b || (locked[a] && locked[b]))
+			{
+				continue;
+			}
+
+			float errorAB = locked[a] ? FLT_MAX : collapseError(a, b);
+			float errorBA = locked[b] ? FLT_MAX : collapseError(b, a);
+
+			if (errorAB <= errorBA)
+				collapses.push_back({ a, b, errorAB });
+			else
+				collapses.push_back({ b, a, errorBA });
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) { return left.error < right.error; });
+
+		// a collapse removes about two triangles, and the pass stops well before the errors climb past what it needs
+		size_t goal = (current.size() - targetIndexCount) / 6 + 1;
+		float errorLimit = goal < collapses.size() ? collapses[goal].error * 1.5f : FLT_MAX;
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			collapseTargets[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), 0);
+
+		size_t made = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (made >= goal || collapse.error > errorLimit)
+			{
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to] || foldsOver(collapse.from, collapse.to))
+			{
+				continue;
+			}
+
+			touched[collapse.from] = 1;
+			touched[collapse.to] = 1;
+			collapseTargets[collapse.from] = collapse.to;
+
+			positionQuadrics[collapse.to] += positionQuadrics[collapse.from];
+			attributeQuadrics[collapse.to] += attributeQuadrics[collapse.from];
+			for (unsigned int k = 0; k < AttributeCount; k++)
+			{
+				gradients[(size_t)collapse.to * AttributeCount + k] += gradients[(size_t)collapse.from * AttributeCount + k];
+			}
+
+			worstError = std::max(worstError, collapse.error);
+			made++;
+		}
+
+		if (made == 0)
+		{
+			break;
+		}
+
+		// move the collapsed corners and drop the triangles that lost an edge
+		size_t write = 0;
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			unsigned int a = collapseTargets[current[i]];
+			unsigned int b = collapseTargets[current[i + 1]];
+			unsigned int c = collapseTargets[current[i + 2]];
+
+			if (a != b && b != c && c != a)
+			{
+				current[write++] = a;
+				current[write++] = b;
+				current[write++] = c;
+			}
+		}
+		current.resize(write);
+	}
+
+	result.swap(current);
+
+	// back to object space units
+	return std::sqrt(worstError) * extent;
+}
+
+// append coarser levels of detail to a chunk's indices, each about half the last, and fill in the chunk's lods
+void MeshSimplifier::generateLods(const std::vector<unsigned char>& vertices, const VertexLayout& layout, std::vector<unsigned int>& indices,
+	MeshChunkData& chunk)
+{
+	unsigned int vertexCount = (unsigned int)(vertices.size() / layout.getStride());
+
+	chunk.lods[0] = MeshLod();
+	chunk.lods[0].indexCount = (unsigned int)indices.size();
+	chunk.lodCount = 1;
+
+	if (indices.size() / 3 < MinLodTriangles * 2)
+	{
+		return;
+	}
+
+	// each level is simplified from the one before, so its error adds up along the chain
+	std::vector<unsigned int> source(indices);
+	std::vector<unsigned int> simplified;
+	float error = 0.0f;
+
+	while (chunk.lodCount < MaxMeshLods && source.size() / 3 >= MinLodTriangles * 2)
+	{
+		unsigned int target = (unsigned int)(source.size() / 3 * LodReduction) * 3;
+
+		error += simplify(vertices.data(), vertexCount, layout, source.data(), (unsigned int)source.size(), target, simplified);
+
+		if (simplified.empty() || simplified.size() > source.size() * MinLodSaving)
+		{
+			break;
+		}
+
+		MeshLod& lod = chunk.lods[chunk.lodCount++];
+		lod.firstIndex = (unsigned int)indices.size();
+		lod.indexCount = (unsigned int)simplified.size();
+		lod.error = error;
+
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		source.swap(simplified);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include "VertexLayout.h"
+#include "MeshData.h"
+
+// reduces the triangle count of indexed meshes for levels of detail, doesn't touch GL so tools can use it too
+namespace MeshSimplifier
+{
+	// collapse edges of a triangle list until it is down to about targetIndexCount indices
+	// every vertex is collapsed onto one of its neighbours, so the result indexes the same vertices
+	// the cost of a collapse is a quadric error over position, normal and uv, seams and open borders are kept
+	// returns the object space error of the result
+	float simplify(const unsigned char* vertices, unsigned int vertexCount, const VertexLayout& layout,
+		const unsigned int* indices, unsigned int indexCount, unsigned int targetIndexCount, std::vector<unsigned int>& result);
+
+	// append coarser levels of detail to a chunk's indices, each about half the last, and fill in the chunk's lods
+	void generateLods(const std::vector<unsigned char>& vertices, const VertexLayout& layout, std::vector<unsigned int>& indices,
+		MeshChunkData& chunk);
+}
\ No newline at end of file
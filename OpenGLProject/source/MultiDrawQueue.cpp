@@ -0,0 +1,154 @@
+#include "MultiDrawQueue.h"
+#include <glad\glad.h>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "MaterialTable.h"
+#include "MaterialTextureTable.h"
+#include "RenderStats.h"
+
+MultiDrawQueue::~MultiDrawQueue()
+{
+	unsigned int* buffers[] = { &m_commandBuffer, &m_drawDataBuffer, &m_boundsBuffer };
+
+	for (unsigned int* buffer : buffers)
+	{
+		if (*buffer != 0)
+		{
+			GL_TRACK_DELETED(GLObjectType::Buffer, *buffer);
+			glDeleteBuffers(1, buffer);
+		}
+	}
+}
+
+// start a new frame of draws
+void MultiDrawQueue::begin()
+{
+	m_draws.clear();
+}
+
+void MultiDrawQueue::submit(const Material* material, const GeometryAllocation& geometry, const glm::mat4& transform,
+	const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	if (material == nullptr)
+	{
+		// the shared defaults are only picked up once a draw needs them
+		if (m_defaultMaterial.diffuseTexture == nullptr)
+		{
+			m_defaultMaterial.setDefaultTextures();
+		}
+
+		material = &m_defaultMaterial;
+	}
+
+	Draw draw;
+	draw.material = material;
+	draw.geometry = geometry;
+	draw.transform = transform;
+	draw.boundsMin = boundsMin;
+	draw.boundsMax = boundsMax;
+
+	m_draws.push_back(draw);
+}
+
+// draw everything submitted since begin with a shader reading the draw / material buffers
+void MultiDrawQueue::flush(Shader& shader, GeometryPool& pool, OcclusionCuller* culler)
+{
+	if (m_draws.empty())
+	{
+		return;
+	}
+
+	// build the commands and per draw data, the materials go in the frame's material table
+	m_commands.clear();
+	m_drawData.clear();
+	m_bounds.clear();
+
+	MaterialTable& materialTable = MaterialTable::getInstance();
+	FrameStats& stats = RenderStats::getInstance().current();
+
+	for (const Draw& draw : m_draws)
+	{
+		GPUDrawData data = {};
+		data.model = draw.transform;
+
+		// the shaders find the textures through the material, so nothing is bound per material
+		data.materialIndex = materialTable.add(*draw.material, true);
+
+		// baseInstance selects the draw id the vertex shader reads (see GeometryPool::DrawIDAttribute)
+		DrawElementsIndirectCommand command;
+		command.count = draw.geometry.indexCount;
+		command.instanceCount = 1;
+		command.firstIndex = draw.geometry.firstIndex;
+		command.baseVertex = (int)draw.geometry.baseVertex;
+		command.baseInstance = (unsigned int)m_drawData.size();
+
+		m_drawData.push_back(data);
+		m_commands.push_back(command);
+
+		stats.triangles += command.count / 3;
+
+		if (culler != nullptr)
+		{
+			GPUDrawBounds bounds;
+			bounds.center = glm::vec4((draw.boundsMin + draw.boundsMax) * 0.5f, 0.0f);
+			bounds.extents = glm::vec4((draw.boundsMax - draw.boundsMin) * 0.5f, 0.0f);
+
+			m_bounds.push_back(bounds);
+		}
+	}
+
+	upload(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer, m_commandCapacity,
+		m_commands.data(), m_commands.size() * sizeof(DrawElementsIndirectCommand));
+	upload(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer, m_drawDataCapacity,
+		m_drawData.data(), m_drawData.size() * sizeof(GPUDrawData));
+	materialTable.upload();
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::DrawData, m_drawDataBuffer);
+
+	// the culling pass sets the instance count of each command to 0 or 1
+	if (culler != nullptr)
+	{
+		upload(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer, m_boundsCapacity,
+			m_bounds.data(), m_bounds.size() * sizeof(GPUDrawBounds));
+
+		culler->cull(m_commandBuffer, m_drawDataBuffer, m_boundsBuffer, (unsigned int)m_commands.size());
+	}
+
+	pool.reserveDrawIDs(m_commands.size());
+
+	shader.bind();
+	GLState::getInstance().bindVertexArray(pool.getVertexArray());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+
+	// every material reaches its textures through the table, so everything goes in one multi draw
+	MaterialTextureTable::getInstance().bind();
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)m_commands.size(), 0);
+	stats.drawCalls++;
+	stats.indirectDraws += (unsigned int)m_commands.size();
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	m_draws.clear();
+}
+
+// respecify a streaming buffer (orphaning the old storage) and fill it
+void MultiDrawQueue::upload(GLenum target, unsigned int& buffer, size_t& capacity, const void* data, size_t size)
+{
+	if (buffer == 0)
+	{
+		glGenBuffers(1, &buffer);
+		GL_TRACK_CREATED(GLObjectType::Buffer, buffer, "MultiDrawQueue");
+	}
+
+	if (size > capacity)
+	{
+		capacity = size + size / 2;
+	}
+
+	glBindBuffer(target, buffer);
+	glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(target, 0, size, data);
+	glBindBuffer(target, 0);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <vector>
+#include "Shader.h"
+#include "Material.h"
+#include "GeometryPool.h"
+#include "OcclusionCuller.h"
+
+// per draw constants as laid out in the std430 draw buffer of the indirect shaders
+struct GPUDrawData
+{
+	glm::mat4 model;
+	unsigned int materialIndex;
+	unsigned int padding[3];
+};
+static_assert(sizeof(GPUDrawData) == 80, "GPUDrawData must match the std430 layout in the shaders");
+
+// collects draws of geometry pool allocations and submits them with glMultiDrawElementsIndirect
+// the model matrix and material index of every draw come from shader storage buffers (the materials from the
+// MaterialTable) and the materials reference their textures through the MaterialTextureTable, so a frame of draws is a single multi draw
+class MultiDrawQueue
+{
+public:
+
+	MultiDrawQueue() {};
+	~MultiDrawQueue();
+
+	MultiDrawQueue(const MultiDrawQueue&) = delete;
+	MultiDrawQueue& operator = (const MultiDrawQueue&) = delete;
+
+	// start a new frame of draws
+	void begin();
+
+	// material may be null to use plain white, the object space bounds are what the GPU culls against
+	void submit(const Material* material, const GeometryAllocation& geometry, const glm::mat4& transform,
+		const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+	// draw everything submitted since begin with a shader reading the draw / material buffers (e.g. phongIndirect)
+	// with a culler the draws that can't be seen are dropped on the GPU first
+	void flush(Shader& shader, GeometryPool& pool, OcclusionCuller* culler = nullptr);
+
+	size_t size() const { return m_draws.size(); }
+
+private:
+
+	// layout of a glMultiDrawElementsIndirect command
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	struct Draw
+	{
+		const Material* material;
+		GeometryAllocation geometry;
+		glm::mat4 transform;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// respecify a streaming buffer (orphaning the old storage) and fill it
+	static void upload(GLenum target, unsigned int& buffer, size_t& capacity, const void* data, size_t size);
+
+	std::vector<Draw> m_draws;
+
+	// CPU copies of the buffer contents
+	std::vector<DrawElementsIndirectCommand> m_commands;
+	std::vector<GPUDrawData> m_drawData;
+	std::vector<GPUDrawBounds> m_bounds;
+
+	unsigned int m_commandBuffer = 0;
+	unsigned int m_drawDataBuffer = 0;
+	unsigned int m_boundsBuffer = 0;
+	size_t m_commandCapacity = 0;
+	size_t m_drawDataCapacity = 0;
+	size_t m_boundsCapacity = 0;
+
+	// used for draws without a material
+	Material m_defaultMaterial;
+};
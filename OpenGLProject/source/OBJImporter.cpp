@@ -0,0 +1,955 @@
+#include "OBJImporter.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <glm\geometric.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+// files are split into ranges of about this size so there are enough to keep every worker busy
+static const size_t RangeSize = 1 << 20;
+
+// attribute slots of a face corner
+static const int AttributePosition = 0;
+static const int AttributeTexcoord = 1;
+static const int AttributeNormal = 2;
+
+// corner of a triangle, zero based indices into the whole file's attribute arrays (-1 if not given)
+// negative (relative) obj indices are kept relative to the range until the counts of the earlier ranges are known
+struct FaceVertex
+{
+	int index[3];
+	unsigned int relativeMask;
+};
+
+// g, o or usemtl line, each of them starts a new shape
+struct ShapeEvent
+{
+	size_t firstCorner;
+	bool isMaterial;
+	std::string name;
+};
+
+// everything read from one line aligned range of the obj
+struct ParsedRange
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texcoords;
+	std::vector<glm::vec3> normals;
+
+	// faces fan triangulated, 3 corners per triangle
+	std::vector<FaceVertex> corners;
+	bool hasRelativeIndices = false;
+
+	std::vector<ShapeEvent> events;
+	std::vector<std::string> libraries;
+
+	// index of this range's first attribute of each kind in the whole file
+	int base[3] = {};
+};
+
+// part of a range's corners belonging to a shape
+struct ShapeSpan
+{
+	unsigned int range;
+	size_t firstCorner;
+	size_t endCorner;
+};
+
+struct ShapeSource
+{
+	int materialID;
+	std::vector<ShapeSpan> spans;
+};
+
+static inline bool isSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char* skipSpace(const char* p, const char* end)
+{
+	while (p < end && isSpace(*p))
+	{
+		p++;
+	}
+	return p;
+}
+
+// true if the line starts with the keyword followed by a space
+static inline bool isKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+	return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && isSpace(p[length]);
+}
+
+// the next whitespace separated token
+static std::string parseToken(const char*& p, const char* end)
+{
+	p = skipSpace(p, end);
+	const char* start = p;
+	while (p < end && !isSpace(*p))
+	{
+		p++;
+	}
+	return std::string(start, p);
+}
+
+// the rest of the line, texture names may contain spaces
+static std::string parseRest(const char* p, const char* end)
+{
+	p = skipSpace(p, end);
+	while (end > p && isSpace(end[-1]))
+	{
+		end--;
+	}
+	return std::string(p, end);
+}
+
+static int parseInt(const char*& p, const char* end)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	int value = 0;
+	while (p < end && isDigit(*p))
+	{
+		value = value * 10 + (*p++ - '0');
+	}
+
+	return negative ? -value : value;
+}
+
+// decimal float without going through the locale aware strtod, 19 significant digits is plenty for a float
+static float parseFloat(const char*& p, const char* end)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	p = skipSpace(p, end);
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+
+	while (p < end && isDigit(*p))
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			exponent++;
+		}
+		p++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && isDigit(*p))
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+			p++;
+		}
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		exponent += parseInt(p, end);
+	}
+
+	// skip anything else in the token (nan, inf etc. read as 0)
+	while (p < end && !isSpace(*p))
+	{
+		p++;
+	}
+
+	double value = (double)mantissa;
+	if (exponent < 0)
+	{
+		value = -exponent <= 22 ? value / powers[-exponent] : value * std::pow(10.0, exponent);
+	}
+	else if (exponent > 0)
+	{
+		value = exponent <= 22 ? value * powers[exponent] : value * std::pow(10.0, exponent);
+	}
+
+	return (float)(negative ? -value : value);
+}
+
+// one index of a face corner, converted to zero based
+static void parseIndex(const char*& p, const char* end, ParsedRange& range, int attribute, FaceVertex& vertex)
+{
+	int value = parseInt(p, end);
+
+	if (value > 0)
+	{
+		vertex.index[attribute] = value - 1;
+	}
+	else if (value < 0)
+	{
+		int count = attribute == AttributePosition ? (int)range.positions.size() :
+			attribute == AttributeTexcoord ? (int)range.texcoords.size() : (int)range.normals.size();
+
+		// the range's base index is added once it is known
+		vertex.index[attribute] = count + value;
+		vertex.relativeMask |= 1 << attribute;
+		range.hasRelativeIndices = true;
+	}
+	else
+	{
+		vertex.index[attribute] = 0;
+	}
+}
+
+// face corner: v, v/vt, v//vn or v/vt/vn
+static bool parseFaceVertex(const char*& p, const char* end, ParsedRange& range, FaceVertex& vertex)
+{
+	p = skipSpace(p, end);
+	if (p >= end || !(isDigit(*p) || *p == '-' || *p == '+'))
+	{
+		return false;
+	}
+
+	vertex.index[AttributePosition] = -1;
+	vertex.index[AttributeTexcoord] = -1;
+	vertex.index[AttributeNormal] = -1;
+	vertex.relativeMask = 0;
+
+	parseIndex(p, end, range, AttributePosition, vertex);
+
+	if (p < end && *p == '/')
+	{
+		p++;
+		if (p < end && *p != '/')
+		{
+			parseIndex(p, end, range, AttributeTexcoord, vertex);
+		}
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			parseIndex(p, end, range, AttributeNormal, vertex);
+		}
+	}
+
+	// skip whatever is left of a malformed corner
+	while (p < end && !isSpace(*p))
+	{
+		p++;
+	}
+
+	return true;
+}
+
+static void parseLine(const char* p, const char* end, ParsedRange& range)
+{
+	p = skipSpace(p, end);
+	if (end - p < 2)
+	{
+		return;
+	}
+
+	if (p[0] == 'v')
+	{
+		if (isSpace(p[1]))
+		{
+			p += 2;
+			float x = parseFloat(p, end);
+			float y = parseFloat(p, end);
+			float z = parseFloat(p, end);
+			range.positions.push_back(glm::vec3(x, y, z));
+		}
+		else if (p[1] == 't' && isKeyword(p, end, "vt", 2))
+		{
+			p += 3;
+			float u = parseFloat(p, end);
+			float v = parseFloat(p, end);
+			range.texcoords.push_back(glm::vec2(u, v));
+		}
+		else if (p[1] == 'n' && isKeyword(p, end, "vn", 2))
+		{
+			p += 3;
+			float x = parseFloat(p, end);
+			float y = parseFloat(p, end);
+			float z = parseFloat(p, end);
+			range.normals.push_back(glm::vec3(x, y, z));
+		}
+	}
+	else if (p[0] == 'f' && isSpace(p[1]))
+	{
+		p += 2;
+
+		// triangle fan around the first corner
+		FaceVertex first, previous, current;
+		if (!parseFaceVertex(p, end, range, first) || !parseFaceVertex(p, end, range, previous))
+		{
+			return;
+		}
+
+		while (parseFaceVertex(p, end, range, current))
+		{
+			range.corners.push_back(first);
+			range.corners.push_back(previous);
+			range.corners.push_back(current);
+			previous = current;
+		}
+	}
+	else if ((p[0] == 'g' || p[0] == 'o') && isSpace(p[1]))
+	{
+		p += 2;
+		ShapeEvent event;
+		event.firstCorner = range.corners.size();
+		event.isMaterial = false;
+		event.name = parseToken(p, end);
+		range.events.push_back(event);
+	}
+	else if (isKeyword(p, end, "usemtl", 6))
+	{
+		p += 7;
+		ShapeEvent event;
+		event.firstCorner = range.corners.size();
+		event.isMaterial = true;
+		event.name = parseToken(p, end);
+		range.events.push_back(event);
+	}
+	else if (isKeyword(p, end, "mtllib", 6))
+	{
+		p += 7;
+		range.libraries.push_back(parseToken(p, end));
+	}
+}
+
+static glm::vec3 parseVec3(const char* p, const char* end)
+{
+	float x = parseFloat(p, end);
+	float y = parseFloat(p, end);
+	float z = parseFloat(p, end);
+	return glm::vec3(x, y, z);
+}
+
+// read the materials of an mtl file, names already in the lookup keep their first definition
+static bool importMaterials(const std::string& filename, std::vector<MeshMaterialData>& materials, std::unordered_map<std::string, int>& lookup)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		printf("Failed to open material library %s\n", filename.c_str());
+		return false;
+	}
+
+	const char* text = (const char*)file.data();
+	const char* end = text + file.size();
+
+	// properties before the first newmtl go nowhere
+	MeshMaterialData unnamed;
+	MeshMaterialData* material = &unnamed;
+
+	for (const char* line = text; line < end;)
+	{
+		const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+		if (lineEnd == nullptr)
+		{
+			lineEnd = end;
+		}
+
+		const char* next = lineEnd + 1;
+		if (lineEnd > line && lineEnd[-1] == '\r')
+		{
+			lineEnd--;
+		}
+
+		const char* p = skipSpace(line, lineEnd);
+		line = next;
+
+		if (isKeyword(p, lineEnd, "newmtl", 6))
+		{
+			p += 7;
+			lookup.emplace(parseToken(p, lineEnd), (int)materials.size());
+
+			// mtl defaults rather than MeshMaterialData's, a missing Kd means black
+			materials.emplace_back();
+			material = &materials.back();
+			material->ambient = glm::vec3(0);
+			material->diffuse = glm::vec3(0);
+			material->specular = glm::vec3(0);
+			material->specularPower = 1.0f;
+		}
+		else if (isKeyword(p, lineEnd, "Ka", 2))
+			material->ambient = parseVec3(p + 3, lineEnd);
+		else if (isKeyword(p, lineEnd, "Kd", 2))
+			material->diffuse = parseVec3(p + 3, lineEnd);
+		else if (isKeyword(p, lineEnd, "Ks", 2))
+			material->specular = parseVec3(p + 3, lineEnd);
+		else if (isKeyword(p, lineEnd, "Ke", 2))
+			material->emissive = parseVec3(p + 3, lineEnd);
+		else if (isKeyword(p, lineEnd, "Ns", 2))
+		{
+			p += 3;
+			material->specularPower = parseFloat(p, lineEnd);
+		}
+		else if (isKeyword(p, lineEnd, "d", 1))
+		{
+			p += 2;
+			material->opacity = parseFloat(p, lineEnd);
+		}
+		else if (isKeyword(p, lineEnd, "Tr", 2))
+		{
+			p += 3;
+			material->opacity = 1.0f - parseFloat(p, lineEnd);
+		}
+		// texture names in Material slot order
+		else if (isKeyword(p, lineEnd, "map_Kd", 6))
+			material->textures[0] = parseRest(p + 7, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_d", 5))
+			material->textures[1] = parseRest(p + 6, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_Ka", 6))
+			material->textures[2] = parseRest(p + 7, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_Ks", 6))
+			material->textures[3] = parseRest(p + 7, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_Ns", 6))
+			material->textures[4] = parseRest(p + 7, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_bump", 8) || isKeyword(p, lineEnd, "map_Bump", 8))
+			material->textures[5] = parseRest(p + 9, lineEnd);
+		else if (isKeyword(p, lineEnd, "bump", 4) || isKeyword(p, lineEnd, "disp", 4))
+			material->textures[p[0] == 'b' ? 5 : 6] = parseRest(p + 5, lineEnd);
+		else if (isKeyword(p, lineEnd, "map_Ke", 6))
+			material->textures[7] = parseRest(p + 7, lineEnd);
+	}
+
+	return true;
+}
+
+static inline size_t hashFaceVertex(const FaceVertex& vertex)
+{
+	unsigned int hash = (unsigned int)vertex.index[AttributePosition] * 0x9E3779B1u;
+	hash ^= (unsigned int)vertex.index[AttributeTexcoord] * 0x85EBCA77u + (hash << 6) + (hash >> 2);
+	hash ^= (unsigned int)vertex.index[AttributeNormal] * 0xC2B2AE3Du + (hash << 6) + (hash >> 2);
+	return hash ^ (hash >> 15);
+}
+
+// marks an unused slot of a VertexLookup
+static const unsigned int EmptySlot = 0xFFFFFFFF;
+
+// open addressing table from (position, texcoord, normal) to the shape's vertex index
+class VertexLookup
+{
+public:
+
+	explicit VertexLookup(size_t expectedCount)
+	{
+		size_t capacity = 64;
+		while (capacity < expectedCount * 2)
+		{
+			capacity *= 2;
+		}
+		m_table.assign(capacity, EmptySlot);
+	}
+
+	// index of the vertex, adding it if it hasn't been seen
+	unsigned int find(const FaceVertex& vertex)
+	{
+		size_t mask = m_table.size() - 1;
+		size_t slot = hashFaceVertex(vertex) & mask;
+
+		while (m_table[slot] != EmptySlot)
+		{
+			const FaceVertex& key = m_keys[m_table[slot]];
+			if (key.index[0] == vertex.index[0] && key.index[1] == vertex.index[1] && key.index[2] == vertex.index[2])
+			{
+				return m_table[slot];
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		unsigned int index = (unsigned int)m_keys.size();
+		m_keys.push_back(vertex);
+		m_table[slot] = index;
+
+		// keep it at most half full
+		if (m_keys.size() * 2 > m_table.size())
+		{
+			grow();
+		}
+
+		return index;
+	}
+
+	const std::vector<FaceVertex>& getVertices() const { return m_keys; }
+
+private:
+
+	void grow()
+	{
+		m_table.assign(m_table.size() * 2, EmptySlot);
+
+		size_t mask = m_table.size() - 1;
+		for (unsigned int i = 0; i < (unsigned int)m_keys.size(); i++)
+		{
+			size_t slot = hashFaceVertex(m_keys[i]) & mask;
+			while (m_table[slot] != EmptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			m_table[slot] = i;
+		}
+	}
+
+	std::vector<unsigned int> m_table;
+	std::vector<FaceVertex> m_keys;
+};
+
+// attributes of the whole file once the ranges are gathered
+struct OBJAttributes
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texcoords;
+	std::vector<glm::vec3> normals;
+};
+
+// bounds of a chunk and how far its uvs move per unit of surface, from the total uv and surface areas
+static void measureShape(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, MeshChunkData& chunk)
+{
+	chunk.boundsMin = glm::vec3(FLT_MAX);
+	chunk.boundsMax = glm::vec3(-FLT_MAX);
+	for (const Vertex& vertex : vertices)
+	{
+		chunk.boundsMin = glm::min(chunk.boundsMin, glm::vec3(vertex.position));
+		chunk.boundsMax = glm::max(chunk.boundsMax, glm::vec3(vertex.position));
+	}
+
+	// a sphere around the box center is usually tighter than the box's own (half the diagonal)
+	glm::vec3 center = (chunk.boundsMin + chunk.boundsMax) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (const Vertex& vertex : vertices)
+	{
+		glm::vec3 offset = glm::vec3(vertex.position) - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	chunk.boundsRadius = std::sqrt(radiusSquared);
+
+	double surfaceArea = 0.0;
+	double uvArea = 0.0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const Vertex& a = vertices[indices[i]];
+		const Vertex& b = vertices[indices[i + 1]];
+		const Vertex& c = vertices[indices[i + 2]];
+
+		surfaceArea += 0.5 * glm::length(glm::cross(glm::vec3(b.position - a.position), glm::vec3(c.position - a.position)));
+
+		glm::vec2 uv1 = b.texcoord - a.texcoord;
+		glm::vec2 uv2 = c.texcoord - a.texcoord;
+		uvArea += 0.5 * std::abs(uv1.x * uv2.y - uv1.y * uv2.x);
+	}
+
+	chunk.uvDensity = surfaceArea > 0.0 ? (float)std::sqrt(uvArea / surfaceArea) : 0.0f;
+}
+
+// dedup the corners of a shape into indexed vertices, then pack them in the mesh's layout
+// returns the number of triangles dropped for referencing a position that doesn't exist
+static unsigned int buildShape(const ShapeSource& shape, const std::vector<ParsedRange>& ranges, const OBJAttributes& attributes,
+	const VertexLayout& layout, std::vector<unsigned char>& packedVertices, std::vector<unsigned int>& indices, MeshChunkData& chunk)
+{
+	size_t cornerCount = 0;
+	for (const ShapeSpan& span : shape.spans)
+	{
+		cornerCount += span.endCorner - span.firstCorner;
+	}
+
+	// closed meshes share each vertex between several triangles, start from a guess and let the table grow
+	VertexLookup lookup(cornerCount / 4);
+	indices.reserve(cornerCount);
+
+	int positionCount = (int)attributes.positions.size();
+	int texcoordCount = (int)attributes.texcoords.size();
+	int normalCount = (int)attributes.normals.size();
+
+	unsigned int dropped = 0;
+	for (const ShapeSpan& span : shape.spans)
+	{
+		const FaceVertex* corners = ranges[span.range].corners.data();
+
+		for (size_t c = span.firstCorner; c + 2 < span.endCorner; c += 3)
+		{
+			bool valid = true;
+			for (int i = 0; i < 3; i++)
+			{
+				int position = corners[c + i].index[AttributePosition];
+				valid &= position >= 0 && position < positionCount;
+			}
+
+			if (!valid)
+			{
+				dropped++;
+				continue;
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				// a bad texcoord / normal index counts as not given
+				FaceVertex corner = corners[c + i];
+				if (corner.index[AttributeTexcoord] >= texcoordCount)
+					corner.index[AttributeTexcoord] = -1;
+				if (corner.index[AttributeNormal] >= normalCount)
+					corner.index[AttributeNormal] = -1;
+				corner.relativeMask = 0;
+
+				indices.push_back(lookup.find(corner));
+			}
+		}
+	}
+
+	const std::vector<FaceVertex>& keys = lookup.getVertices();
+	std::vector<Vertex> vertices(keys.size());
+
+	bool hasNormal = false;
+	bool hasTexture = false;
+
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		const FaceVertex& key = keys[i];
+		vertices[i].position = glm::vec4(attributes.positions[key.index[AttributePosition]], 1);
+
+		if (key.index[AttributeNormal] >= 0)
+		{
+			vertices[i].normal = glm::vec4(attributes.normals[key.index[AttributeNormal]], 0);
+			hasNormal = true;
+		}
+
+		if (key.index[AttributeTexcoord] >= 0)
+		{
+			vertices[i].texcoord = attributes.texcoords[key.index[AttributeTexcoord]];
+			hasTexture = true;
+		}
+	}
+
+	// calculate for normal mapping
+	if (hasNormal && hasTexture)
+	{
+		OBJImporter::calculateTangents(vertices, indices);
+	}
+
+	if (!vertices.empty())
+	{
+		measureShape(vertices, indices, chunk);
+	}
+
+	// convert the vertices to the requested layout
+	layout.pack(vertices.data(), vertices.size(), packedVertices);
+
+	return dropped;
+}
+
+// parse an obj file and convert its vertices to the given format
+bool OBJImporter::import(const std::string& filename, VertexFormat format, MeshData& data, ThreadPool& pool)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		printf("Failed to open %s\n", filename.c_str());
+		return false;
+	}
+
+	const char* text = (const char*)file.data();
+	size_t size = file.size();
+
+	// split the file into ranges that each start at the beginning of a line
+	size_t rangeCount = std::max<size_t>(1, (size + RangeSize - 1) / RangeSize);
+	std::vector<size_t> rangeStarts(rangeCount + 1, size);
+	rangeStarts[0] = 0;
+
+	for (size_t i = 1; i < rangeCount; i++)
+	{
+		size_t start = std::max(size * i / rangeCount, rangeStarts[i - 1]);
+		const char* lineEnd = (const char*)memchr(text + start, '\n', size - start);
+		rangeStarts[i] = lineEnd != nullptr ? (size_t)(lineEnd - text) + 1 : size;
+	}
+
+	std::vector<ParsedRange> ranges(rangeCount);
+
+	pool.parallelFor((unsigned int)rangeCount, [&](unsigned int index)
+	{
+		const char* line = text + rangeStarts[index];
+		const char* end = text + rangeStarts[index + 1];
+
+		while (line < end)
+		{
+			const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+			if (lineEnd == nullptr)
+			{
+				lineEnd = end;
+			}
+
+			const char* next = lineEnd + 1;
+			if (lineEnd > line && lineEnd[-1] == '\r')
+			{
+				lineEnd--;
+			}
+
+			parseLine(line, lineEnd, ranges[index]);
+			line = next;
+		}
+	});
+
+	// each range's attributes follow the ones before it
+	int counts[3] = {};
+	for (ParsedRange& range : ranges)
+	{
+		range.base[AttributePosition] = counts[AttributePosition];
+		range.base[AttributeTexcoord] = counts[AttributeTexcoord];
+		range.base[AttributeNormal] = counts[AttributeNormal];
+
+		counts[AttributePosition] += (int)range.positions.size();
+		counts[AttributeTexcoord] += (int)range.texcoords.size();
+		counts[AttributeNormal] += (int)range.normals.size();
+	}
+
+	OBJAttributes attributes;
+	attributes.positions.resize(counts[AttributePosition]);
+	attributes.texcoords.resize(counts[AttributeTexcoord]);
+	attributes.normals.resize(counts[AttributeNormal]);
+
+	// gather the attributes and resolve the relative indices
+	pool.parallelFor((unsigned int)rangeCount, [&](unsigned int index)
+	{
+		ParsedRange& range = ranges[index];
+
+		std::copy(range.positions.begin(), range.positions.end(), attributes.positions.begin() + range.base[AttributePosition]);
+		std::copy(range.texcoords.begin(), range.texcoords.end(), attributes.texcoords.begin() + range.base[AttributeTexcoord]);
+		std::copy(range.normals.begin(), range.normals.end(), attributes.normals.begin() + range.base[AttributeNormal]);
+
+		std::vector<glm::vec3>().swap(range.positions);
+		std::vector<glm::vec2>().swap(range.texcoords);
+		std::vector<glm::vec3>().swap(range.normals);
+
+		if (range.hasRelativeIndices)
+		{
+			for (FaceVertex& corner : range.corners)
+			{
+				for (int attribute = 0; attribute < 3; attribute++)
+				{
+					if (corner.relativeMask & (1 << attribute))
+					{
+						corner.index[attribute] += range.base[attribute];
+					}
+				}
+				corner.relativeMask = 0;
+			}
+		}
+	});
+
+	// material libraries are resolved relative to the obj's folder
+	std::string folder = filename.substr(0, filename.find_last_of("\\/") + 1);
+
+	std::vector<MeshMaterialData> materials;
+	std::unordered_map<std::string, int> materialLookup;
+
+	for (const ParsedRange& range : ranges)
+	{
+		for (const std::string& library : range.libraries)
+		{
+			importMaterials(folder + library, materials, materialLookup);
+		}
+	}
+
+	// a g, o or usemtl line starts a new shape, the material carries on across groups
+	std::vector<ShapeSource> shapes;
+	ShapeSource shape;
+	shape.materialID = -1;
+
+	for (unsigned int r = 0; r < (unsigned int)rangeCount; r++)
+	{
+		const ParsedRange& range = ranges[r];
+		size_t start = 0;
+
+		for (const ShapeEvent& event : range.events)
+		{
+			if (event.firstCorner > start)
+			{
+				shape.spans.push_back({ r, start, event.firstCorner });
+			}
+			start = event.firstCorner;
+
+			if (!shape.spans.empty())
+			{
+				shapes.push_back(shape);
+				shape.spans.clear();
+			}
+
+			if (event.isMaterial)
+			{
+				auto material = materialLookup.find(event.name);
+				shape.materialID = material != materialLookup.end() ? material->second : -1;
+			}
+		}
+
+		if (range.corners.size() > start)
+		{
+			shape.spans.push_back({ r, start, range.corners.size() });
+		}
+	}
+
+	if (!shape.spans.empty())
+	{
+		shapes.push_back(shape);
+	}
+
+	data.format = format;
+	data.materials = std::move(materials);
+
+	// sized up front so the chunk pointers stay valid
+	data.chunks.resize(shapes.size());
+	data.ownedVertices.resize(shapes.size());
+	data.ownedIndices.resize(shapes.size());
+
+	const VertexLayout& layout = VertexLayout::get(format);
+	std::atomic<unsigned int> dropped(0);
+
+	// vertex cache behaviour of each shape's full detail triangles in file order and once reordered
+	std::vector<VertexCacheStats> fileOrder(shapes.size());
+	std::vector<VertexCacheStats> optimised(shapes.size());
+
+	pool.parallelFor((unsigned int)shapes.size(), [&](unsigned int index)
+	{
+		MeshChunkData& chunk = data.chunks[index];
+		dropped += buildShape(shapes[index], ranges, attributes, layout, data.ownedVertices[index], data.ownedIndices[index], chunk);
+
+		// the coarser levels go after the full mesh's indices, the cache keeps them so this only runs on import
+		MeshSimplifier::generateLods(data.ownedVertices[index], layout, data.ownedIndices[index], chunk);
+
+		std::vector<unsigned char>& vertices = data.ownedVertices[index];
+		std::vector<unsigned int>& indices = data.ownedIndices[index];
+		unsigned int fullIndexCount = chunk.lodCount > 0 ? chunk.lods[0].indexCount : (unsigned int)indices.size();
+
+		fileOrder[index] = MeshOptimizer::analyzeVertexCache(indices.data(), fullIndexCount, (unsigned int)(vertices.size() / layout.getStride()));
+		MeshOptimizer::optimizeChunk(vertices, layout, indices, chunk);
+		optimised[index] = MeshOptimizer::analyzeVertexCache(indices.data(), fullIndexCount, (unsigned int)(vertices.size() / layout.getStride()));
+
+		chunk.vertices = data.ownedVertices[index].data();
+		chunk.vertexCount = (unsigned int)(data.ownedVertices[index].size() / layout.getStride());
+		chunk.indices = data.ownedIndices[index].data();
+		chunk.indexCount = (unsigned int)data.ownedIndices[index].size();
+		chunk.materialID = shapes[index].materialID;
+	});
+
+	if (dropped > 0)
+	{
+		printf("%s: dropped %u triangles with missing positions\n", filename.c_str(), dropped.load());
+	}
+
+	VertexCacheStats before;
+	VertexCacheStats after;
+	for (size_t i = 0; i < shapes.size(); i++)
+	{
+		before += fileOrder[i];
+		after += optimised[i];
+	}
+
+	if (before.triangles > 0)
+	{
+		printf("%s: vertex cache ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", filename.c_str(),
+			before.acmr(), after.acmr(), before.atvr(), after.atvr());
+	}
+
+	// shapes left with nothing to draw
+	data.chunks.erase(std::remove_if(data.chunks.begin(), data.chunks.end(),
+		[](const MeshChunkData& chunk) { return chunk.indexCount == 0; }), data.chunks.end());
+
+	return true;
+}
+
+void OBJImporter::calculateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	std::vector<glm::vec4> tangents(vertexCount * 2, glm::vec4(0.0f));
+	glm::vec4* tan1 = tangents.data();
+	glm::vec4* tan2 = tan1 + vertexCount;
+
+	unsigned int indexCount = (unsigned int)indices.size();
+	for (unsigned int a = 0; a < indexCount; a += 3)
+	{
+		long i1 = indices[a];
+		long i2 = indices[a + 1];
+		long i3 = indices[a + 2];
+
+		const glm::vec4& v1 = vertices[i1].position;
+		const glm::vec4& v2 = vertices[i2].position;
+		const glm::vec4& v3 = vertices[i3].position;
+
+		const glm::vec2& w1 = vertices[i1].texcoord;
+		const glm::vec2& w2 = vertices[i2].texcoord;
+		const glm::vec2& w3 = vertices[i3].texcoord;
+
+		float x1 = v2.x - v1.x;
+		float x2 = v3.x - v1.x;
+		float y1 = v2.y - v1.y;
+		float y2 = v3.y - v1.y;
+		float z1 = v2.z - v1.z;
+		float z2 = v3.z - v1.z;
+
+		float s1 = w2.x - w1.x;
+		float s2 = w3.x - w1.x;
+		float t1 = w2.y - w1.y;
+		float t2 = w3.y - w1.y;
+
+		float r = 1.0F / (s1 * t2 - s2 * t1);
+		glm::vec4 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
+			(t2 * z1 - t1 * z2) * r, 0);
+		glm::vec4 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
+			(s1 * z2 - s2 * z1) * r, 0);
+
+		tan1[i1] += sdir;
+		tan1[i2] += sdir;
+		tan1[i3] += sdir;
+
+		tan2[i1] += tdir;
+		tan2[i2] += tdir;
+		tan2[i3] += tdir;
+	}
+
+	for (unsigned int a = 0; a < vertexCount; a++)
+	{
+		const glm::vec3& n = glm::vec3(vertices[a].normal);
+		const glm::vec3& t = glm::vec3(tan1[a]);
+
+		// Gram-Schmidt orthogonalize
+		vertices[a].tangent = glm::vec4(glm::normalize(t - n * glm::dot(n, t)), 0);
+
+		// Calculate handedness (direction of bitangent)
+		vertices[a].tangent.w = (glm::dot(glm::cross(glm::vec3(n), glm::vec3(t)), glm::vec3(tan2[a])) < 0.0F) ? 1.0F : -1.0F;
+
+		// calculate bitangent (ignoring for our Vertex, here just for reference)
+		//vertices[a].bitangent = glm::vec4(glm::cross(glm::vec3(vertices[a].normal), glm::vec3(vertices[a].tangent)) * vertices[a].tangent.w, 0);
+		//vertices[a].tangent.w = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Vertex.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
+
+// turns obj / mtl files into mesh data, doesn't touch GL so tools can use it too
+namespace OBJImporter
+{
+	// parse an obj file and convert its vertices to the given format
+	// the file is split into line aligned ranges parsed in parallel on the pool, then the shapes are built in parallel
+	bool import(const std::string& filename, VertexFormat format, MeshData& data, ThreadPool& pool = ThreadPool::getDefault());
+
+	void calculateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+}
@@ -1,15 +1,39 @@
 #include "OBJMesh.h"
 #include <glad\glad.h>
 #include <glm\geometric.hpp>
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include "GLObjectTracker.h"
+#include "RenderStats.h"
+#include "GLState.h"
+#include "MeshCache.h"
+#include "OBJImporter.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "MaterialTable.h"
 
 
 OBJMesh::~OBJMesh()
 {
+	// a load still in flight would be created into the freed mesh
+	AssetLoader::getInstance().cancel(this);
+
 	for (auto& c : m_meshChunks)
 	{
+		// pooled chunks only give their space back, the pool owns the GL objects
+		if (m_pool != nullptr)
+		{
+			m_pool->free(c.geometry);
+			continue;
+		}
+
+		GL_TRACK_DELETED(GLObjectType::VertexArray, c.vao);
+		GL_TRACK_DELETED(GLObjectType::Buffer, c.vbo);
+		GL_TRACK_DELETED(GLObjectType::Buffer, c.ibo);
+
+		GLState::getInstance().vertexArrayDeleted(c.vao);
 		glDeleteVertexArrays(1, &c.vao);
 		glDeleteBuffers(1, &c.vbo);
 		glDeleteBuffers(1, &c.ibo);
@@ -17,7 +41,7 @@ OBJMesh::~OBJMesh()
 }
 
 // load an obj file
-bool OBJMesh::load(const std::string& filename)
+bool OBJMesh::load(const std::string& filename, GeometryPool* pool, VertexFormat format)
 {
 	// don't load if already initialised
 	if (m_meshChunks.empty() == false)
@@ -26,185 +50,279 @@ bool OBJMesh::load(const std::string& filename)
 		return false;
 	}
 
-	// create vectors of tinyobj formats
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string error = "";
+	// pooled meshes use the layout of the pool
+	if (pool != nullptr)
+	{
+		format = pool->getFormat();
+	}
+
+	MeshData data;
+	if (!readData(filename, format, data))
+	{
+		return false;
+	}
+
+	return create(filename, data, pool);
+}
+
+// read the mesh data without touching GL
+bool OBJMesh::readData(const std::string& filename, VertexFormat format, MeshData& data)
+{
+	// use the binary cache if it is up to date, otherwise parse the obj and write a new cache
+	std::string cachePath = MeshCache::getCachePath(filename);
+	unsigned long long sourceHash = MeshCache::hashSource(filename);
+
+	if (!MeshCache::load(cachePath, sourceHash, format, data))
+	{
+		if (!OBJImporter::import(filename, format, data))
+		{
+			return false;
+		}
 
-	// get file and folder name
-	std::string file = filename;
-	std::string folder = file.substr(0, file.find_last_of('\\') + 1);
+		if (sourceHash != 0 && !MeshCache::save(cachePath, sourceHash, data))
+		{
+			printf("Failed to write mesh cache %s\n", cachePath.c_str());
+		}
+	}
 
-	// attempt to load model using tinyobj
-	bool success = tinyobj::LoadObj(shapes, materials, error, filename.c_str(), folder.c_str());
+	return true;
+}
 
-	// check for errors
-	if (success == false)
+// create the GL side of the mesh from data read by readData
+bool OBJMesh::create(const std::string& filename, MeshData& data, GeometryPool* pool, bool streamTextures)
+{
+	// don't create if already initialised
+	if (m_meshChunks.empty() == false)
 	{
-		printf("%s\n", error.c_str());
+		printf("Mesh already initialised, can't re-initialise!\n");
 		return false;
 	}
 
+	VertexFormat format = data.format;
+	assert(pool == nullptr || pool->getFormat() == format);
+
+	// get folder name
+	std::string folder = filename.substr(0, filename.find_last_of('\\') + 1);
+
 	// store filename
 	m_filename = filename;
+	m_pool = pool;
+	m_vertexFormat = format;
+
+	// placeholder colors of streamed textures until they arrive (in Material slot order)
+	static const Color placeholderColors[MeshTextureCount] =
+	{
+		Color(255, 255, 255, 255),	// diffuse
+		Color(255, 255, 255, 255),	// alpha
+		Color(255, 255, 255, 255),	// ambient
+		Color(0, 0, 0, 255),		// specular
+		Color(0, 0, 0, 255),		// specular highlight
+		Color(128, 128, 255, 255),	// normal
+		Color(0, 0, 0, 255),		// displacement
+		Color(0, 0, 0, 255)			// emissive
+	};
+
+	TextureCache& textureCache = TextureCache::getInstance();
+
+	// streamed textures only page in the mips the mesh is seen at
+	TextureOptions streamedOptions;
+	streamedOptions.streamMips = true;
 
 	// resize internal material array
-	m_materials.resize(materials.size());
+	m_materials.resize(data.materials.size());
 
-	int index = 0;
-	for (auto& m : materials)
+	for (size_t index = 0; index < data.materials.size(); index++)
 	{
+		const MeshMaterialData& m = data.materials[index];
+		Material& material = m_materials[index];
+
 		// get constant values from material
-		m_materials[index].ambient = glm::vec3(m.ambient[0], m.ambient[1], m.ambient[2]);
-		m_materials[index].diffuse = glm::vec3(m.diffuse[0], m.diffuse[1], m.diffuse[2]);
-		m_materials[index].specular = glm::vec3(m.specular[0], m.specular[1], m.specular[2]);
-		m_materials[index].emissive = glm::vec3(m.emission[0], m.emission[1], m.emission[2]);
-		m_materials[index].specularPower = m.shininess;
-		m_materials[index].opacity = m.dissolve;
-
-		// load / generate material textures
-		if (!m_materials[index].alphaTexture.load((folder + m.alpha_texname).c_str()))
+		material.ambient = m.ambient;
+		material.diffuse = m.diffuse;
+		material.specular = m.specular;
+		material.emissive = m.emissive;
+		material.specularPower = m.specularPower;
+		material.opacity = m.opacity;
+
+		// get material textures from the cache, so files shared between materials and meshes are only loaded once
+		TextureHandle* textures[MeshTextureCount] =
 		{
-			unsigned char pixels[4] { 255, 255, 255, 255 };
+			&material.diffuseTexture, &material.alphaTexture, &material.ambientTexture, &material.specularTexture,
+			&material.specularHighlightTexture, &material.normalTexture, &material.displacementTexture, &material.emissiveTexture
+		};
 
-			m_materials[index].alphaTexture.create(1, 1, GL_RGBA, pixels);
-		}
-		if (!m_materials[index].ambientTexture.load((folder + m.ambient_texname).c_str()))
+		for (unsigned int t = 0; t < MeshTextureCount; t++)
 		{
-			unsigned char pixels[4]{ 255, 255, 255, 255 };
+			if (m.textures[t].empty())
+			{
+				continue;
+			}
 
-			m_materials[index].ambientTexture.create(1, 1, GL_RGBA, pixels);
+			std::string path = folder + m.textures[t];
+			*textures[t] = streamTextures ? textureCache.stream(path, placeholderColors[t], streamedOptions) : textureCache.load(path);
 		}
-		if (!m_materials[index].diffuseTexture.load((folder + m.diffuse_texname).c_str()))
-		{
-			unsigned char pixels[4]{ 255, 255, 255, 255 };
 
-			m_materials[index].diffuseTexture.create(1, 1, GL_RGBA, pixels);
-		}
-		if (!m_materials[index].specularTexture.load((folder + m.specular_texname).c_str()))
-		{
-			unsigned char pixels[4]{ 0, 0, 0, 255 };
+		// missing textures (or ones that failed to load) use the shared defaults
+		material.setDefaultTextures();
+	}
 
-			m_materials[index].specularTexture.create(1, 1, GL_RGBA, pixels);
-		}
-		if (!m_materials[index].normalTexture.load((folder + m.bump_texname).c_str()))
-		{
-			unsigned char pixels[4]{ 128, 128, 255, 255 };
+	const VertexLayout& layout = VertexLayout::get(format);
 
-			m_materials[index].normalTexture.create(1, 1, GL_RGBA, pixels);
-		}
-		if (!m_materials[index].displacementTexture.load((folder + m.displacement_texname).c_str()))
-		{
-			unsigned char pixels[4]{ 0, 0, 0, 255 };
+	// allocate memory for mesh chunks
+	m_meshChunks.reserve(data.chunks.size());
+	m_chunkTriangles.reserve(data.chunks.size());
+	for (const MeshChunkData& source : data.chunks)
+	{
+		// the GL buffers can't be read back, so ray casts get their own copy of the triangles
+		m_chunkTriangles.emplace_back();
+		packTriangles(source, layout, m_chunkTriangles.back());
+
+		MeshChunk chunk = {};
 
-			m_materials[index].displacementTexture.create(1, 1, GL_RGBA, pixels);
+		// chunks without simplified levels (e.g. from older tools) draw all their indices as level 0
+		if (source.lodCount > 0)
+		{
+			std::copy(source.lods, source.lods + source.lodCount, chunk.lods);
+			chunk.lodCount = source.lodCount;
 		}
-		if (!m_materials[index].emissiveTexture.load((folder + m.emissive_texname).c_str()))
+		else
 		{
-			unsigned char pixels[4]{ 0, 0, 0, 255 };
-
-			m_materials[index].emissiveTexture.create(1, 1, GL_RGBA, pixels);
+			chunk.lods[0].indexCount = source.indexCount;
+			chunk.lodCount = 1;
 		}
 
-		index++;
-	}
+		// store index count for rendering
+		chunk.indexCount = chunk.lods[0].indexCount;
 
-	// allocate memory for mesh chunks
-	m_meshChunks.reserve(shapes.size());
-	for (auto& s : shapes)
-	{
-		MeshChunk chunk;
+		// set chunk material
+		chunk.materialID = source.materialID;
+
+		chunk.boundsMin = source.boundsMin;
+		chunk.boundsMax = source.boundsMax;
+		chunk.boundsRadius = source.boundsRadius;
+		chunk.uvDensity = source.uvDensity;
+
+		// pooled chunks share the pool's vertex array
+		if (pool != nullptr)
+		{
+			chunk.indexType = GL_UNSIGNED_INT;
+			chunk.vao = pool->getVertexArray();
+			chunk.geometry = pool->allocatePacked(source.vertices, source.vertexCount, source.indices, source.indexCount);
+
+			m_meshChunks.push_back(chunk);
+			continue;
+		}
 
 		// generate buffers
 		glGenBuffers(1, &chunk.vbo);
 		glGenBuffers(1, &chunk.ibo);
 		glGenVertexArrays(1, &chunk.vao);
+		GL_TRACK_CREATED(GLObjectType::Buffer, chunk.vbo, "OBJMesh");
+		GL_TRACK_CREATED(GLObjectType::Buffer, chunk.ibo, "OBJMesh");
+		GL_TRACK_CREATED(GLObjectType::VertexArray, chunk.vao, "OBJMesh");
 
 		// bind vertex array aka a mesh wrapper
-		glBindVertexArray(chunk.vao);
+		GLState::getInstance().bindVertexArray(chunk.vao);
 
 		// set the index buffer data
+		// half the size (and fetch bandwidth) when every vertex fits in 16 bits
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			s.mesh.indices.size() * sizeof(unsigned int),
-			s.mesh.indices.data(), GL_STATIC_DRAW);
-
-		// store index count for rendering
-		chunk.indexCount = (unsigned int)s.mesh.indices.size();
-
-		// create vertex data
-		std::vector<Vertex> vertices;
-		vertices.resize(s.mesh.positions.size() / 3);
-		size_t vertCount = vertices.size();
-
-		bool hasPosition = s.mesh.positions.empty() == false;
-		bool hasNormal = s.mesh.normals.empty() == false;
-		bool hasTexture = s.mesh.texcoords.empty() == false;
-
-		for (size_t i = 0; i < vertCount; ++i)
+		if (source.vertexCount < 65536)
 		{
-			if (hasPosition)
-			{
-				vertices[i].position = glm::vec4(s.mesh.positions[i * 3 + 0], s.mesh.positions[i * 3 + 1], s.mesh.positions[i * 3 + 2], 1);
-			}
-			if (hasNormal)
-			{
-				vertices[i].normal = glm::vec4(s.mesh.normals[i * 3 + 0], s.mesh.normals[i * 3 + 1], s.mesh.normals[i * 3 + 2], 0);
-			}
-
-			if (hasTexture)
-			{
-				vertices[i].texcoord = glm::vec2(s.mesh.texcoords[i * 2 + 0], s.mesh.texcoords[i * 2 + 1]);
-			}
+			std::vector<unsigned short> shortIndices(source.indices, source.indices + source.indexCount);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, source.indexCount * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+			chunk.indexType = GL_UNSIGNED_SHORT;
 		}
-
-		// calculate for normal mapping
-		if (hasNormal && hasTexture)
+		else
 		{
-			calculateTangents(vertices, s.mesh.indices);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, source.indexCount * sizeof(unsigned int), source.indices, GL_STATIC_DRAW);
+			chunk.indexType = GL_UNSIGNED_INT;
 		}
 
 		// bind vertex buffer
 		glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
 
-		// fill vertex buffer
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-		// enable first element as positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+		// fill vertex buffer, the vertices are already in the mesh's layout (straight from the cache mapping when cached)
+		glBufferData(GL_ARRAY_BUFFER, source.vertexCount * layout.getStride(), source.vertices, GL_STATIC_DRAW);
 
-		// enable second element as normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-
-		// enable third element as texture coords
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
-
-		// enable forth element as tangents
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
-
-		// enable fifth element as colors
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+		// set up the attributes from the layout
+		layout.apply(0);
+		glBindVertexBuffer(0, chunk.vbo, 0, layout.getStride());
 
 		// bind 0 for safety
-		glBindVertexArray(0);
+		GLState::getInstance().bindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-		// set chunk material
-		chunk.materialID = s.mesh.material_ids.empty() ? -1 : s.mesh.material_ids[0];
-
 		m_meshChunks.push_back(chunk);
 	}
 
+	// the mesh's bounds hold every chunk's box, its sphere every chunk's sphere
+	m_boundsMin = glm::vec3(FLT_MAX);
+	m_boundsMax = glm::vec3(-FLT_MAX);
+	for (const MeshChunk& c : m_meshChunks)
+	{
+		m_boundsMin = glm::min(m_boundsMin, c.boundsMin);
+		m_boundsMax = glm::max(m_boundsMax, c.boundsMax);
+	}
+
+	glm::vec3 center = getBoundsCenter();
+	m_boundsRadius = 0.0f;
+	for (const MeshChunk& c : m_meshChunks)
+	{
+		glm::vec3 chunkCenter = (c.boundsMin + c.boundsMax) * 0.5f;
+		m_boundsRadius = glm::max(m_boundsRadius, glm::length(chunkCenter - center) + c.boundsRadius);
+	}
+
 	// load obj
 	return true;
 }
 
+// copy a chunk's triangles out of its packed vertices, 4 to a packet
+void OBJMesh::packTriangles(const MeshChunkData& source, const VertexLayout& layout, std::vector<TrianglePacket>& packets)
+{
+	// every vertex format stores the position as floats
+	unsigned int positionOffset = 0;
+	for (const VertexAttribute& attribute : layout.getAttributes())
+	{
+		if (attribute.semantic == VertexSemantic::Position)
+		{
+			assert(attribute.type == GL_FLOAT);
+			positionOffset = attribute.offset;
+		}
+	}
+
+	auto position = [&](unsigned int index)
+	{
+		const float* p = (const float*)(source.vertices + (size_t)index * layout.getStride() + positionOffset);
+		return glm::vec3(p[0], p[1], p[2]);
+	};
+
+	// rays are only tested against the full mesh
+	unsigned int triangleCount = (source.lodCount > 0 ? source.lods[0].indexCount : source.indexCount) / 3;
+	packets.assign((triangleCount + 3) / 4, TrianglePacket());
+
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		glm::vec3 v0 = position(source.indices[t * 3]);
+		glm::vec3 e1 = position(source.indices[t * 3 + 1]) - v0;
+		glm::vec3 e2 = position(source.indices[t * 3 + 2]) - v0;
+
+		TrianglePacket& packet = packets[t / 4];
+		unsigned int lane = t % 4;
+
+		packet.v0x[lane] = v0.x;
+		packet.v0y[lane] = v0.y;
+		packet.v0z[lane] = v0.z;
+		packet.e1x[lane] = e1.x;
+		packet.e1y[lane] = e1.y;
+		packet.e1z[lane] = e1.z;
+		packet.e2x[lane] = e2.x;
+		packet.e2y[lane] = e2.y;
+		packet.e2z[lane] = e2.z;
+	}
+}
+
 // toggle whether to use normal maps
 void OBJMesh::toggleNormalMaps()
 {
@@ -215,92 +333,194 @@ void OBJMesh::toggleNormalMaps()
 }
 
 // draw mesh
-void OBJMesh::draw(Shader shader, bool usePatches)
+void OBJMesh::draw(const Shader& shader, bool usePatches)
 {
+	FrameStats& stats = RenderStats::getInstance().current();
+
 	int currentMaterial = -1;
 
 	// draw the mesh chunks
 	for (auto& c : m_meshChunks)
 	{
 		// bind material
-		if (currentMaterial != c.materialID)
+		if (currentMaterial != c.materialID && c.materialID >= 0)
 		{
 			m_materials[c.materialID].bind(shader);
+			currentMaterial = c.materialID;
+			stats.materialBinds++;
 		}
 
 		// bind and draw geometry
-		glBindVertexArray(c.vao);
-		if (usePatches)
-			glDrawElements(GL_PATCHES, c.indexCount, GL_UNSIGNED_INT, 0);
-		else
-			glDrawElements(GL_TRIANGLES, c.indexCount, GL_UNSIGNED_INT, 0);
+		GLState::getInstance().bindVertexArray(c.vao);
+		stats.drawCalls++;
+		stats.triangles += c.indexCount / 3;
+		glDrawElementsBaseVertex(usePatches ? GL_PATCHES : GL_TRIANGLES, c.indexCount, c.indexType,
+			(void*)(c.geometry.firstIndex * c.indexSize()), c.geometry.baseVertex);
+	}
+}
+
+// draw many copies in one instanced draw per chunk
+// the transforms are uploaded once and read by the shader per instance, so there is no per copy CPU work
+void OBJMesh::drawInstanced(MaterialShader& shader, const glm::mat4* transforms, size_t count, unsigned int lod, bool usePatches)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	m_instances.upload(transforms, count);
+
+	// one table upload for every material of the mesh
+	MaterialTable& materialTable = MaterialTable::getInstance();
+	for (const Material& material : m_materials)
+	{
+		materialTable.add(material);
+	}
+	materialTable.upload();
+
+	FrameStats& stats = RenderStats::getInstance().current();
+
+	int currentMaterial = -1;
+	Shader* currentShader = nullptr;
+
+	for (auto& c : m_meshChunks)
+	{
+		const Material* material = c.materialID >= 0 ? &m_materials[c.materialID] : nullptr;
+
+		// switching permutation loses the material index uniform, so the material is bound again
+		Shader& permutation = shader.get(material);
+		if (&permutation != currentShader)
+		{
+			currentShader = &permutation;
+			currentShader->bind();
+			currentMaterial = -1;
+		}
+
+		// bind material
+		if (currentMaterial != c.materialID && material != nullptr)
+		{
+			material->bind(permutation);
+			currentMaterial = c.materialID;
+			stats.materialBinds++;
+		}
+
+		// chunks with fewer levels use their coarsest
+		const MeshLod& level = c.lods[std::min(lod, c.lodCount - 1)];
+
+		// bind and draw every instance of the chunk
+		GLState::getInstance().bindVertexArray(c.vao);
+		stats.drawCalls++;
+		stats.instances += (unsigned int)count;
+		stats.triangles += level.indexCount / 3 * (unsigned int)count;
+		glDrawElementsInstancedBaseVertex(usePatches ? GL_PATCHES : GL_TRIANGLES, level.indexCount, c.indexType,
+			(void*)((c.geometry.firstIndex + level.firstIndex) * c.indexSize()), (GLsizei)count, c.geometry.baseVertex);
 	}
 }
 
-void OBJMesh::calculateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+// ask for the mips each chunk needs from how many uv units a pixel covers at its nearest point
+void OBJMesh::requestTextureLevels(const glm::mat4& transform, const Camera& camera) const
 {
-	unsigned int vertexCount = (unsigned int)vertices.size();
-	glm::vec4* tan1 = new glm::vec4[vertexCount * 2];
-	glm::vec4* tan2 = tan1 + vertexCount;
-	memset(tan1, 0, vertexCount * sizeof(glm::vec4) * 2);
+	TextureStreamer& streamer = TextureStreamer::getInstance();
+
+	float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+	float pixelsPerUnit = camera.getProjectedScale();
+
+	for (auto& c : m_meshChunks)
+	{
+		if (c.materialID < 0 || c.uvDensity <= 0.0f)
+		{
+			continue;
+		}
+
+		glm::vec3 center = glm::vec3(transform * glm::vec4((c.boundsMin + c.boundsMax) * 0.5f, 1.0f));
+		float radius = glm::length(c.boundsMax - c.boundsMin) * 0.5f * scale;
+		float distance = glm::max(glm::length(center - camera.getPosition()) - radius, camera.getNearPlane());
+
+		// uv units per world unit over world units per pixel
+		float uvPerPixel = (c.uvDensity / scale) * distance / pixelsPerUnit;
+
+		const Material& material = m_materials[c.materialID];
+		const TextureHandle* textures[MeshTextureCount] =
+		{
+			&material.diffuseTexture, &material.alphaTexture, &material.ambientTexture, &material.specularTexture,
+			&material.specularHighlightTexture, &material.normalTexture, &material.displacementTexture, &material.emissiveTexture
+		};
+
+		for (const TextureHandle* texture : textures)
+		{
+			if (*texture != nullptr)
+			{
+				streamer.request(texture->get(), uvPerPixel);
+			}
+		}
+	}
+}
 
-	unsigned int indexCount = (unsigned int)indices.size();
-	for (unsigned int a = 0; a < indexCount; a += 3)
+// coarsest level of detail of a chunk whose error covers at most maxPixelError pixels where the camera sees it
+unsigned int OBJMesh::selectLod(size_t index, const glm::mat4& transform, const Camera& camera, float maxPixelError) const
+{
+	const MeshChunk& c = m_meshChunks[index];
+	if (c.lodCount <= 1)
 	{
-		long i1 = indices[a];
-		long i2 = indices[a + 1];
-		long i3 = indices[a + 2];
-
-		const glm::vec4& v1 = vertices[i1].position;
-		const glm::vec4& v2 = vertices[i2].position;
-		const glm::vec4& v3 = vertices[i3].position;
-
-		const glm::vec2& w1 = vertices[i1].texcoord;
-		const glm::vec2& w2 = vertices[i2].texcoord;
-		const glm::vec2& w3 = vertices[i3].texcoord;
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.x - w1.x;
-		float s2 = w3.x - w1.x;
-		float t1 = w2.y - w1.y;
-		float t2 = w3.y - w1.y;
-
-		float r = 1.0F / (s1 * t2 - s2 * t1);
-		glm::vec4 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-			(t2 * z1 - t1 * z2) * r, 0);
-		glm::vec4 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-			(s1 * z2 - s2 * z1) * r, 0);
-
-		tan1[i1] += sdir;
-		tan1[i2] += sdir;
-		tan1[i3] += sdir;
-
-		tan2[i1] += tdir;
-		tan2[i2] += tdir;
-		tan2[i3] += tdir;
+		return 0;
 	}
 
-	for (unsigned int a = 0; a < vertexCount; a++)
+	float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+	// measured from the nearest point of the bounding sphere
+	glm::vec3 center = glm::vec3(transform * glm::vec4((c.boundsMin + c.boundsMax) * 0.5f, 1.0f));
+	float distance = glm::max(glm::length(center - camera.getPosition()) - c.boundsRadius * scale, camera.getNearPlane());
+
+	// pixels an object space unit covers at that distance
+	float pixelsPerUnit = camera.getProjectedScale() * scale / distance;
+
+	unsigned int lod = 0;
+	while (lod + 1 < c.lodCount && c.lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
 	{
-		const glm::vec3& n = glm::vec3(vertices[a].normal);
-		const glm::vec3& t = glm::vec3(tan1[a]);
+		lod++;
+	}
 
-		// Gram-Schmidt orthogonalize
-		vertices[a].tangent = glm::vec4(glm::normalize(t - n * glm::dot(n, t)), 0);
+	return lod;
+}
 
-		// Calculate handedness (direction of bitangent)
-		vertices[a].tangent.w = (glm::dot(glm::cross(glm::vec3(n), glm::vec3(t)), glm::vec3(tan2[a])) < 0.0F) ? 1.0F : -1.0F;
+// level of detail for every chunk at once, the finest any of them needs
+unsigned int OBJMesh::selectLod(const glm::mat4& transform, const Camera& camera, float maxPixelError) const
+{
+	unsigned int lod = MaxMeshLods - 1;
 
-		// calculate bitangent (ignoring for our Vertex, here just for reference)
-		//vertices[a].bitangent = glm::vec4(glm::cross(glm::vec3(vertices[a].normal), glm::vec3(vertices[a].tangent)) * vertices[a].tangent.w, 0);
-		//vertices[a].tangent.w = 0;
+	for (size_t i = 0; i < m_meshChunks.size() && lod > 0; i++)
+	{
+		lod = std::min(lod, selectLod(i, transform, camera, maxPixelError));
 	}
 
-	delete[] tan1;
+	return lod;
+}
+
+// add a single chunk's draw to a render queue
+void OBJMesh::submitChunk(RenderQueue& queue, MaterialShader& shader, size_t index, const glm::mat4& transform, unsigned int lod,
+	bool usePatches) const
+{
+	const MeshChunk& c = m_meshChunks[index];
+	const Material* material = c.materialID >= 0 ? &m_materials[c.materialID] : nullptr;
+	const MeshLod& level = c.lods[std::min(lod, c.lodCount - 1)];
+
+	queue.submit(RenderPass::Opaque, shader.get(material), material, c.vao, level.indexCount, transform,
+		usePatches ? GL_PATCHES : GL_TRIANGLES, c.geometry.firstIndex + level.firstIndex, c.geometry.baseVertex, c.indexType);
 }
+
+// add a single chunk's draw to a multi draw queue
+void OBJMesh::submitChunk(MultiDrawQueue& queue, size_t index, const glm::mat4& transform, unsigned int lod) const
+{
+	assert(m_pool != nullptr);
+
+	const MeshChunk& c = m_meshChunks[index];
+	const Material* material = c.materialID >= 0 ? &m_materials[c.materialID] : nullptr;
+	const MeshLod& level = c.lods[std::min(lod, c.lodCount - 1)];
+
+	// the level's indices are a part of the chunk's allocation
+	GeometryAllocation geometry = c.geometry;
+	geometry.firstIndex += level.firstIndex;
+	geometry.indexCount = level.indexCount;
+
+	queue.submit(material, geometry, transform, c.boundsMin, c.boundsMax);
+}
\ No newline at end of file
@@ -3,35 +3,107 @@
 #include <string>
 #include <vector>
 #include "Vertex.h"
+#include "VertexLayout.h"
 #include "Material.h"
 #include "MeshChunk.h"
+#include "MeshData.h"
 #include "Shader.h"
+#include "MaterialShader.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "GeometryPool.h"
+#include "MultiDrawQueue.h"
+#include "Camera.h"
 
+// mesh loaded from an obj file, owns its GL buffers and materials so it can't be copied
 class OBJMesh
 {
 public:
 
 	// constructor / destructor
 	OBJMesh() {};
-	OBJMesh(const std::string& filename) { load(filename); }
+	OBJMesh(const std::string& filename, GeometryPool* pool = nullptr, VertexFormat format = VertexFormat::Full)
+	{
+		load(filename, pool, format);
+	}
 	~OBJMesh();
 
-	bool load(const std::string& filename);
+	OBJMesh(const OBJMesh&) = delete;
+	OBJMesh& operator = (const OBJMesh&) = delete;
+
+	// with a pool the chunks are suballocated from its shared buffers instead of getting their own
+	// (and use the pool's vertex format instead of the one given)
+	bool load(const std::string& filename, GeometryPool* pool = nullptr, VertexFormat format = VertexFormat::Full);
+
+	// the two halves of load, so the file work can happen on a loader thread (see AssetLoader::loadMesh)
+	// readData uses the binary cache if it is up to date, otherwise imports the obj and writes a new cache, no GL
+	static bool readData(const std::string& filename, VertexFormat format, MeshData& data);
+
+	// create the GL buffers and materials, with streamTextures the textures start as placeholders and load in the background
+	bool create(const std::string& filename, MeshData& data, GeometryPool* pool = nullptr, bool streamTextures = false);
 
 	void toggleNormalMaps();
 
-	void draw(Shader shader, bool usePatches = false);
+	void draw(const Shader& shader, bool usePatches = false);
+
+	// draw many copies in one instanced draw per chunk, needs an instanced shader (e.g. phongInstanced.vs)
+	// each chunk is drawn with the permutation its material's features need
+	// every copy is drawn at the same level of detail
+	void drawInstanced(MaterialShader& shader, const glm::mat4* transforms, size_t count, unsigned int lod = 0, bool usePatches = false);
+	void drawInstanced(MaterialShader& shader, const std::vector<glm::mat4>& transforms, unsigned int lod = 0, bool usePatches = false)
+	{
+		drawInstanced(shader, transforms.data(), transforms.size(), lod, usePatches);
+	}
+
+	// ask the texture streamer for the mips of every chunk's textures as seen by the camera this frame
+	void requestTextureLevels(const glm::mat4& transform, const Camera& camera) const;
+
+	// object space bounds of every chunk together, the sphere is centered on the box
+	const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+	const glm::vec3& getBoundsMax() const { return m_boundsMax; }
+	glm::vec3 getBoundsCenter() const { return (m_boundsMin + m_boundsMax) * 0.5f; }
+	float getBoundsRadius() const { return m_boundsRadius; }
+
+	bool isPooled() const { return m_pool != nullptr; }
+
+	VertexFormat getVertexFormat() const { return m_vertexFormat; }
 
 	const std::string& getFilename() const { return m_filename; }
 
+	size_t getChunkCount() const { return m_meshChunks.size(); }
+	const MeshChunk& getChunk(size_t index) const { return m_meshChunks[index]; }
+
+	// object space triangles of a chunk, kept on the CPU for ray casts
+	const std::vector<TrianglePacket>& getChunkTriangles(size_t index) const { return m_chunkTriangles[index]; }
+
+	// add a single chunk's draw, for callers that did their own culling (see SceneBVH)
+	// lod picks the chunk's level of detail (see selectLod)
+	void submitChunk(RenderQueue& queue, MaterialShader& shader, size_t index, const glm::mat4& transform, unsigned int lod = 0,
+		bool usePatches = false) const;
+	void submitChunk(MultiDrawQueue& queue, size_t index, const glm::mat4& transform, unsigned int lod = 0) const;
+
+	// coarsest level of detail whose error covers at most maxPixelError pixels on the camera's screen
+	// for one chunk, or for the whole mesh (the finest any chunk needs) when it is drawn as one (e.g. instanced)
+	unsigned int selectLod(size_t index, const glm::mat4& transform, const Camera& camera, float maxPixelError = 1.0f) const;
+	unsigned int selectLod(const glm::mat4& transform, const Camera& camera, float maxPixelError = 1.0f) const;
+
 	size_t getMaterialCount() const { return m_materials.size(); }
 	Material& getMaterial(size_t index) { return m_materials[index]; }
 
 private:
 
-	void calculateTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+	// copy a chunk's triangles out of its packed vertices, 4 to a packet
+	static void packTriangles(const MeshChunkData& source, const VertexLayout& layout, std::vector<TrianglePacket>& packets);
 
 	std::string				m_filename;
 	std::vector<MeshChunk>	m_meshChunks;
+	std::vector<std::vector<TrianglePacket>> m_chunkTriangles;
 	std::vector<Material>	m_materials;
+	InstanceBuffer			m_instances;
+	GeometryPool*			m_pool = nullptr;
+	VertexFormat			m_vertexFormat = VertexFormat::Full;
+
+	glm::vec3				m_boundsMin = glm::vec3(0.0f);
+	glm::vec3				m_boundsMax = glm::vec3(0.0f);
+	float					m_boundsRadius = 0.0f;
 };
\ No newline at end of file
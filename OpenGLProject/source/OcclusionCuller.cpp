@@ -0,0 +1,223 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include "BufferBindings.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "RenderStats.h"
+
+// threads per work group in the compute shaders
+const unsigned int CullGroupSize = 64;
+const unsigned int PyramidGroupSize = 8;
+
+// tested / frustum culled / occluded, as laid out in the stats buffer of occlusionCull.comp
+const unsigned int StatsCounterCount = 3;
+
+OcclusionCuller::~OcclusionCuller()
+{
+	deletePyramid();
+
+	for (unsigned int i = 0; i < StatsBufferCount; i++)
+	{
+		if (m_statsFences[i] != nullptr)
+		{
+			glDeleteSync(m_statsFences[i]);
+		}
+
+		if (m_statsBuffers[i] != 0)
+		{
+			GL_TRACK_DELETED(GLObjectType::Buffer, m_statsBuffers[i]);
+			glDeleteBuffers(1, &m_statsBuffers[i]);
+		}
+	}
+}
+
+// start compiling the compute shaders (finished the first time they're used)
+void OcclusionCuller::initialise(const std::string& shaderFolder)
+{
+	m_copyDepthShader = Shader::createCompute((shaderFolder + "depthPyramid.comp").c_str(), "#define COPY_DEPTH\n");
+	m_downsampleShader = Shader::createCompute((shaderFolder + "depthPyramid.comp").c_str());
+	m_cullShader = Shader::createCompute((shaderFolder + "occlusionCull.comp").c_str());
+}
+
+// test drawCount draws, the commands are rewritten in place before they are drawn
+void OcclusionCuller::cull(unsigned int commandBuffer, unsigned int drawDataBuffer, unsigned int boundsBuffer, unsigned int drawCount)
+{
+	if (drawCount == 0)
+	{
+		return;
+	}
+
+	// reuse the oldest counters, picking up what they counted if the GPU is done with them
+	unsigned int index = m_statsIndex;
+	m_statsIndex = (m_statsIndex + 1) % StatsBufferCount;
+
+	if (m_statsBuffers[index] == 0)
+	{
+		glGenBuffers(1, &m_statsBuffers[index]);
+		GL_TRACK_CREATED(GLObjectType::Buffer, m_statsBuffers[index], "OcclusionCuller");
+	}
+	else
+	{
+		readStats(index);
+	}
+
+	const unsigned int zeroes[StatsCounterCount] = {};
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffers[index]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zeroes), zeroes, GL_DYNAMIC_READ);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_cullShader.bind();
+	m_cullShader.set(UniformID("drawCount"), (int)drawCount);
+	m_cullShader.set(UniformID("useOcclusion"), m_hasPyramid);
+
+	if (m_hasPyramid)
+	{
+		m_cullShader.set(UniformID("pyramidProjectionView"), m_pyramidProjectionView);
+		m_cullShader.set(UniformID("pyramidSize"), glm::ivec2(m_width, m_height));
+		m_cullShader.set(UniformID("pyramidLevels"), (int)m_levelCount);
+
+		GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_pyramidTexture);
+		GLState::getInstance().bindSampler(0, 0);
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::DrawData, drawDataBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::DrawBounds, boundsBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::DrawCommands, commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBufferBinding::CullStats, m_statsBuffers[index]);
+
+	glDispatchCompute((drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+	// the multi draw reads the commands straight after
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	m_statsFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// copy the depth buffer of the frame just drawn and build the pyramid the next frame is tested against
+void OcclusionCuller::buildDepthPyramid(unsigned int width, unsigned int height, const glm::mat4& projectionView)
+{
+	// minimised
+	if (width == 0 || height == 0)
+	{
+		return;
+	}
+
+	if (width != m_width || height != m_height)
+	{
+		createPyramid(width, height);
+	}
+
+	// from the bound read framebuffer
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_depthTexture);
+	GLState::getInstance().bindSampler(0, 0);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+	glm::ivec2 size(width, height);
+
+	m_copyDepthShader.bind();
+	m_copyDepthShader.set(UniformID("sourceSize"), size);
+	m_copyDepthShader.set(UniformID("destinationSize"), size);
+
+	glBindImageTexture(1, m_pyramidTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute((width + PyramidGroupSize - 1) / PyramidGroupSize, (height + PyramidGroupSize - 1) / PyramidGroupSize, 1);
+
+	// each level is the farthest depth of 2x2 texels of the one above
+	m_downsampleShader.bind();
+
+	for (unsigned int level = 1; level < m_levelCount; level++)
+	{
+		glm::ivec2 levelSize = glm::max(size / 2, glm::ivec2(1));
+
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		m_downsampleShader.set(UniformID("sourceSize"), size);
+		m_downsampleShader.set(UniformID("destinationSize"), levelSize);
+
+		glBindImageTexture(0, m_pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, m_pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute((levelSize.x + PyramidGroupSize - 1) / PyramidGroupSize, (levelSize.y + PyramidGroupSize - 1) / PyramidGroupSize, 1);
+
+		size = levelSize;
+	}
+
+	// the next cull fetches from it as a texture
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	m_pyramidProjectionView = projectionView;
+	m_hasPyramid = true;
+}
+
+void OcclusionCuller::createPyramid(unsigned int width, unsigned int height)
+{
+	deletePyramid();
+
+	m_width = width;
+	m_height = height;
+	m_levelCount = 1 + (unsigned int)std::floor(std::log2((float)std::max(width, height)));
+
+	// same format as the depth buffers, so the copy is a straight one
+	glGenTextures(1, &m_depthTexture);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_depthTexture, "OcclusionCuller");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &m_pyramidTexture);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_pyramidTexture, "OcclusionCuller");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_pyramidTexture);
+	glTexStorage2D(GL_TEXTURE_2D, m_levelCount, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void OcclusionCuller::deletePyramid()
+{
+	unsigned int* textures[] = { &m_depthTexture, &m_pyramidTexture };
+
+	for (unsigned int* texture : textures)
+	{
+		if (*texture != 0)
+		{
+			GL_TRACK_DELETED(GLObjectType::Texture, *texture);
+			GLState::getInstance().textureDeleted(*texture);
+			glDeleteTextures(1, texture);
+			*texture = 0;
+		}
+	}
+
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_hasPyramid = false;
+}
+
+// add the counts of a finished cull to the render stats, without waiting for one that hasn't
+void OcclusionCuller::readStats(unsigned int index)
+{
+	if (m_statsFences[index] == nullptr)
+	{
+		return;
+	}
+
+	GLenum status = glClientWaitSync(m_statsFences[index], 0, 0);
+	glDeleteSync(m_statsFences[index]);
+	m_statsFences[index] = nullptr;
+
+	// still in flight three frames on, its counts are dropped rather than waited for
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		return;
+	}
+
+	unsigned int counts[StatsCounterCount];
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffers[index]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	FrameStats& stats = RenderStats::getInstance().current();
+	stats.gpuTestedDraws += counts[0];
+	stats.gpuFrustumCulledDraws += counts[1];
+	stats.occlusionCulledDraws += counts[2];
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <glad\glad.h>
+#include <glm\glm.hpp>
+#include "Shader.h"
+
+// object space box of a multi draw, as laid out in the std430 bounds buffer of occlusionCull.comp
+struct GPUDrawBounds
+{
+	glm::vec4 center; // w unused
+	glm::vec4 extents;
+};
+static_assert(sizeof(GPUDrawBounds) == 32, "GPUDrawBounds must match the std430 layout in the shaders");
+
+// culls multi draw indirect commands on the GPU
+// a compute pass tests every draw's box against the frustum and against a depth pyramid (hierarchical z, the farthest
+// depth per texel) built from the previous frame's depth buffer, and zeroes the instance count of draws that can't be seen
+class OcclusionCuller
+{
+public:
+
+	OcclusionCuller() {};
+	~OcclusionCuller();
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator = (const OcclusionCuller&) = delete;
+
+	// start compiling the compute shaders (finished the first time they're used)
+	void initialise(const std::string& shaderFolder);
+
+	// test drawCount draws, the commands are rewritten in place before they are drawn
+	void cull(unsigned int commandBuffer, unsigned int drawDataBuffer, unsigned int boundsBuffer, unsigned int drawCount);
+
+	// copy the depth buffer of the frame just drawn and build the pyramid the next frame is tested against
+	void buildDepthPyramid(unsigned int width, unsigned int height, const glm::mat4& projectionView);
+
+private:
+
+	void createPyramid(unsigned int width, unsigned int height);
+	void deletePyramid();
+
+	// add the counts of a finished cull to the render stats, without waiting for one that hasn't
+	void readStats(unsigned int index);
+
+	Shader m_copyDepthShader;
+	Shader m_downsampleShader;
+	Shader m_cullShader;
+
+	// the depth buffer is copied here first, depth formats can't be bound as images
+	unsigned int m_depthTexture = 0;
+	unsigned int m_pyramidTexture = 0;
+	unsigned int m_width = 0;
+	unsigned int m_height = 0;
+	unsigned int m_levelCount = 0;
+
+	// what the pyramid was drawn with
+	glm::mat4 m_pyramidProjectionView = glm::mat4(1.0f);
+	bool m_hasPyramid = false;
+
+	// counters of the last few culls, each is read back once its fence has passed so the CPU never stalls on them
+	static const unsigned int StatsBufferCount = 3;
+	unsigned int m_statsBuffers[StatsBufferCount] = {};
+	GLsync m_statsFences[StatsBufferCount] = {};
+	unsigned int m_statsIndex = 0;
+};
\ No newline at end of file
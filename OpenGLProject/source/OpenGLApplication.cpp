@@ -1,14 +1,36 @@
 #include "OpenGLApplication.h"
 
-#include <glm\gtc\matrix_inverse.hpp>
-
 #include <experimental\filesystem>
 namespace fs = std::experimental::filesystem;
+#include <cfloat>
+#include <chrono>
 #include <iostream>
 
 #include "Time.h"
 #include "Color.h"
 #include "Input.h"
+#include "RenderStats.h"
+#include "GLState.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "TextureMemoryTracker.h"
+#include "TextureStreamer.h"
+#include "SamplerCache.h"
+#include "ShaderCache.h"
+#include "MaterialTable.h"
+#include "MaterialTextureTable.h"
+
+// milliseconds per frame the GL thread may spend uploading assets that finished loading in the background
+static const float AssetUploadBudget = 2.0f;
+
+// seconds between texture memory reports in the console
+static const float TextureMemoryLogInterval = 60.0f;
+
+// GPU bytes the mips of streamed textures may take
+static const size_t TextureStreamingBudget = 256 * 1024 * 1024;
+
+// pixels a simplified level of detail may be off by before a finer one is drawn
+static const float LodPixelError = 1.0f;
 
 // callback functions
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -57,10 +79,11 @@ OpenGLApplication::OpenGLApplication(unsigned int width, unsigned int height, co
 	}
 
 	// enable the z buffer
-	glEnable(GL_DEPTH_TEST);
+	GLState::getInstance().setDepthTest(true);
+	GLState::getInstance().setDepthFunc(GL_LESS);
 
 	// enable front face culling
-	glEnable(GL_CULL_FACE);
+	GLState::getInstance().setCullFace(true);
 
 	// set Input window pointer
 	Input::getInstance().setWindowPointer(m_window);
@@ -76,30 +99,79 @@ OpenGLApplication::~OpenGLApplication()
 	{
 		delete currentMesh;
 	}
+
+	for (InstancedMesh& instanced : m_instancedMeshes)
+	{
+		delete instanced.mesh;
+	}
 }
 
 // load and create all the various assets needed
 void OpenGLApplication::setup()
 {
-	// load and compile shaders
-	m_phongShader = Shader((fs::current_path().string() + "\\resources\\shaders\\phong.vs").c_str(),
-		(fs::current_path().string() + "\\resources\\shaders\\phong.fs").c_str());
-	m_pbrShader = Shader((fs::current_path().string() + "\\resources\\shaders\\pbr.vs").c_str(),
-		(fs::current_path().string() + "\\resources\\shaders\\pbr.fs").c_str());
+	// load and compile shaders, programs built on an earlier run come straight from the shader cache
+	auto shaderStart = std::chrono::high_resolution_clock::now();
+
+	m_phongShader = MaterialShader(fs::current_path().string() + "\\resources\\shaders\\phong.vs",
+		fs::current_path().string() + "\\resources\\shaders\\phong.fs");
+	m_pbrShader = MaterialShader(fs::current_path().string() + "\\resources\\shaders\\pbr.vs",
+		fs::current_path().string() + "\\resources\\shaders\\pbr.fs");
+	m_phongInstancedShader = MaterialShader(fs::current_path().string() + "\\resources\\shaders\\phongInstanced.vs",
+		fs::current_path().string() + "\\resources\\shaders\\phong.fs");
+	m_pbrInstancedShader = MaterialShader(fs::current_path().string() + "\\resources\\shaders\\pbrInstanced.vs",
+		fs::current_path().string() + "\\resources\\shaders\\pbr.fs");
+	m_phongIndirectShader = Shader((fs::current_path().string() + "\\resources\\shaders\\phongIndirect.vs").c_str(),
+		(fs::current_path().string() + "\\resources\\shaders\\phongIndirect.fs").c_str());
+	m_pbrIndirectShader = Shader((fs::current_path().string() + "\\resources\\shaders\\pbrIndirect.vs").c_str(),
+		(fs::current_path().string() + "\\resources\\shaders\\pbrIndirect.fs").c_str());
 	m_skyboxShader = Shader((fs::current_path().string() + "\\resources\\shaders\\skybox.vs").c_str(),
 		(fs::current_path().string() + "\\resources\\shaders\\skybox.fs").c_str());
 
+	m_occlusionCuller.initialise(fs::current_path().string() + "\\resources\\shaders\\");
+
+	// every material permutation is started now so the driver can compile them side by side
+	MaterialShader* materialShaders[] = { &m_phongShader, &m_pbrShader, &m_phongInstancedShader, &m_pbrInstancedShader };
+	for (MaterialShader* shader : materialShaders)
+	{
+		shader->compileAll();
+	}
+
+	// waiting for all of them here is what makes the startup cost measurable
+	for (MaterialShader* shader : materialShaders)
+	{
+		shader->finishLinking();
+	}
+	m_phongIndirectShader.finishLinking();
+	m_pbrIndirectShader.finishLinking();
+	m_skyboxShader.finishLinking();
+
+	ShaderCacheStats shaderStats = ShaderCache::getStats();
+	std::cout << "Shaders ready in " << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - shaderStart).count()
+		<< " ms (" << shaderStats.loaded << " from the shader cache, " << shaderStats.compiled << " compiled)" << std::endl;
+
+	// the skybox cubemap always uses slot 0 so the sampler only has to be set once
+	m_skyboxShader.bind();
+	m_skyboxShader.set(UniformID("skybox"), 0);
+
 	m_shaderToUse = &m_phongShader;
+	m_instancedShaderToUse = &m_phongInstancedShader;
+	m_indirectShaderToUse = &m_phongIndirectShader;
 
 	for (OBJMesh* currentMesh : m_meshes)
 	{
 		currentMesh->toggleNormalMaps();
 	}
 
+	TextureMemoryTracker::getInstance().setLogInterval(TextureMemoryLogInterval);
+	TextureStreamer::getInstance().setBudget(TextureStreamingBudget);
+
+	// pooled meshes reach their textures through the material texture table, which needs new GL textures as mips change
+	TextureStreamer::getInstance().setAllowSparse(false);
+
 	// procedually create skybox mesh
 	m_skybox.initialiseBox();
 
-	// load skybox textures into a cubemap
+	// load skybox textures into a cubemap in the background, it is grey until they arrive
 	std::vector<std::string> skyboxTextures;
 	skyboxTextures.push_back(fs::current_path().string() + "\\resources\\textures\\sky2\\right.png");
 	skyboxTextures.push_back(fs::current_path().string() + "\\resources\\textures\\sky2\\left.png");
@@ -107,7 +179,7 @@ void OpenGLApplication::setup()
 	skyboxTextures.push_back(fs::current_path().string() + "\\resources\\textures\\sky2\\down.png");
 	skyboxTextures.push_back(fs::current_path().string() + "\\resources\\textures\\sky2\\front.png");
 	skyboxTextures.push_back(fs::current_path().string() + "\\resources\\textures\\sky2\\back.png");
-	m_cubemap.load(skyboxTextures);
+	AssetLoader::getInstance().loadCubemap(m_cubemap, skyboxTextures, Color(64, 64, 64, 255));
 
 	// set up light(s)
 	DirectionalLight dLight;
@@ -117,7 +189,7 @@ void OpenGLApplication::setup()
 	dLight.specular = glm::vec3(1.0f);
 	dLight.direction = glm::normalize(glm::vec3(1.0f, -1.0f, -1.0f));
 
-	m_directionalLights.push_back(dLight);
+	m_lights.addDirectionalLight(dLight);
 
 	// set camera position
 	m_camera.setPosition(glm::vec3(0, 15, 25));
@@ -142,6 +214,21 @@ void OpenGLApplication::update()
 	// update Time
 	Time::getInstance().update();
 
+	// start counting a new frame of render stats
+	RenderStats::getInstance().beginFrame();
+
+	// create the GL objects of assets that finished loading
+	AssetLoader::getInstance().update(AssetUploadBudget);
+
+	// page texture mips in and out for what was drawn last frame
+	TextureStreamer::getInstance().update();
+
+	// log where texture memory is going every so often
+	TextureMemoryTracker::getInstance().update(Time::getInstance().deltaTime());
+
+	// refit the scene's bvh to whatever moved (or rebuild it if meshes finished loading)
+	updateScene();
+
 	// process input
 	processInput();
 }
@@ -152,64 +239,165 @@ void OpenGLApplication::render()
 	glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// bind shader
-	m_shaderToUse->bind();
-
-	// store time as a float
-	float time = (float)glfwGetTime();
-
-	m_shaderToUse->setInt("pointLightCount", (int)m_pointLights.size());
-	m_shaderToUse->setInt("directionalLightCount", (int)m_directionalLights.size());
+	// upload the lights (only does any work if they changed)
+	m_lights.update();
+
+	// write everything that is constant for the frame once, every shader reads it from the same buffer
+	m_frameConstants.view = m_camera.GetViewMatrix();
+	m_frameConstants.projection = m_camera.getProjectionMatrix();
+	m_frameConstants.projectionView = m_camera.getProjectionViewMatrix();
+	m_frameConstants.cameraPosition = glm::vec4(m_camera.getPosition(), 1.0f);
+	m_frameConstants.time = (float)glfwGetTime();
+	m_frameConstants.correctGamma = correctGamma ? 1 : 0;
+	m_frameConstants.directionalLightCount = (int)m_lights.getDirectionalLightCount();
+	m_frameConstants.pointLightCount = (int)m_lights.getPointLightCount();
+	m_frameConstants.spotLightCount = (int)m_lights.getSpotLightCount();
+	m_frameConstantBuffer.update(m_frameConstants);
+
+	// queue up meshes
+	m_renderQueue.begin(m_camera);
+	m_multiDrawQueue.begin();
+	MaterialTable::getInstance().begin();
+
+	// chunks and instances outside the camera's view are never submitted, the scene bvh finds the ones inside
+	FrameStats& stats = RenderStats::getInstance().current();
+
+	Frustum frustum(m_camera.getProjectionViewMatrix());
+	m_scene.queryFrustum(frustum, m_visibleItems);
+
+	for (InstancedMesh& instanced : m_instancedMeshes)
+	{
+		instanced.visible.assign(instanced.transforms.size(), 0);
+	}
 
-	for (size_t i = 0; i < m_pointLights.size(); i++)
+	unsigned int meshChunkCount = 0;
+	unsigned int visibleChunkCount = 0;
+	for (unsigned int i = 0; i < m_meshes.size(); i++)
 	{
-		m_pointLights[i].bind(*m_shaderToUse, (int)i);
+		meshChunkCount += (unsigned int)m_meshes[i]->getChunkCount();
+
+		// the meshes were added to the scene first, in order
+		if (i < m_scene.getInstanceCount())
+		{
+			m_meshes[i]->requestTextureLevels(m_scene.getTransform(i), m_camera);
+		}
 	}
-	for (size_t i = 0; i < m_directionalLights.size(); i++)
+
+	for (const SceneItem& item : m_visibleItems)
 	{
-		m_directionalLights[i].bind(*m_shaderToUse, (int)i);
+		const SceneEntry& entry = m_sceneEntries[item.instance];
+
+		// instanced copies are drawn together below
+		if (entry.instancedMesh >= 0)
+		{
+			m_instancedMeshes[entry.instancedMesh].visible[entry.index] = 1;
+			continue;
+		}
+
+		OBJMesh* currentMesh = m_meshes[entry.index];
+		const glm::mat4& model = m_scene.getTransform(item.instance);
+		unsigned int lod = m_useLods ? currentMesh->selectLod(item.chunk, model, m_camera, LodPixelError) : 0;
+
+		if (m_useMultiDraw && currentMesh->isPooled())
+		{
+			currentMesh->submitChunk(m_multiDrawQueue, item.chunk, model, lod);
+		}
+		else
+		{
+			currentMesh->submitChunk(m_renderQueue, *m_shaderToUse, item.chunk, model, lod);
+		}
+
+		visibleChunkCount++;
 	}
 
-	m_shaderToUse->setVec3("cameraPosition", m_camera.getPosition());
+	stats.visibleChunks += visibleChunkCount;
+	stats.culledChunks += meshChunkCount - visibleChunkCount;
 
-	m_shaderToUse->setBool("correctGamma", correctGamma);
+	// sort and draw meshes
+	m_renderQueue.flush();
 
-	// draw meshes
-	glm::mat4 model(1);
-	model = glm::scale(model, glm::vec3(0.01f));
+	// draw every pooled mesh with a handful of multi draws
+	m_multiDrawQueue.flush(*m_indirectShaderToUse, m_geometryPool, m_useOcclusionCulling ? &m_occlusionCuller : nullptr);
 
-	for (OBJMesh* currentMesh : m_meshes)
+	// draw every copy of each instanced mesh at once
+	if (!m_instancedMeshes.empty())
 	{
-		m_shaderToUse->setMat4("ModelMatrix", model);
-		m_shaderToUse->setMat3("NormalMatrix", glm::inverseTranspose(model));
-		m_shaderToUse->setMat4("ProjectionViewModel", m_camera.getProjectionViewMatrix() * model);
-		currentMesh->draw(*m_shaderToUse);
-
-		model = glm::translate(model, glm::vec3(750, 0, 0));
+		for (InstancedMesh& instanced : m_instancedMeshes)
+		{
+			// a copy is drawn (whole) if any of its chunks was found
+			m_visibleTransforms.clear();
+			for (size_t i = 0; i < instanced.transforms.size(); i++)
+			{
+				if (instanced.visible[i])
+				{
+					m_visibleTransforms.push_back(instanced.transforms[i]);
+				}
+			}
+			stats.culledInstances += (unsigned int)(instanced.transforms.size() - m_visibleTransforms.size());
+
+			// the nearest copy decides the mips every copy gets
+			const glm::mat4* nearest = nullptr;
+			float nearestDistance = FLT_MAX;
+			for (const glm::mat4& transform : m_visibleTransforms)
+			{
+				float distance = glm::length(glm::vec3(transform[3]) - m_camera.getPosition());
+				if (distance < nearestDistance)
+				{
+					nearest = &transform;
+					nearestDistance = distance;
+				}
+			}
+
+			if (nearest != nullptr)
+			{
+				instanced.mesh->requestTextureLevels(*nearest, m_camera);
+			}
+
+			// one instanced draw per level of detail the copies need
+			for (std::vector<glm::mat4>& transforms : m_lodTransforms)
+			{
+				transforms.clear();
+			}
+
+			for (const glm::mat4& transform : m_visibleTransforms)
+			{
+				unsigned int lod = m_useLods ? instanced.mesh->selectLod(transform, m_camera, LodPixelError) : 0;
+				m_lodTransforms[lod].push_back(transform);
+			}
+
+			for (unsigned int lod = 0; lod < MaxMeshLods; lod++)
+			{
+				instanced.mesh->drawInstanced(*m_instancedShaderToUse, m_lodTransforms[lod], lod);
+			}
+		}
 	}
 
 	// draw skybox
 
 	// use less than or equal for the depth function to allow the skybox to draw when the z buffer is empty
-	glDepthFunc(GL_LEQUAL);
-	glDisable(GL_CULL_FACE);
+	GLState::getInstance().setDepthFunc(GL_LEQUAL);
+	GLState::getInstance().setCullFace(false);
 
 	// bind skybox shader
 	m_skyboxShader.bind();
 
-	// remove the translation component of the view matrix for the skybox
-	m_skyboxShader.setMat4("view", glm::mat4(glm::mat3(m_camera.GetViewMatrix())));
-	m_skyboxShader.setMat4("projection", m_camera.getProjectionMatrix());
-
 	// bind the cubemap to slot 0
 	m_cubemap.bind(0);
-	m_skyboxShader.setInt("skybox", 0);
 
 	// draw skybox
 	m_skybox.draw(m_skyboxShader);
 
-	glDepthFunc(GL_LESS);
-	glEnable(GL_CULL_FACE);
+	GLState::getInstance().setDepthFunc(GL_LESS);
+	GLState::getInstance().setCullFace(true);
+
+	// next frame's draws are occlusion tested against this frame's depth
+	if (m_useOcclusionCulling)
+	{
+		int width, height;
+		glfwGetFramebufferSize(m_window, &width, &height);
+
+		m_occlusionCuller.buildDepthPyramid((unsigned int)width, (unsigned int)height, m_camera.getProjectionViewMatrix());
+	}
 
 	// swap buffers and poll window events
 	glfwSwapBuffers(m_window);
@@ -239,6 +427,11 @@ void OpenGLApplication::processInput()
 		{
 			currentMesh->toggleNormalMaps();
 		}
+
+		for (InstancedMesh& instanced : m_instancedMeshes)
+		{
+			instanced.mesh->toggleNormalMaps();
+		}
 	}
 
 	// M toggles shaders
@@ -247,10 +440,14 @@ void OpenGLApplication::processInput()
 		if (m_shaderToUse == &m_phongShader)
 		{
 			m_shaderToUse = &m_pbrShader;
+			m_instancedShaderToUse = &m_pbrInstancedShader;
+			m_indirectShaderToUse = &m_pbrIndirectShader;
 		}
 		else
 		{
 			m_shaderToUse = &m_phongShader;
+			m_instancedShaderToUse = &m_phongInstancedShader;
+			m_indirectShaderToUse = &m_phongIndirectShader;
 		}
 	}
 
@@ -260,6 +457,55 @@ void OpenGLApplication::processInput()
 		correctGamma = !correctGamma;
 	}
 
+	// P prints the render stats of the last frame
+	if (Input::getInstance().getPressed(GLFW_KEY_P))
+	{
+		RenderStats::getInstance().print();
+		TextureCache::getInstance().printStats();
+		TextureMemoryTracker::getInstance().print();
+		TextureStreamer::getInstance().printStats();
+		MaterialTextureTable::getInstance().printStats();
+
+		std::cout << "Materials this frame: " << MaterialTable::getInstance().size()
+			<< ", shader permutations: " << m_phongShader.getPermutationCount() + m_phongInstancedShader.getPermutationCount()
+			<< " phong, " << m_pbrShader.getPermutationCount() + m_pbrInstancedShader.getPermutationCount() << " pbr" << std::endl;
+	}
+
+	// left click picks the chunk under the crosshair
+	if (Input::getInstance().getPressed(GLFW_MOUSE_BUTTON_LEFT))
+	{
+		glm::vec3 origin, direction;
+		m_camera.getPickRay(origin, direction);
+
+		SceneRayHit hit;
+		if (m_scene.raycast(origin, direction, hit))
+		{
+			std::cout << "Picked " << m_scene.getMesh(hit.instance)->getFilename() << " chunk " << hit.chunk << " at distance " << hit.distance << std::endl;
+		}
+		else
+		{
+			std::cout << "Picked nothing" << std::endl;
+		}
+	}
+
+	// I toggles multi draw indirect batching of pooled meshes
+	if (Input::getInstance().getPressed(GLFW_KEY_I))
+	{
+		m_useMultiDraw = !m_useMultiDraw;
+	}
+
+	// L toggles level of detail selection
+	if (Input::getInstance().getPressed(GLFW_KEY_L))
+	{
+		m_useLods = !m_useLods;
+	}
+
+	// O toggles GPU occlusion culling of the multi draws
+	if (Input::getInstance().getPressed(GLFW_KEY_O))
+	{
+		m_useOcclusionCulling = !m_useOcclusionCulling;
+	}
+
 	// move camera with WASD / arrow keys
 	if (Input::getInstance().getHeld(GLFW_KEY_W) || Input::getInstance().getHeld(GLFW_KEY_UP))
 		m_camera.processKeyboard(FORWARD);
@@ -272,15 +518,71 @@ void OpenGLApplication::processInput()
 
 	// draw in wireframe if space is held
 	if (Input::getInstance().getHeld(GLFW_KEY_SPACE))
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		GLState::getInstance().setPolygonMode(GL_LINE);
 	else
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		GLState::getInstance().setPolygonMode(GL_FILL);
+}
+
+// put every mesh and instanced copy in the scene's bvh
+void OpenGLApplication::updateScene()
+{
+	size_t chunkCount = 0;
+
+	for (OBJMesh* currentMesh : m_meshes)
+	{
+		chunkCount += currentMesh->getChunkCount();
+	}
+
+	for (InstancedMesh& instanced : m_instancedMeshes)
+	{
+		chunkCount += instanced.mesh->getChunkCount() * instanced.transforms.size();
+	}
+
+	// nothing new has loaded, just refit what moved
+	if (chunkCount == m_sceneChunkCount)
+	{
+		m_scene.update();
+		return;
+	}
+
+	m_sceneChunkCount = chunkCount;
+	m_scene.clear();
+	m_sceneEntries.clear();
+
+	// meshes are laid out in a row
+	glm::mat4 model(1);
+	model = glm::scale(model, glm::vec3(0.01f));
+
+	for (unsigned int i = 0; i < m_meshes.size(); i++)
+	{
+		m_scene.addInstance(m_meshes[i], model);
+		m_sceneEntries.push_back({ -1, i });
+
+		model = glm::translate(model, glm::vec3(750, 0, 0));
+	}
+
+	for (unsigned int i = 0; i < m_instancedMeshes.size(); i++)
+	{
+		for (unsigned int copy = 0; copy < m_instancedMeshes[i].transforms.size(); copy++)
+		{
+			m_scene.addInstance(m_instancedMeshes[i].mesh, m_instancedMeshes[i].transforms[copy]);
+			m_sceneEntries.push_back({ (int)i, copy });
+		}
+	}
+
+	m_scene.build();
 }
 
 void OpenGLApplication::exit()
 {
-	// terminate glfw
-	glfwTerminate();
+	// the cache's own references have to go while there is still a context to delete them in
+	TextureCache::getInstance().clear();
+	MaterialTable::getInstance().clear();
+	MaterialTextureTable::getInstance().clear();
+	SamplerCache::getInstance().clear();
+
+	// glfw is terminated by m_glfwTerminator once the GL resources have been released
+	glfwSetWindowShouldClose(m_window, true);
 }
 
 // whenever the mouse is moved this callback is run
@@ -7,12 +7,19 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Shader.h"
+#include "MaterialShader.h"
 #include "FlyCamera.h"
-#include "Light.h"
+#include "LightBuffer.h"
 #include "Mesh.h"
 #include "OBJMesh.h"
 #include "Cubemap.h"
 #include "RenderTarget.h"
+#include "FrameConstants.h"
+#include "RenderQueue.h"
+#include "GeometryPool.h"
+#include "MultiDrawQueue.h"
+#include "OcclusionCuller.h"
+#include "SceneBVH.h"
 #include "Color.h"
 
 // OpenGLApplication class that manages everything
@@ -38,29 +45,93 @@ private:
 	void update();
 	void render();
 	void processInput();
+	void updateScene();
 	void exit();
 
+	// terminates glfw after every member below (and the GL objects they own) has been destroyed
+	struct GLFWTerminator
+	{
+		~GLFWTerminator() { glfwTerminate(); }
+	} m_glfwTerminator;
+
 	// window width / height
 	GLFWwindow* m_window = nullptr;
 	unsigned int m_windowWidth;
 	unsigned int m_windowHeight;
 
-	// Shader(s)
-	Shader m_phongShader;
-	Shader m_pbrShader;
-	Shader* m_shaderToUse = nullptr;
+	// Shader(s), a permutation per set of material features
+	MaterialShader m_phongShader;
+	MaterialShader m_pbrShader;
+	MaterialShader* m_shaderToUse = nullptr;
+
+	// instanced variants, toggled together with the shaders above
+	MaterialShader m_phongInstancedShader;
+	MaterialShader m_pbrInstancedShader;
+	MaterialShader* m_instancedShaderToUse = nullptr;
+
+	// multi draw indirect variants
+	Shader m_phongIndirectShader;
+	Shader m_pbrIndirectShader;
+	Shader* m_indirectShaderToUse = nullptr;
 
 	// Light(s)
-	std::vector<DirectionalLight> m_directionalLights;
-	std::vector<PointLight> m_pointLights;
+	LightBuffer m_lights;
+
+	// per frame constants shared by every shader
+	FrameConstants m_frameConstants;
+	FrameConstantBuffer m_frameConstantBuffer;
 
 	// skybox
 	Mesh m_skybox; // skybox mesh
 	Shader m_skyboxShader; // skybox shader
 	Cubemap m_cubemap; // skybox cubemap texture
 
-	// Mesh(es)
+	// shared buffers meshes are loaded into so they can be batched, in the compact vertex format
+	GeometryPool m_geometryPool{ VertexFormat::Compact };
+
+	// Mesh(es), pooled ones are drawn through the multi draw queue
 	std::vector<OBJMesh*> m_meshes;
 
+	// mesh(es) drawn many times with one instanced draw per chunk
+	struct InstancedMesh
+	{
+		OBJMesh* mesh = nullptr;
+		std::vector<glm::mat4> transforms;
+		std::vector<unsigned char> visible; // copies found in the frustum this frame
+	};
+	std::vector<InstancedMesh> m_instancedMeshes;
+
+	// copies of the instanced mesh being drawn that are inside the frustum, and those split by level of detail
+	std::vector<glm::mat4> m_visibleTransforms;
+	std::vector<glm::mat4> m_lodTransforms[MaxMeshLods];
+
+	// distant chunks and copies are drawn with simplified levels of detail
+	bool m_useLods = true;
+
+	// the chunks of every mesh and instanced copy, searched for culling and picking instead of the lists above
+	SceneBVH m_scene;
+
+	// what each scene instance is, a mesh in m_meshes (instancedMesh -1) or a copy of an instanced mesh
+	struct SceneEntry
+	{
+		int instancedMesh;
+		unsigned int index;
+	};
+	std::vector<SceneEntry> m_sceneEntries;
+
+	// chunks in the scene when it was built, meshes still loading in the background add theirs later
+	size_t m_sceneChunkCount = 0;
+
+	std::vector<SceneItem> m_visibleItems;
+
+	// sorted draws for the frame
+	RenderQueue m_renderQueue;
+	MultiDrawQueue m_multiDrawQueue;
+	bool m_useMultiDraw = true;
+
+	// drops multi draws behind last frame's depth before they are shaded
+	OcclusionCuller m_occlusionCuller;
+	bool m_useOcclusionCulling = true;
+
 	bool correctGamma = false;
 };
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <glm\gtc\matrix_inverse.hpp>
+#include "RenderStats.h"
+#include "GLState.h"
+#include "MaterialTable.h"
+
+// per draw uniforms
+static constexpr UniformID modelMatrixID("ModelMatrix");
+static constexpr UniformID normalMatrixID("NormalMatrix");
+
+// start a new frame of draws seen from a camera
+void RenderQueue::begin(Camera& camera)
+{
+	m_items.clear();
+	m_sortEntries.clear();
+
+	m_view = camera.GetViewMatrix();
+	m_farPlane = camera.getFarPlane();
+}
+
+void RenderQueue::submit(RenderPass pass, Shader& shader, const Material* material, unsigned int vao,
+	unsigned int indexCount, const glm::mat4& transform, GLenum primitive,
+	unsigned int firstIndex, int baseVertex, GLenum indexType)
+{
+	DrawItem item;
+	item.shader = &shader;
+	item.material = material;
+	item.vao = vao;
+	item.indexCount = indexCount;
+	item.firstIndex = firstIndex;
+	item.baseVertex = baseVertex;
+	item.primitive = primitive;
+	item.indexType = indexType;
+	item.transform = transform;
+
+	// quantise the view space depth of the object's origin to 16 bits
+	float viewDepth = -(m_view * transform[3]).z;
+	float depth01 = glm::clamp(viewDepth / m_farPlane, 0.0f, 1.0f);
+	unsigned int depth = (unsigned int)(depth01 * 65535.0f);
+
+	SortEntry entry;
+	entry.key = makeKey(pass, shader.ID, material != nullptr ? material->id : 0, vao, depth);
+	entry.item = (unsigned int)m_items.size();
+
+	m_items.push_back(item);
+	m_sortEntries.push_back(entry);
+}
+
+// sort and draw everything submitted since begin
+void RenderQueue::flush()
+{
+	FrameStats& stats = RenderStats::getInstance().current();
+
+	// only the small key / index pairs are moved around while sorting
+	std::sort(m_sortEntries.begin(), m_sortEntries.end(), [](const SortEntry& a, const SortEntry& b)
+	{
+		return a.key < b.key;
+	});
+
+	// put every material in the table up front so it is uploaded once rather than as draws find new ones
+	MaterialTable& materialTable = MaterialTable::getInstance();
+	for (const DrawItem& item : m_items)
+	{
+		if (item.material != nullptr)
+		{
+			materialTable.add(*item.material);
+		}
+	}
+	materialTable.upload();
+
+	Shader* currentShader = nullptr;
+	const Material* currentMaterial = nullptr;
+	unsigned int currentVao = 0;
+
+	UniformHandle<glm::mat4> modelMatrix;
+	UniformHandle<glm::mat3> normalMatrix;
+
+	for (const SortEntry& entry : m_sortEntries)
+	{
+		const DrawItem& item = m_items[entry.item];
+
+		if (item.shader != currentShader)
+		{
+			currentShader = item.shader;
+			currentShader->bind();
+
+			modelMatrix = currentShader->getUniform<glm::mat4>(modelMatrixID);
+			normalMatrix = currentShader->getUniform<glm::mat3>(normalMatrixID);
+
+			// the material index uniform belongs to the program so it has to be sent again
+			currentMaterial = nullptr;
+		}
+
+		if (item.material != currentMaterial && item.material != nullptr)
+		{
+			currentMaterial = item.material;
+			currentMaterial->bind(*currentShader);
+			stats.materialBinds++;
+		}
+
+		if (item.vao != currentVao)
+		{
+			currentVao = item.vao;
+			GLState::getInstance().bindVertexArray(currentVao);
+		}
+
+		currentShader->set(modelMatrix, item.transform);
+		currentShader->set(normalMatrix, glm::mat3(glm::inverseTranspose(item.transform)));
+
+		// firstIndex counts indices, the offset is in bytes
+		size_t indexSize = item.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+		glDrawElementsBaseVertex(item.primitive, item.indexCount, item.indexType,
+			(void*)(item.firstIndex * indexSize), item.baseVertex);
+		stats.drawCalls++;
+		stats.triangles += item.indexCount / 3;
+	}
+
+	m_items.clear();
+	m_sortEntries.clear();
+}
+
+unsigned long long RenderQueue::makeKey(RenderPass pass, unsigned int program, unsigned int material,
+	unsigned int vao, unsigned int depth)
+{
+	unsigned long long key = (unsigned long long)((unsigned int)pass & 0xF) << 60;
+
+	if (pass == RenderPass::Transparent)
+	{
+		// blended draws have to go back to front, state changes come second
+		key |= (unsigned long long)(0xFFFF - (depth & 0xFFFF)) << 44;
+		key |= (unsigned long long)(program & 0xFFF) << 32;
+		key |= (unsigned long long)(material & 0xFFFF) << 16;
+		key |= (unsigned long long)(vao & 0xFFFF);
+	}
+	else
+	{
+		// opaque draws are grouped by state, then front to back to help early depth rejection
+		key |= (unsigned long long)(program & 0xFFF) << 48;
+		key |= (unsigned long long)(material & 0xFFFF) << 32;
+		key |= (unsigned long long)(vao & 0xFFFF) << 16;
+		key |= (unsigned long long)(depth & 0xFFFF);
+	}
+
+	return key;
+}
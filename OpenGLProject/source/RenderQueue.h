@@ -0,0 +1,67 @@
+#pragma once
+#include <glad\glad.h>
+#include <glm\glm.hpp>
+#include <vector>
+#include "Shader.h"
+#include "Material.h"
+#include "Camera.h"
+
+// render passes, drawn in this order
+enum class RenderPass : unsigned int
+{
+	Opaque = 0,
+	Transparent = 1
+};
+
+// a single draw submitted to the render queue
+struct DrawItem
+{
+	Shader* shader = nullptr;
+	const Material* material = nullptr;
+	unsigned int vao = 0;
+	unsigned int indexCount = 0;
+	unsigned int firstIndex = 0;
+	int baseVertex = 0;
+	GLenum primitive = GL_TRIANGLES;
+	GLenum indexType = GL_UNSIGNED_INT;
+	glm::mat4 transform = glm::mat4(1);
+};
+
+// collects draws for a frame, sorts them to minimise state changes and submits them
+// skipping any program / material / vertex array bind that is already current
+class RenderQueue
+{
+public:
+
+	// start a new frame of draws seen from a camera
+	void begin(Camera& camera);
+
+	void submit(RenderPass pass, Shader& shader, const Material* material, unsigned int vao,
+		unsigned int indexCount, const glm::mat4& transform, GLenum primitive = GL_TRIANGLES,
+		unsigned int firstIndex = 0, int baseVertex = 0, GLenum indexType = GL_UNSIGNED_INT);
+
+	// sort and draw everything submitted since begin
+	void flush();
+
+	size_t size() const { return m_items.size(); }
+
+private:
+
+	// sort key of a draw
+	// opaque:      pass (4) | program (12) | material (16) | vertex array (16) | depth front to back (16)
+	// transparent: pass (4) | depth back to front (16) | program (12) | material (16) | vertex array (16)
+	static unsigned long long makeKey(RenderPass pass, unsigned int program, unsigned int material,
+		unsigned int vao, unsigned int depth);
+
+	struct SortEntry
+	{
+		unsigned long long key;
+		unsigned int item;
+	};
+
+	std::vector<DrawItem> m_items;
+	std::vector<SortEntry> m_sortEntries;
+
+	glm::mat4 m_view = glm::mat4(1);
+	float m_farPlane = 1000.0f;
+};
@@ -0,0 +1,40 @@
+#include "RenderStats.h"
+#include <iostream>
+
+RenderStats& RenderStats::getInstance()
+{
+	static RenderStats instance;
+	return instance;
+}
+
+// store the finished frame and start counting a new one
+void RenderStats::beginFrame()
+{
+	m_lastFrame = m_current;
+	m_current = FrameStats();
+}
+
+// print the counters of the last complete frame
+void RenderStats::print() const
+{
+	std::cout << "---- render stats ----" << std::endl;
+	std::cout << "uniform name lookups: " << m_lastFrame.uniformNameLookups << std::endl;
+	std::cout << "draw calls: " << m_lastFrame.drawCalls << std::endl;
+	std::cout << "instances: " << m_lastFrame.instances << std::endl;
+	std::cout << "triangles: " << m_lastFrame.triangles << std::endl;
+	std::cout << "indirect draws: " << m_lastFrame.indirectDraws << std::endl;
+	std::cout << "program binds: " << m_lastFrame.programBinds << std::endl;
+	std::cout << "material binds: " << m_lastFrame.materialBinds << std::endl;
+	std::cout << "texture binds: " << m_lastFrame.textureBinds << std::endl;
+	std::cout << "sampler binds: " << m_lastFrame.samplerBinds << std::endl;
+	std::cout << "vertex array binds: " << m_lastFrame.vertexArrayBinds << std::endl;
+	std::cout << "visible chunks: " << m_lastFrame.visibleChunks << std::endl;
+	std::cout << "culled chunks: " << m_lastFrame.culledChunks << std::endl;
+	std::cout << "culled instances: " << m_lastFrame.culledInstances << std::endl;
+	std::cout << "gpu culled draws: " << m_lastFrame.gpuFrustumCulledDraws << " frustum, " << m_lastFrame.occlusionCulledDraws << " occluded of "
+		<< m_lastFrame.gpuTestedDraws << " (" << (m_lastFrame.gpuTestedDraws > 0 ? 100.0f * m_lastFrame.occlusionCulledDraws / m_lastFrame.gpuTestedDraws : 0.0f)
+		<< "% occluded)" << std::endl;
+	std::cout << "state calls: " << m_lastFrame.stateCalls << std::endl;
+	std::cout << "redundant state calls skipped: " << m_lastFrame.redundantStateCalls << std::endl;
+	std::cout << "asset uploads: " << m_lastFrame.assetUploads << std::endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// counters gathered over a single frame
+struct FrameStats
+{
+	unsigned int uniformNameLookups = 0; // uniforms set by string name instead of a handle / hashed id
+
+	unsigned int drawCalls = 0;
+	unsigned int instances = 0; // instances drawn by instanced draw calls
+	unsigned int triangles = 0; // submitted, before any GPU culling
+	unsigned int indirectDraws = 0; // draws packed into multi draw indirect calls (each call counts once in drawCalls)
+	unsigned int programBinds = 0;
+	unsigned int materialBinds = 0;
+	unsigned int textureBinds = 0;
+	unsigned int samplerBinds = 0;
+	unsigned int vertexArrayBinds = 0;
+
+	unsigned int visibleChunks = 0; // mesh chunks that passed the frustum test and were submitted
+	unsigned int culledChunks = 0; // mesh chunks outside the frustum
+	unsigned int culledInstances = 0; // copies of instanced meshes outside the frustum
+
+	// multi draws tested by the GPU culling pass (see OcclusionCuller), counted on the GPU so a few frames old
+	unsigned int gpuTestedDraws = 0;
+	unsigned int gpuFrustumCulledDraws = 0;
+	unsigned int occlusionCulledDraws = 0; // inside the frustum but behind the previous frame's depth
+
+	unsigned int stateCalls = 0; // state changes that reached GL
+	unsigned int redundantStateCalls = 0; // state changes skipped by GLState because nothing would change
+
+	unsigned int assetUploads = 0; // background loads finished on the GL thread (see AssetLoader)
+};
+
+// singleton render statistics manager
+class RenderStats
+{
+public:
+
+	static RenderStats& getInstance();
+
+	// store the finished frame and start counting a new one
+	void beginFrame();
+
+	FrameStats& current() { return m_current; }
+	const FrameStats& lastFrame() const { return m_lastFrame; }
+
+	void print() const;
+
+private:
+
+	RenderStats() {};
+	~RenderStats() {};
+
+	FrameStats m_current;
+	FrameStats m_lastFrame;
+};
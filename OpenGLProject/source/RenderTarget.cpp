@@ -1,6 +1,8 @@
 #include "RenderTarget.h"
 #include <glad\glad.h>
 #include <vector>
+#include "GLObjectTracker.h"
+#include "GLState.h"
 
 RenderTarget::RenderTarget(unsigned int targetCount, unsigned int width, unsigned int height)
 {
@@ -11,7 +13,8 @@ bool RenderTarget::initialise(unsigned int targetCount, unsigned int width, unsi
 {
 	// setup and bind a framebuffer object
 	glGenFramebuffers(1, &m_fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	GL_TRACK_CREATED(GLObjectType::Framebuffer, m_fbo, "RenderTarget");
+	GLState::getInstance().bindFramebuffer(m_fbo);
 
 	// create and attach textures
 	if (targetCount > 0)
@@ -35,6 +38,7 @@ bool RenderTarget::initialise(unsigned int targetCount, unsigned int width, unsi
 
 	// setup and bind a 24bit depth buffer as a render buffer
 	glGenRenderbuffers(1, &m_rbo);
+	GL_TRACK_CREATED(GLObjectType::Renderbuffer, m_rbo, "RenderTarget");
 	glBindRenderbuffer(GL_RENDERBUFFER, m_rbo);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
 		width, height);
@@ -44,10 +48,13 @@ bool RenderTarget::initialise(unsigned int targetCount, unsigned int width, unsi
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 	{
 		// cleanup
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::getInstance().bindFramebuffer(0);
 		delete[] m_targets;
 		m_targets = nullptr;
+		GL_TRACK_DELETED(GLObjectType::Renderbuffer, m_rbo);
+		GL_TRACK_DELETED(GLObjectType::Framebuffer, m_fbo);
 		glDeleteRenderbuffers(1, &m_rbo);
+		GLState::getInstance().framebufferDeleted(m_fbo);
 		glDeleteFramebuffers(1, &m_fbo);
 		m_rbo = 0;
 		m_fbo = 0;
@@ -56,7 +63,7 @@ bool RenderTarget::initialise(unsigned int targetCount, unsigned int width, unsi
 	}
 
 	// success
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::getInstance().bindFramebuffer(0);
 	m_targetCount = targetCount;
 	m_width = width;
 	m_height = height;
@@ -67,16 +74,19 @@ bool RenderTarget::initialise(unsigned int targetCount, unsigned int width, unsi
 RenderTarget::~RenderTarget()
 {
 	delete[] m_targets;
+	GL_TRACK_DELETED(GLObjectType::Renderbuffer, m_rbo);
+	GL_TRACK_DELETED(GLObjectType::Framebuffer, m_fbo);
 	glDeleteRenderbuffers(1, &m_rbo);
+	GLState::getInstance().framebufferDeleted(m_fbo);
 	glDeleteFramebuffers(1, &m_fbo);
 }
 
 void RenderTarget::bind()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	GLState::getInstance().bindFramebuffer(m_fbo);
 }
 
 void RenderTarget::unbind()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::getInstance().bindFramebuffer(0);
 }
\ No newline at end of file
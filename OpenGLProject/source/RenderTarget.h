@@ -1,6 +1,7 @@
 #pragma once
 #include "Texture.h"
 
+// framebuffer with colour targets and a depth buffer, owns its GL objects so it can't be copied
 class RenderTarget
 {
 public:
@@ -9,6 +10,9 @@ public:
 	RenderTarget(unsigned int targetCount, unsigned int width, unsigned int height);
 	virtual ~RenderTarget();
 
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator = (const RenderTarget&) = delete;
+
 	bool initialise(unsigned int targetCount, unsigned int width, unsigned int height);
 
 	void bind();
@@ -0,0 +1,126 @@
+#include "SamplerCache.h"
+#include "GLExtensions.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+
+// EXT_texture_filter_anisotropic (core since 4.6 but the context is 4.3)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+SamplerDesc SamplerDesc::get(SamplerType type)
+{
+	SamplerDesc desc;
+
+	switch (type)
+	{
+	case SamplerType::Nearest:
+		desc.minFilter = GL_NEAREST;
+		desc.magFilter = GL_NEAREST;
+		desc.wrap = GL_CLAMP_TO_EDGE;
+		break;
+	case SamplerType::Clamp:
+		desc.wrap = GL_CLAMP_TO_EDGE;
+		break;
+	case SamplerType::Repeat:
+		desc.minFilter = GL_LINEAR;
+		break;
+	case SamplerType::Anisotropic:
+		desc.anisotropic = true;
+		break;
+	default:
+		break;
+	}
+
+	return desc;
+}
+
+SamplerDesc SamplerDesc::get(GLenum filter, GLenum wrap, bool mipmapped)
+{
+	SamplerDesc desc;
+	desc.magFilter = filter;
+	desc.wrap = wrap;
+
+	if (mipmapped)
+	{
+		desc.minFilter = filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+	}
+	else
+	{
+		desc.minFilter = filter;
+	}
+
+	return desc;
+}
+
+SamplerCache& SamplerCache::getInstance()
+{
+	static SamplerCache instance;
+	return instance;
+}
+
+unsigned long long SamplerCache::makeKey(const SamplerDesc& desc)
+{
+	// GL filter / wrap enums all fit in 16 bits
+	return (unsigned long long)(desc.minFilter & 0xFFFF) |
+		(unsigned long long)(desc.magFilter & 0xFFFF) << 16 |
+		(unsigned long long)(desc.wrap & 0xFFFF) << 32 |
+		(unsigned long long)(desc.anisotropic ? 1 : 0) << 48;
+}
+
+unsigned int SamplerCache::get(const SamplerDesc& desc)
+{
+	unsigned long long key = makeKey(desc);
+
+	auto found = m_samplers.find(key);
+	if (found != m_samplers.end())
+	{
+		return found->second;
+	}
+
+	GLuint sampler = 0;
+	glGenSamplers(1, &sampler);
+	GL_TRACK_CREATED(GLObjectType::Sampler, sampler, "SamplerCache");
+
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, desc.wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, desc.wrap);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, desc.wrap);
+
+	if (desc.anisotropic && getMaxAnisotropy() > 1.0f)
+	{
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, getMaxAnisotropy());
+	}
+
+	m_samplers[key] = sampler;
+	return sampler;
+}
+
+float SamplerCache::getMaxAnisotropy()
+{
+	if (m_maxAnisotropy == 0.0f)
+	{
+		m_maxAnisotropy = 1.0f;
+
+		if (GLExtensions::has("GL_EXT_texture_filter_anisotropic") || GLExtensions::has("GL_ARB_texture_filter_anisotropic"))
+		{
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_maxAnisotropy);
+		}
+	}
+
+	return m_maxAnisotropy;
+}
+
+void SamplerCache::clear()
+{
+	for (auto& entry : m_samplers)
+	{
+		GL_TRACK_DELETED(GLObjectType::Sampler, entry.second);
+		GLState::getInstance().samplerDeleted(entry.second);
+		glDeleteSamplers(1, &entry.second);
+	}
+
+	m_samplers.clear();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <unordered_map>
+#include <glad\glad.h>
+
+// the shared samplers most textures use
+enum class SamplerType
+{
+	LinearMipLinear,	// trilinear, repeating
+	Nearest,			// no filtering or mips, clamped (render targets, 1x1 placeholders)
+	Clamp,				// trilinear, clamped to the edge
+	Repeat,				// bilinear without mips, repeating
+	Anisotropic			// trilinear with the driver's maximum anisotropy, repeating
+};
+
+// filtering and addressing of a sampler object
+struct SamplerDesc
+{
+	GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+	GLenum magFilter = GL_LINEAR;
+	GLenum wrap = GL_REPEAT;
+	bool anisotropic = false;
+
+	static SamplerDesc get(SamplerType type);
+
+	// the sampler matching a texture's filter / wrap options, linear filtering blends mips when there are any
+	static SamplerDesc get(GLenum filter, GLenum wrap, bool mipmapped);
+};
+
+// singleton cache of sampler objects, every texture and material with the same filtering binds the same one
+// so sampling state lives in a handful of objects instead of on each texture
+class SamplerCache
+{
+public:
+
+	static SamplerCache& getInstance();
+
+	// GL sampler for a description, created the first time it is asked for
+	unsigned int get(const SamplerDesc& desc);
+	unsigned int get(SamplerType type) { return get(SamplerDesc::get(type)); }
+
+	// 1 if the driver can't filter anisotropically
+	float getMaxAnisotropy();
+
+	// delete every sampler, call while the GL context is still alive
+	void clear();
+
+private:
+
+	SamplerCache() {};
+	~SamplerCache() {};
+
+	static unsigned long long makeKey(const SamplerDesc& desc);
+
+	std::unordered_map<unsigned long long, unsigned int> m_samplers;
+
+	float m_maxAnisotropy = 0.0f; // 0 until queried
+};
\ No newline at end of file
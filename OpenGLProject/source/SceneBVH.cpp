@@ -0,0 +1,650 @@
+#include "SceneBVH.h"
+#include "OBJMesh.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SCENEBVH_SSE
+#endif
+
+// candidate split planes per axis
+const int BinCount = 12;
+
+// items a leaf may hold before it is worth splitting
+const unsigned int MaxLeafItems = 2;
+
+// deeper than this the traversal stack would overflow
+const unsigned int MaxDepth = 60;
+const unsigned int StackSize = 64;
+
+// refitting lets boxes grow apart, rebuild once the tree costs this much more than it did when built
+const float RebuildCostRatio = 2.0f;
+
+const float DeterminantEpsilon = 1e-10f;
+
+static float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 size = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// distance along the ray to where it enters a box, FLT_MAX if it misses or enters beyond maxDistance
+static float intersectBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+	glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+// nearest hit of a ray with a chunk's triangles (Moller-Trumbore, one triangle per lane), FLT_MAX if none is closer than maxDistance
+static float intersectTriangles(const std::vector<TrianglePacket>& packets, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+#ifdef SCENEBVH_SSE
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 epsilon = _mm_set1_ps(DeterminantEpsilon);
+
+	// each lane keeps its own nearest hit, the lanes are merged at the end
+	__m128 best = _mm_set1_ps(maxDistance);
+
+	for (const TrianglePacket& packet : packets)
+	{
+		__m128 e1x = _mm_loadu_ps(packet.e1x), e1y = _mm_loadu_ps(packet.e1y), e1z = _mm_loadu_ps(packet.e1z);
+		__m128 e2x = _mm_loadu_ps(packet.e2x), e2y = _mm_loadu_ps(packet.e2y), e2z = _mm_loadu_ps(packet.e2z);
+
+		// p = direction x e2
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 inverseDet = _mm_div_ps(one, det);
+
+		// s = origin - v0
+		__m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(packet.v0x));
+		__m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(packet.v0y));
+		__m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(packet.v0z));
+
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+
+		// q = s x e1
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDet);
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+		// degenerate (and padding) triangles fail the determinant test, NaNs fail every compare
+		__m128 hit = _mm_cmpgt_ps(_mm_andnot_ps(signBit, det), epsilon);
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+		hit = _mm_and_ps(hit, _mm_cmplt_ps(t, best));
+
+		best = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, best));
+	}
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, best);
+
+	float nearest = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+	return nearest < maxDistance ? nearest : FLT_MAX;
+#else
+	float nearest = maxDistance;
+	bool found = false;
+
+	for (const TrianglePacket& packet : packets)
+	{
+		for (int lane = 0; lane < 4; lane++)
+		{
+			glm::vec3 e1(packet.e1x[lane], packet.e1y[lane], packet.e1z[lane]);
+			glm::vec3 e2(packet.e2x[lane], packet.e2y[lane], packet.e2z[lane]);
+
+			glm::vec3 p = glm::cross(direction, e2);
+			float det = glm::dot(e1, p);
+			if (std::fabs(det) <= DeterminantEpsilon)
+				continue;
+
+			float inverseDet = 1.0f / det;
+			glm::vec3 s = origin - glm::vec3(packet.v0x[lane], packet.v0y[lane], packet.v0z[lane]);
+
+			float u = glm::dot(s, p) * inverseDet;
+			if (u < 0.0f || u > 1.0f)
+				continue;
+
+			glm::vec3 q = glm::cross(s, e1);
+			float v = glm::dot(direction, q) * inverseDet;
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+
+			float t = glm::dot(e2, q) * inverseDet;
+			if (t > 0.0f && t < nearest)
+			{
+				nearest = t;
+				found = true;
+			}
+		}
+	}
+
+	return found ? nearest : FLT_MAX;
+#endif
+}
+
+unsigned int SceneBVH::addInstance(const OBJMesh* mesh, const glm::mat4& transform)
+{
+	Instance instance;
+	instance.mesh = mesh;
+	instance.transform = transform;
+	instance.inverse = glm::inverse(transform);
+	instance.firstItem = (unsigned int)m_items.size();
+	instance.itemCount = (unsigned int)mesh->getChunkCount();
+	instance.moved = false;
+
+	unsigned int index = (unsigned int)m_instances.size();
+	m_instances.push_back(instance);
+
+	for (unsigned int chunk = 0; chunk < instance.itemCount; chunk++)
+	{
+		Item item;
+		item.instance = index;
+		item.chunk = chunk;
+		updateItemBounds(item);
+
+		m_items.push_back(item);
+	}
+
+	m_needsBuild = true;
+
+	return index;
+}
+
+void SceneBVH::setTransform(unsigned int instance, const glm::mat4& transform)
+{
+	Instance& target = m_instances[instance];
+
+	target.transform = transform;
+	target.inverse = glm::inverse(transform);
+	target.moved = true;
+}
+
+void SceneBVH::clear()
+{
+	m_instances.clear();
+	m_items.clear();
+	m_order.clear();
+	m_nodes.clear();
+	m_parents.clear();
+	m_itemLeaves.clear();
+
+	m_needsBuild = false;
+	m_builtCost = 0.0f;
+}
+
+void SceneBVH::build()
+{
+	m_needsBuild = false;
+
+	for (Instance& instance : m_instances)
+		instance.moved = false;
+
+	for (Item& item : m_items)
+		updateItemBounds(item);
+
+	m_order.resize(m_items.size());
+	std::iota(m_order.begin(), m_order.end(), 0u);
+
+	m_itemLeaves.assign(m_items.size(), 0);
+	m_nodes.clear();
+	m_parents.clear();
+
+	if (m_items.empty())
+	{
+		m_builtCost = 0.0f;
+		return;
+	}
+
+	// a binary tree never has more than 2n - 1 nodes
+	m_nodes.reserve(m_items.size() * 2);
+	m_parents.reserve(m_items.size() * 2);
+
+	Node root;
+	root.first = 0;
+	root.count = (unsigned int)m_items.size();
+	fitNode(root);
+
+	m_nodes.push_back(root);
+	m_parents.push_back(0);
+
+	subdivide(0, 0);
+
+	m_builtCost = getCost();
+}
+
+void SceneBVH::update()
+{
+	if (m_needsBuild)
+	{
+		build();
+		return;
+	}
+
+	bool refitted = false;
+
+	for (Instance& instance : m_instances)
+	{
+		if (!instance.moved)
+			continue;
+
+		instance.moved = false;
+		refitted = true;
+
+		for (unsigned int i = instance.firstItem; i < instance.firstItem + instance.itemCount; i++)
+		{
+			updateItemBounds(m_items[i]);
+
+			// refit from the item's leaf up to the root
+			unsigned int node = m_itemLeaves[i];
+			while (true)
+			{
+				fitNode(m_nodes[node]);
+
+				if (node == 0)
+					break;
+
+				node = m_parents[node];
+			}
+		}
+	}
+
+	if (refitted && getCost() > m_builtCost * RebuildCostRatio)
+		build();
+}
+
+void SceneBVH::queryFrustum(const Frustum& frustum, std::vector<SceneItem>& items) const
+{
+	// items of leaves the frustum only clips, tested together afterwards so the plane tests run on 4 at a time
+	// (scratch shared by every query, culling only happens on the render thread)
+	static std::vector<SceneItem> candidates;
+	static BoxList boxes;
+	static std::vector<unsigned char> visible;
+
+	items.clear();
+	candidates.clear();
+	boxes.clear();
+
+	if (m_nodes.empty())
+		return;
+
+	unsigned int stack[StackSize];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		glm::vec3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		glm::vec3 extents = (node.boundsMax - node.boundsMin) * 0.5f;
+
+		if (!frustum.intersects(center, extents))
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			const Item& item = m_items[m_order[i]];
+
+			// a leaf of one item has the item's box, a bigger leaf can hold items that are outside on their own
+			if (node.count == 1)
+			{
+				items.push_back({ item.instance, item.chunk });
+			}
+			else
+			{
+				candidates.push_back({ item.instance, item.chunk });
+				boxes.add(item.boundsMin, item.boundsMax);
+			}
+		}
+	}
+
+	frustum.cull(boxes, visible);
+
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		if (visible[i])
+			items.push_back(candidates[i]);
+	}
+}
+
+void SceneBVH::querySphere(const glm::vec3& center, float radius, std::vector<SceneItem>& items) const
+{
+	items.clear();
+
+	if (m_nodes.empty())
+		return;
+
+	float radiusSquared = radius * radius;
+
+	auto touches = [&](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		glm::vec3 offset = center - glm::clamp(center, boundsMin, boundsMax);
+		return glm::dot(offset, offset) <= radiusSquared;
+	};
+
+	unsigned int stack[StackSize];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		if (!touches(node.boundsMin, node.boundsMax))
+			continue;
+
+		if (node.count == 0)
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			const Item& item = m_items[m_order[i]];
+
+			if (touches(item.boundsMin, item.boundsMax))
+				items.push_back({ item.instance, item.chunk });
+		}
+	}
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, SceneRayHit& hit, float maxDistance) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float nearest = maxDistance;
+	bool found = false;
+
+	unsigned int stack[StackSize];
+	unsigned int stackSize = 0;
+
+	if (intersectBox(m_nodes[0].boundsMin, m_nodes[0].boundsMax, origin, inverseDirection, nearest) != FLT_MAX)
+		stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		if (node.count == 0)
+		{
+			const Node& left = m_nodes[node.first];
+			const Node& right = m_nodes[node.first + 1];
+
+			float leftDistance = intersectBox(left.boundsMin, left.boundsMax, origin, inverseDirection, nearest);
+			float rightDistance = intersectBox(right.boundsMin, right.boundsMax, origin, inverseDirection, nearest);
+
+			// push the nearer child last so it is visited first and shortens the ray for the other
+			if (leftDistance <= rightDistance)
+			{
+				if (rightDistance != FLT_MAX)
+					stack[stackSize++] = node.first + 1;
+				if (leftDistance != FLT_MAX)
+					stack[stackSize++] = node.first;
+			}
+			else
+			{
+				if (leftDistance != FLT_MAX)
+					stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+
+			continue;
+		}
+
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			const Item& item = m_items[m_order[i]];
+
+			if (intersectBox(item.boundsMin, item.boundsMax, origin, inverseDirection, nearest) == FLT_MAX)
+				continue;
+
+			// test in object space, the direction isn't normalised again so distances stay in world units
+			const Instance& instance = m_instances[item.instance];
+			glm::vec3 localOrigin = glm::vec3(instance.inverse * glm::vec4(origin, 1.0f));
+			glm::vec3 localDirection = glm::vec3(instance.inverse * glm::vec4(direction, 0.0f));
+
+			float distance = intersectTriangles(instance.mesh->getChunkTriangles(item.chunk), localOrigin, localDirection, nearest);
+			if (distance < nearest)
+			{
+				nearest = distance;
+				found = true;
+
+				hit.instance = item.instance;
+				hit.chunk = item.chunk;
+			}
+		}
+	}
+
+	if (found)
+	{
+		hit.distance = nearest;
+		hit.position = origin + direction * nearest;
+	}
+
+	return found;
+}
+
+void SceneBVH::updateItemBounds(Item& item) const
+{
+	const Instance& instance = m_instances[item.instance];
+	const MeshChunk& chunk = instance.mesh->getChunk(item.chunk);
+
+	// box around the transformed box: the center moves with the transform, each axis of the extent adds its absolute projection
+	glm::vec3 center = glm::vec3(instance.transform * glm::vec4((chunk.boundsMin + chunk.boundsMax) * 0.5f, 1.0f));
+	glm::vec3 extents = (chunk.boundsMax - chunk.boundsMin) * 0.5f;
+
+	glm::vec3 worldExtents(0.0f);
+	for (int axis = 0; axis < 3; axis++)
+		worldExtents += glm::abs(glm::vec3(instance.transform[axis])) * extents[axis];
+
+	item.boundsMin = center - worldExtents;
+	item.boundsMax = center + worldExtents;
+}
+
+void SceneBVH::subdivide(unsigned int nodeIndex, unsigned int depth)
+{
+	Node node = m_nodes[nodeIndex];
+
+	auto makeLeaf = [&]()
+	{
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+			m_itemLeaves[m_order[i]] = nodeIndex;
+	};
+
+	if (node.count <= MaxLeafItems || depth >= MaxDepth)
+	{
+		makeLeaf();
+		return;
+	}
+
+	// split planes are placed between the item centers, not the node's bounds
+	glm::vec3 centroidMin(FLT_MAX);
+	glm::vec3 centroidMax(-FLT_MAX);
+
+	for (unsigned int i = node.first; i < node.first + node.count; i++)
+	{
+		const Item& item = m_items[m_order[i]];
+		glm::vec3 centroid = (item.boundsMin + item.boundsMax) * 0.5f;
+
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	struct Bin
+	{
+		glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+		glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+		unsigned int count = 0;
+	};
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		Bin bins[BinCount];
+		float scale = BinCount / extent;
+
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			const Item& item = m_items[m_order[i]];
+			float centroid = (item.boundsMin[axis] + item.boundsMax[axis]) * 0.5f;
+
+			Bin& bin = bins[std::min((int)((centroid - centroidMin[axis]) * scale), BinCount - 1)];
+			bin.boundsMin = glm::min(bin.boundsMin, item.boundsMin);
+			bin.boundsMax = glm::max(bin.boundsMax, item.boundsMax);
+			bin.count++;
+		}
+
+		// sweep from the left then the right so each plane's cost is the two sides' count * area
+		float leftArea[BinCount - 1], rightArea[BinCount - 1];
+		unsigned int leftCount[BinCount - 1], rightCount[BinCount - 1];
+
+		Bin left, right;
+		for (int i = 0; i < BinCount - 1; i++)
+		{
+			left.count += bins[i].count;
+			left.boundsMin = glm::min(left.boundsMin, bins[i].boundsMin);
+			left.boundsMax = glm::max(left.boundsMax, bins[i].boundsMax);
+			leftCount[i] = left.count;
+			leftArea[i] = left.count > 0 ? surfaceArea(left.boundsMin, left.boundsMax) : 0.0f;
+
+			int j = BinCount - 1 - i;
+			right.count += bins[j].count;
+			right.boundsMin = glm::min(right.boundsMin, bins[j].boundsMin);
+			right.boundsMax = glm::max(right.boundsMax, bins[j].boundsMax);
+			rightCount[j - 1] = right.count;
+			rightArea[j - 1] = right.count > 0 ? surfaceArea(right.boundsMin, right.boundsMax) : 0.0f;
+		}
+
+		for (int i = 0; i < BinCount - 1; i++)
+		{
+			float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i + 1;
+			}
+		}
+	}
+
+	// keep the leaf if no split is cheaper than testing every item in it
+	if (bestAxis < 0 || bestCost >= node.count * surfaceArea(node.boundsMin, node.boundsMax))
+	{
+		makeLeaf();
+		return;
+	}
+
+	float scale = BinCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+
+	auto middle = std::partition(m_order.begin() + node.first, m_order.begin() + node.first + node.count, [&](unsigned int index)
+	{
+		const Item& item = m_items[index];
+		float centroid = (item.boundsMin[bestAxis] + item.boundsMax[bestAxis]) * 0.5f;
+
+		return std::min((int)((centroid - centroidMin[bestAxis]) * scale), BinCount - 1) < bestSplit;
+	});
+
+	unsigned int leftCount = (unsigned int)(middle - (m_order.begin() + node.first));
+	if (leftCount == 0 || leftCount == node.count)
+	{
+		makeLeaf();
+		return;
+	}
+
+	unsigned int childIndex = (unsigned int)m_nodes.size();
+
+	Node left;
+	left.first = node.first;
+	left.count = leftCount;
+	fitNode(left);
+
+	Node right;
+	right.first = node.first + leftCount;
+	right.count = node.count - leftCount;
+	fitNode(right);
+
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+	m_parents.push_back(nodeIndex);
+	m_parents.push_back(nodeIndex);
+
+	m_nodes[nodeIndex].first = childIndex;
+	m_nodes[nodeIndex].count = 0;
+
+	subdivide(childIndex, depth + 1);
+	subdivide(childIndex + 1, depth + 1);
+}
+
+void SceneBVH::fitNode(Node& node) const
+{
+	if (node.count == 0)
+	{
+		const Node& left = m_nodes[node.first];
+		const Node& right = m_nodes[node.first + 1];
+
+		node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+		return;
+	}
+
+	node.boundsMin = glm::vec3(FLT_MAX);
+	node.boundsMax = glm::vec3(-FLT_MAX);
+
+	for (unsigned int i = node.first; i < node.first + node.count; i++)
+	{
+		const Item& item = m_items[m_order[i]];
+
+		node.boundsMin = glm::min(node.boundsMin, item.boundsMin);
+		node.boundsMax = glm::max(node.boundsMax, item.boundsMax);
+	}
+}
+
+float SceneBVH::getCost() const
+{
+	float cost = 0.0f;
+
+	for (const Node& node : m_nodes)
+		cost += surfaceArea(node.boundsMin, node.boundsMax);
+
+	return cost;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <glm\glm.hpp>
+#include <cfloat>
+#include <vector>
+#include "Frustum.h"
+
+class OBJMesh;
+
+// a chunk of one of the scene's mesh instances
+struct SceneItem
+{
+	unsigned int instance;
+	unsigned int chunk;
+};
+
+// nearest triangle a ray hit
+struct SceneRayHit
+{
+	unsigned int instance = 0;
+	unsigned int chunk = 0;
+	float distance = FLT_MAX; // along the ray, in lengths of its direction
+	glm::vec3 position = glm::vec3(0.0f);
+};
+
+// bounding volume hierarchy over the chunks of every mesh instance in the scene
+// built top down with a binned surface area heuristic into one flat node array (siblings side by side, 32 byte nodes),
+// moving an instance only refits the boxes on the way from its leaves to the root until the tree is worth rebuilding
+class SceneBVH
+{
+public:
+
+	// add a mesh drawn with a transform, its chunks go in the tree at the next build / update
+	unsigned int addInstance(const OBJMesh* mesh, const glm::mat4& transform);
+
+	// move an instance, its boxes are refitted at the next update
+	void setTransform(unsigned int instance, const glm::mat4& transform);
+
+	void clear();
+
+	// build the tree from scratch
+	void build();
+
+	// build if instances were added, otherwise refit the ones that moved
+	void update();
+
+	// chunks whose boxes touch a frustum
+	void queryFrustum(const Frustum& frustum, std::vector<SceneItem>& items) const;
+
+	// chunks whose boxes touch a sphere
+	void querySphere(const glm::vec3& center, float radius, std::vector<SceneItem>& items) const;
+
+	// nearest triangle along a ray (tested 4 at a time), false if nothing is hit before maxDistance
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, SceneRayHit& hit, float maxDistance = FLT_MAX) const;
+
+	const OBJMesh* getMesh(unsigned int instance) const { return m_instances[instance].mesh; }
+	const glm::mat4& getTransform(unsigned int instance) const { return m_instances[instance].transform; }
+
+	size_t getInstanceCount() const { return m_instances.size(); }
+	size_t getItemCount() const { return m_items.size(); }
+	size_t getNodeCount() const { return m_nodes.size(); }
+
+private:
+
+	// a leaf has count > 0 and holds m_order[first, first + count)
+	// an inner node has count 0 and its children at first and first + 1
+	struct Node
+	{
+		glm::vec3 boundsMin;
+		unsigned int first;
+		glm::vec3 boundsMax;
+		unsigned int count;
+	};
+
+	struct Instance
+	{
+		const OBJMesh* mesh;
+		glm::mat4 transform;
+		glm::mat4 inverse; // rays are tested against the triangles in object space
+		unsigned int firstItem;
+		unsigned int itemCount;
+		bool moved;
+	};
+
+	struct Item
+	{
+		unsigned int instance;
+		unsigned int chunk;
+		glm::vec3 boundsMin; // world space
+		glm::vec3 boundsMax;
+	};
+
+	void updateItemBounds(Item& item) const;
+
+	// split a node's items in two at the cheapest of the binned planes, or leave it a leaf
+	void subdivide(unsigned int nodeIndex, unsigned int depth);
+
+	// fit a leaf to its items / an inner node to its children
+	void fitNode(Node& node) const;
+
+	// sum of every node's surface area, what a ray pays for the tree's shape
+	float getCost() const;
+
+	std::vector<Instance> m_instances;
+	std::vector<Item> m_items;
+	std::vector<unsigned int> m_order; // item indices in leaf order
+	std::vector<Node> m_nodes;
+	std::vector<unsigned int> m_parents; // parent of each node, for refitting
+	std::vector<unsigned int> m_itemLeaves; // leaf holding each item
+
+	bool m_needsBuild = false;
+	float m_builtCost = 0.0f;
+};
\ No newline at end of file
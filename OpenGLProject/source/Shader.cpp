@@ -1,165 +1,402 @@
 #include "Shader.h"
+#include "RenderStats.h"
+#include "GLState.h"
+#include "GLObjectTracker.h"
+#include "GLExtensions.h"
+#include "ShaderCache.h"
+#include <algorithm>
 #include <iostream>
 
+// let the driver compile on threads of its own (KHR / ARB_parallel_shader_compile), compiles and links
+// then return straight away and only block once their status is asked for (see Shader::finishLinking)
+static void enableParallelCompile()
+{
+	static bool enabled = false;
+	if (enabled)
+	{
+		return;
+	}
+	enabled = true;
+
+	typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+	const char* name = nullptr;
+	if (GLExtensions::has("GL_KHR_parallel_shader_compile"))
+		name = "glMaxShaderCompilerThreadsKHR";
+	else if (GLExtensions::has("GL_ARB_parallel_shader_compile"))
+		name = "glMaxShaderCompilerThreadsARB";
+
+	PFNGLMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads =
+		name != nullptr ? (PFNGLMAXSHADERCOMPILERTHREADSPROC)GLExtensions::getProcAddress(name) : nullptr;
+
+	// as many threads as the driver wants
+	if (maxShaderCompilerThreads != nullptr)
+	{
+		maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+}
+
 // constructor generates the shader on the fly
+// the program comes from the shader cache when it has been built before, otherwise the stages are
+// compiled and linked without waiting, bind (or finishLinking) picks up the result
 Shader::Shader(const char* vertexPath,
 	const char* fragmentPath,
 	const char* geometryPath,
 	const char* tessCPath,
-	const char* tessEPath)
-{
-	// create ifstreams and strings for reading in shaders from files
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::string geometryCode;
-	std::string tessCCode;
-	std::string tessECode;
-
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-	std::ifstream gShaderFile;
-	std::ifstream tessCFile;
-	std::ifstream tessEFile;
-
-	// enable exceptions on ifstreams
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	tessCFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	tessEFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-	try
-	{
-		std::stringstream vShaderStream, fShaderStream, gShaderStream, tessCShaderStream, tessEShaderStream;
-
-		// open files
-		if (vertexPath)
+	const char* tessEPath,
+	const std::string& defines)
+{
+	const StageInfo stages[] =
+	{
+		{ vertexPath, GL_VERTEX_SHADER, "VERTEX" },
+		{ fragmentPath, GL_FRAGMENT_SHADER, "FRAGMENT" },
+		{ geometryPath, GL_GEOMETRY_SHADER, "GEOMETRY" },
+		{ tessCPath, GL_TESS_CONTROL_SHADER, "TESSELLATION_CONTROL" },
+		{ tessEPath, GL_TESS_EVALUATION_SHADER, "TESSELLATION_EVALUATION" }
+	};
+
+	create(stages, sizeof(stages) / sizeof(stages[0]), defines);
+}
+
+Shader Shader::createCompute(const char* computePath, const std::string& defines)
+{
+	const StageInfo stage = { computePath, GL_COMPUTE_SHADER, "COMPUTE" };
+
+	Shader shader;
+	shader.create(&stage, 1, defines);
+
+	return shader;
+}
+
+void Shader::create(const StageInfo* stages, size_t stageCount, const std::string& defines)
+{
+	// read every stage with its includes and defines, the program is keyed by exactly what the driver would see
+	std::vector<std::string> sources(stageCount);
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (stages[i].path == nullptr)
 		{
-			vShaderFile.open(vertexPath);
-			vShaderStream << vShaderFile.rdbuf();
-			vShaderFile.close();
-			vertexCode = vShaderStream.str();
+			continue;
 		}
-		if (fragmentPath)
+
+		// a stage that can't be read would only fail to compile, so leave the program empty
+		std::unordered_set<std::string> included;
+		if (!readSource(stages[i].path, sources[i], included))
 		{
-			fShaderFile.open(fragmentPath);
-			fShaderStream << fShaderFile.rdbuf();
-			fShaderFile.close();
-			fragmentCode = fShaderStream.str();
+			std::cout << "Shader " << stages[i].path << " not built" << std::endl;
+			return;
 		}
-		if (geometryPath)
+
+		// every stage sees the same defines (e.g. a material permutation's feature flags)
+		if (!defines.empty())
 		{
-			gShaderFile.open(geometryPath);
-			gShaderStream << gShaderFile.rdbuf();
-			gShaderFile.close();
-			geometryCode = gShaderStream.str();
+			insertDefines(sources[i], defines);
 		}
-		if (tessCPath)
+	}
+
+	enableParallelCompile();
+
+	ID = glCreateProgram();
+	GL_TRACK_CREATED(GLObjectType::Program, ID, "Shader");
+
+	m_programHash = ShaderCache::hashProgram(sources);
+
+	if (ShaderCache::load(m_programHash, ID))
+	{
+		// find every active uniform now so nothing has to be queried by name later
+		buildUniformTable();
+		return;
+	}
+
+	ShaderCache::addCompiled();
+
+	// compile shaders
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		if (stages[i].path == nullptr)
 		{
-			tessCFile.open(tessCPath);
-			tessCShaderStream << tessCFile.rdbuf();
-			tessCFile.close();
-			tessCCode = tessCShaderStream.str();
+			continue;
 		}
-		if (tessEPath)
+
+		const char* code = sources[i].c_str();
+
+		PendingStage stage;
+		stage.shader = glCreateShader(stages[i].type);
+		stage.name = stages[i].name;
+
+		glShaderSource(stage.shader, 1, &code, NULL);
+		glCompileShader(stage.shader);
+		glAttachShader(ID, stage.shader);
+
+		m_pendingStages.push_back(stage);
+	}
+
+	// the linked binary is written to the shader cache once linking is done
+	glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(ID);
+}
+
+// wait for the program to link, report any errors and write it to the shader cache
+void Shader::finishLinking() const
+{
+	if (m_pendingStages.empty())
+	{
+		return;
+	}
+
+	// the first status query is where a parallel compile is waited on
+	for (const PendingStage& stage : m_pendingStages)
+	{
+		checkCompileErrors(stage.shader, stage.name);
+
+		// delete the shaders as they're linked into our program now and no longer necessery
+		glDetachShader(ID, stage.shader);
+		glDeleteShader(stage.shader);
+	}
+
+	m_pendingStages.clear();
+
+	checkCompileErrors(ID, "PROGRAM");
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+	if (linked == GL_TRUE)
+	{
+		ShaderCache::save(m_programHash, ID);
+	}
+
+	// find every active uniform now so nothing has to be queried by name later
+	buildUniformTable();
+}
+
+// read a shader file, pasting in the files it #includes (paths are relative to the including file)
+// each file is only pasted once, so shared blocks can include what they need without guards
+bool Shader::readSource(const std::string& path, std::string& code, std::unordered_set<std::string>& included)
+{
+	if (!included.insert(path).second)
+	{
+		return true;
+	}
+
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cout << "Error reading shader file " << path << std::endl;
+		return false;
+	}
+
+	std::string folder = path.substr(0, path.find_last_of("\\/") + 1);
+
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			code += line;
+			code += '\n';
+			continue;
+		}
+
+		size_t open = line.find('"', start);
+		size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+		if (close == std::string::npos)
 		{
-			tessEFile.open(tessEPath);
-			tessEShaderStream << tessEFile.rdbuf();
-			tessEFile.close();
-			tessECode = tessEShaderStream.str();
+			std::cout << "Bad #include in " << path << " line " << lineNumber << std::endl;
+			return false;
 		}
+
+		// keep line numbers in errors pointing at the right line of each file
+		code += "#line 1\n";
+		if (!readSource(folder + line.substr(open + 1, close - open - 1), code, included))
+		{
+			return false;
+		}
+		code += "\n#line " + std::to_string(lineNumber + 1) + "\n";
 	}
-	catch (std::ifstream::failure e)
+
+	return true;
+}
+
+Shader::~Shader()
+{
+	for (const PendingStage& stage : m_pendingStages)
 	{
-		std::cout << "Error reading shader file" << std::endl;
+		glDeleteShader(stage.shader);
 	}
 
-	// compile shaders
-	unsigned int vertex, fragment, geometry, tessC, tessE;
-	ID = glCreateProgram();
+	if (ID != 0)
+	{
+		GL_TRACK_DELETED(GLObjectType::Program, ID);
+		GLState::getInstance().programDeleted(ID);
+		glDeleteProgram(ID);
+	}
+}
 
-	if (vertexPath)
+// put #define lines straight after the #version line, with a #line so errors still point at the file
+void Shader::insertDefines(std::string& code, const std::string& defines)
+{
+	size_t version = code.find("#version");
+	if (version == std::string::npos)
 	{
-		const char* vShaderCode = vertexCode.c_str();
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
-		glAttachShader(ID, vertex);
+		return;
 	}
-	if (fragmentPath)
+
+	size_t lineEnd = code.find('\n', version);
+	if (lineEnd == std::string::npos)
 	{
-		const char* fShaderCode = fragmentCode.c_str();
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(fragment, "FRAGMENT");
-		glAttachShader(ID, fragment);
+		return;
 	}
-	if (geometryPath)
+
+	// the line after #version, numbered from 1
+	int nextLine = (int)std::count(code.begin(), code.begin() + lineEnd, '\n') + 2;
+
+	code.insert(lineEnd + 1, defines + "#line " + std::to_string(nextLine) + "\n");
+}
+
+// take ownership of another shader's program
+Shader::Shader(Shader&& other) noexcept : ID(other.ID), m_uniforms(std::move(other.m_uniforms)),
+	m_pendingStages(std::move(other.m_pendingStages)), m_programHash(other.m_programHash)
+{
+	other.ID = 0;
+	other.m_pendingStages.clear();
+}
+
+// release this program and take ownership of another shader's program
+Shader& Shader::operator = (Shader&& other) noexcept
+{
+	if (this != &other)
 	{
-		const char* gShaderCode = geometryCode.c_str();
-		geometry = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(geometry, 1, &gShaderCode, NULL);
-		glCompileShader(geometry);
-		checkCompileErrors(geometry, "GEOMETRY");
-		glAttachShader(ID, geometry);
+		if (ID != 0)
+		{
+			GL_TRACK_DELETED(GLObjectType::Program, ID);
+			GLState::getInstance().programDeleted(ID);
+			glDeleteProgram(ID);
+		}
+
+		for (const PendingStage& stage : m_pendingStages)
+		{
+			glDeleteShader(stage.shader);
+		}
+
+		ID = other.ID;
+		m_uniforms = std::move(other.m_uniforms);
+		m_pendingStages = std::move(other.m_pendingStages);
+		m_programHash = other.m_programHash;
+		other.ID = 0;
+		other.m_pendingStages.clear();
 	}
-	if (tessCPath)
+
+	return *this;
+}
+
+// activate this Shader, the first bind waits for it to finish linking
+void Shader::bind()
+{
+	finishLinking();
+
+	GLState::getInstance().useProgram(ID);
+}
+
+// set a boolean through a resolved handle
+void Shader::set(UniformHandle<bool> uniform, bool value) const
+{
+	if (uniform.isValid())
 	{
-		const char* tessCShaderCode = tessCCode.c_str();
-		tessC = glCreateShader(GL_TESS_CONTROL_SHADER);
-		glShaderSource(tessC, 1, &tessCShaderCode, NULL);
-		glCompileShader(tessC);
-		checkCompileErrors(tessC, "TESSELLATION_CONTROL");
-		glAttachShader(ID, tessC);
+		glUniform1i(uniform.location, (int)value);
 	}
-	if (tessEPath)
+}
+
+// set an int through a resolved handle
+void Shader::set(UniformHandle<int> uniform, int value) const
+{
+	if (uniform.isValid())
 	{
-		const char* tessEShaderCode = tessECode.c_str();
-		tessE = glCreateShader(GL_TESS_EVALUATION_SHADER);
-		glShaderSource(tessE, 1, &tessEShaderCode, NULL);
-		glCompileShader(tessE);
-		checkCompileErrors(tessE, "TESSELLATION_EVALUATION");
-		glAttachShader(ID, tessE);
+		glUniform1i(uniform.location, value);
 	}
+}
 
-	glLinkProgram(ID);
-	checkCompileErrors(ID, "PROGRAM");
+// set a float through a resolved handle
+void Shader::set(UniformHandle<float> uniform, float value) const
+{
+	if (uniform.isValid())
+	{
+		glUniform1f(uniform.location, value);
+	}
+}
 
-	// delete the shaders as they're linked into our program now and no longer necessery
-	if (vertexPath)
+// set a vector2 through a resolved handle
+void Shader::set(UniformHandle<glm::vec2> uniform, const glm::vec2& value) const
+{
+	if (uniform.isValid())
 	{
-		glDeleteShader(vertex);
+		glUniform2fv(uniform.location, 1, &value[0]);
 	}
-	if (fragmentPath)
+}
+
+// set an integer vector2 through a resolved handle
+void Shader::set(UniformHandle<glm::ivec2> uniform, const glm::ivec2& value) const
+{
+	if (uniform.isValid())
 	{
-		glDeleteShader(fragment);
+		glUniform2iv(uniform.location, 1, &value[0]);
 	}
-	if (geometryPath)
+}
+
+// set a vector3 through a resolved handle
+void Shader::set(UniformHandle<glm::vec3> uniform, const glm::vec3& value) const
+{
+	if (uniform.isValid())
 	{
-		glDeleteShader(geometry);
+		glUniform3fv(uniform.location, 1, &value[0]);
 	}
-	if (tessCPath)
+}
+
+// set a vector4 through a resolved handle
+void Shader::set(UniformHandle<glm::vec4> uniform, const glm::vec4& value) const
+{
+	if (uniform.isValid())
 	{
-		glDeleteShader(tessC);
+		glUniform4fv(uniform.location, 1, &value[0]);
 	}
-	if (tessEPath)
+}
+
+// set a matrix2 through a resolved handle
+void Shader::set(UniformHandle<glm::mat2> uniform, const glm::mat2& mat) const
+{
+	if (uniform.isValid())
 	{
-		glDeleteShader(tessE);
+		glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
 	}
 }
 
-// activate this Shader
-void Shader::bind()
+// set a matrix3 through a resolved handle
+void Shader::set(UniformHandle<glm::mat3> uniform, const glm::mat3& mat) const
+{
+	if (uniform.isValid())
+	{
+		glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+	}
+}
+
+// set a matrix4 through a resolved handle
+void Shader::set(UniformHandle<glm::mat4> uniform, const glm::mat4& mat) const
 {
-	glUseProgram(ID);
+	if (uniform.isValid())
+	{
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+	}
 }
 
 // set a boolean in the shader
 const void Shader::setBool(const std::string& name, bool value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -170,7 +407,7 @@ const void Shader::setBool(const std::string& name, bool value)
 // set an int in the shader
 const void Shader::setInt(const std::string& name, int value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -181,7 +418,7 @@ const void Shader::setInt(const std::string& name, int value)
 // set a float value in the shader
 const void Shader::setFloat(const std::string& name, float value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -192,7 +429,7 @@ const void Shader::setFloat(const std::string& name, float value)
 // set a vector 2 in the shader
 const void Shader::setVec2(const std::string& name, const glm::vec2& value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -203,7 +440,7 @@ const void Shader::setVec2(const std::string& name, const glm::vec2& value)
 // set a vector2 in the shader
 const void Shader::setVec2(const std::string& name, float x, float y)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -214,7 +451,7 @@ const void Shader::setVec2(const std::string& name, float x, float y)
 // set a vector3 in the shader
 const void Shader::setVec3(const std::string& name, const glm::vec3& value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -225,7 +462,7 @@ const void Shader::setVec3(const std::string& name, const glm::vec3& value)
 // set a vector4 in the shader
 const void Shader::setVec3(const std::string& name, float x, float y, float z)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -236,7 +473,7 @@ const void Shader::setVec3(const std::string& name, float x, float y, float z)
 // set a vector4 in the shader
 const void Shader::setVec4(const std::string& name, const glm::vec4& value)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -247,7 +484,7 @@ const void Shader::setVec4(const std::string& name, const glm::vec4& value)
 // set a vector4 in the shader
 const void Shader::setVec4(const std::string& name, float x, float y, float z, float w)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -258,7 +495,7 @@ const void Shader::setVec4(const std::string& name, float x, float y, float z, f
 // set a matrix2 in the shader
 const void Shader::setMat2(const std::string& name, const glm::mat2& mat)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -269,7 +506,7 @@ const void Shader::setMat2(const std::string& name, const glm::mat2& mat)
 // set a matrix3 in the shader
 const void Shader::setMat3(const std::string& name, const glm::mat3& mat)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -280,7 +517,7 @@ const void Shader::setMat3(const std::string& name, const glm::mat3& mat)
 // set a matrix4 in the shader
 const void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 {
-	GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+	GLint uniformLocation = findNamedUniform(name);
 
 	if (uniformLocation >= 0)
 	{
@@ -289,7 +526,7 @@ const void Shader::setMat4(const std::string& name, const glm::mat4& mat)
 }
 
 // outputs any shader compile errors to the console
-void Shader::checkCompileErrors(GLuint shader, std::string type)
+void Shader::checkCompileErrors(GLuint shader, std::string type) const
 {
 	GLint success;
 	GLchar infoLog[1024];
@@ -313,3 +550,102 @@ void Shader::checkCompileErrors(GLuint shader, std::string type)
 		}
 	}
 }
+
+// query every active uniform after linking and store its location in a table sorted by name hash
+void Shader::buildUniformTable() const
+{
+	m_uniforms.clear();
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLint size = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+		glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), length);
+		GLint location = glGetUniformLocation(ID, name.c_str());
+
+		// uniforms inside blocks don't have a location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		addUniform(name, location, type);
+
+		// arrays are reported as "name[0]", also store the bare name and every other element
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			std::string baseName = name.substr(0, name.size() - 3);
+			addUniform(baseName, location, type);
+
+			for (GLint element = 1; element < size; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				addUniform(elementName, glGetUniformLocation(ID, elementName.c_str()), type);
+			}
+		}
+	}
+
+	std::sort(m_uniforms.begin(), m_uniforms.end(), [](const UniformEntry& a, const UniformEntry& b)
+	{
+		return a.hash < b.hash;
+	});
+
+	// two different names with the same hash would silently alias each other
+	for (size_t i = 1; i < m_uniforms.size(); i++)
+	{
+		if (m_uniforms[i].hash == m_uniforms[i - 1].hash && m_uniforms[i].location != m_uniforms[i - 1].location)
+		{
+			std::cout << "Uniform name hash collision in program " << ID << std::endl;
+		}
+	}
+}
+
+// add a single entry to the uniform table
+void Shader::addUniform(const std::string& name, GLint location, GLenum type) const
+{
+	UniformEntry entry;
+	entry.hash = UniformID(name.c_str()).hash;
+	entry.location = location;
+	entry.type = type;
+
+	m_uniforms.push_back(entry);
+}
+
+// binary search the uniform table for a hashed name
+const Shader::UniformEntry* Shader::findUniform(UniformID id) const
+{
+	// the table is only built once the program has linked
+	finishLinking();
+
+	auto iter = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), id.hash, [](const UniformEntry& entry, unsigned int hash)
+	{
+		return entry.hash < hash;
+	});
+
+	if (iter != m_uniforms.end() && iter->hash == id.hash)
+	{
+		return &(*iter);
+	}
+
+	return nullptr;
+}
+
+// look up a uniform from a string name, counted so per frame code using names shows up in the stats
+GLint Shader::findNamedUniform(const std::string& name) const
+{
+	RenderStats::getInstance().current().uniformNameLookups++;
+
+	const UniformEntry* entry = findUniform(UniformID(name.c_str()));
+
+	return entry != nullptr ? entry->location : -1;
+}
@@ -5,25 +5,127 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <unordered_set>
+#include <vector>
 #include <fstream>
 #include <sstream>
 
+// hash of a uniform name (FNV-1a) so uniforms can be found without building strings
+// constexpr so names written in code are hashed at compile time
+struct UniformID
+{
+	unsigned int hash = 2166136261u;
+
+	constexpr UniformID() {}
+	constexpr explicit UniformID(const char* name) : hash(2166136261u)
+	{
+		while (*name != '\0')
+		{
+			hash ^= (unsigned char)*name++;
+			hash *= 16777619u;
+		}
+	}
+
+	// continue the hash with more characters (e.g. a struct member after an array index)
+	constexpr UniformID append(const char* text) const
+	{
+		UniformID result;
+		result.hash = hash;
+
+		while (*text != '\0')
+		{
+			result.hash ^= (unsigned char)*text++;
+			result.hash *= 16777619u;
+		}
+
+		return result;
+	}
+
+	// continue the hash with the decimal digits of an array index
+	constexpr UniformID append(int index) const
+	{
+		char digits[12] = {};
+		int count = 0;
+
+		do
+		{
+			digits[count++] = (char)('0' + index % 10);
+			index /= 10;
+		} while (index > 0);
+
+		UniformID result;
+		result.hash = hash;
+
+		while (count > 0)
+		{
+			result.hash ^= (unsigned char)digits[--count];
+			result.hash *= 16777619u;
+		}
+
+		return result;
+	}
+};
+
+// resolved uniform location, typed so it can only be set with the matching value type
+template<typename T>
+struct UniformHandle
+{
+	GLint location = -1;
+
+	bool isValid() const { return location >= 0; }
+};
+
+// shader program, owns its GL program so it can be moved but not copied
 class Shader
 {
 public:
-	unsigned int ID;
+	unsigned int ID = 0;
 
 	Shader() {};
+	~Shader();
+
+	Shader(Shader&& other) noexcept;
+	Shader& operator = (Shader&& other) noexcept;
+
+	Shader(const Shader&) = delete;
+	Shader& operator = (const Shader&) = delete;
 
-	
 	Shader(const char* vertexPath,
 		const char* fragmentPath = nullptr,
 		const char* geometryPath = nullptr,
 		const char* tessCPath = nullptr,
-		const char* tessEPath = nullptr);
+		const char* tessEPath = nullptr,
+		const std::string& defines = "");
+
+	// program with a single compute stage
+	static Shader createCompute(const char* computePath, const std::string& defines = "");
 
 	void bind();
 
+	// wait for the program to link, report any errors and write it to the shader cache
+	// (bind and the first uniform lookup do this, call it sooner to wait for a batch of shaders on purpose)
+	void finishLinking() const;
+
+	// resolve a uniform once (at setup) so it can be set without any name lookup
+	template<typename T>
+	UniformHandle<T> getUniform(UniformID id) const;
+
+	void set(UniformHandle<bool> uniform, bool value) const;
+	void set(UniformHandle<int> uniform, int value) const;
+	void set(UniformHandle<float> uniform, float value) const;
+	void set(UniformHandle<glm::vec2> uniform, const glm::vec2& value) const;
+	void set(UniformHandle<glm::ivec2> uniform, const glm::ivec2& value) const;
+	void set(UniformHandle<glm::vec3> uniform, const glm::vec3& value) const;
+	void set(UniformHandle<glm::vec4> uniform, const glm::vec4& value) const;
+	void set(UniformHandle<glm::mat2> uniform, const glm::mat2& mat) const;
+	void set(UniformHandle<glm::mat3> uniform, const glm::mat3& mat) const;
+	void set(UniformHandle<glm::mat4> uniform, const glm::mat4& mat) const;
+
+	// set a uniform by hashed name (searches the location table, no GL query)
+	template<typename T>
+	void set(UniformID id, const T& value) const { set(getUniform<T>(id), value); }
+
+	// set a uniform by name (counted as a name lookup, avoid in per frame code)
 	const void setBool(const std::string& name, bool value);
 	const void setInt(const std::string& name, int value);
 	const void setFloat(const std::string& name, float value);
@@ -39,6 +141,76 @@ public:
 
 private:
 
-	void checkCompileErrors(GLuint shader, std::string type);
+	// entry in the flat location table, sorted by hash
+	struct UniformEntry
+	{
+		unsigned int hash;
+		GLint location;
+		GLenum type;
+	};
+
+	struct StageInfo
+	{
+		const char* path;
+		GLenum type;
+		const char* name;
+	};
+
+	// a compiled stage waiting for the program to finish linking
+	struct PendingStage
+	{
+		GLuint shader;
+		const char* name;
+	};
+
+	// read, compile and link the stages (paths left null are skipped)
+	void create(const StageInfo* stages, size_t stageCount, const std::string& defines);
+
+	void checkCompileErrors(GLuint shader, std::string type) const;
+
+	// read a shader file, pasting in the files it #includes (paths are relative to the including file)
+	static bool readSource(const std::string& path, std::string& code, std::unordered_set<std::string>& included);
+
+	// put #define lines straight after the #version line, with a #line so errors still point at the file
+	static void insertDefines(std::string& code, const std::string& defines);
+
+	void buildUniformTable() const;
+	void addUniform(const std::string& name, GLint location, GLenum type) const;
+	const UniformEntry* findUniform(UniformID id) const;
+	GLint findNamedUniform(const std::string& name) const;
+
+	static bool typeMatches(GLenum type, const bool*) { return type == GL_BOOL; }
+	static bool typeMatches(GLenum type, const int*) { return type == GL_INT || type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE || type == GL_SAMPLER_2D_ARRAY; }
+	static bool typeMatches(GLenum type, const float*) { return type == GL_FLOAT; }
+	static bool typeMatches(GLenum type, const glm::vec2*) { return type == GL_FLOAT_VEC2; }
+	static bool typeMatches(GLenum type, const glm::ivec2*) { return type == GL_INT_VEC2; }
+	static bool typeMatches(GLenum type, const glm::vec3*) { return type == GL_FLOAT_VEC3; }
+	static bool typeMatches(GLenum type, const glm::vec4*) { return type == GL_FLOAT_VEC4; }
+	static bool typeMatches(GLenum type, const glm::mat2*) { return type == GL_FLOAT_MAT2; }
+	static bool typeMatches(GLenum type, const glm::mat3*) { return type == GL_FLOAT_MAT3; }
+	static bool typeMatches(GLenum type, const glm::mat4*) { return type == GL_FLOAT_MAT4; }
+
+	// mutable so a lookup on a const shader can still finish linking and build the table first
+	mutable std::vector<UniformEntry> m_uniforms;
+
+	// empty once linked
+	mutable std::vector<PendingStage> m_pendingStages;
+	unsigned long long m_programHash = 0;
 };
+
+template<typename T>
+UniformHandle<T> Shader::getUniform(UniformID id) const
+{
+	UniformHandle<T> handle;
+
+	const UniformEntry* entry = findUniform(id);
+
+	// leave the handle invalid if the uniform doesn't exist or has a different type
+	if (entry != nullptr && typeMatches(entry->type, (const T*)nullptr))
+	{
+		handle.location = entry->location;
+	}
+
+	return handle;
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "ShaderCache.h"
+#include <glad\glad.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <experimental\filesystem>
+#include <fstream>
+
+namespace fs = std::experimental::filesystem;
+
+// "OSC1" read as a little endian int
+static const uint32_t CacheMagic = 0x3143534F;
+
+// bump whenever the layout below changes
+static const uint32_t CacheVersion = 1;
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t programHash;
+	uint32_t binaryFormat;
+	uint32_t binarySize;
+};
+
+static ShaderCacheStats stats;
+
+static void hashBytes(uint64_t& hash, const unsigned char* bytes, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+static void hashString(uint64_t& hash, const char* text)
+{
+	if (text != nullptr)
+	{
+		hashBytes(hash, (const unsigned char*)text, strlen(text));
+	}
+
+	// keeps "ab" + "c" apart from "a" + "bc"
+	unsigned char separator = 0;
+	hashBytes(hash, &separator, 1);
+}
+
+// folder of the binaries, made the first time one is written
+static std::string getCacheFolder()
+{
+	return fs::current_path().string() + "\\shadercache";
+}
+
+static std::string getCachePath(unsigned long long programHash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", programHash);
+	return getCacheFolder() + "\\" + name;
+}
+
+// 64 bit FNV-1a hash of the preprocessed stage sources and the GL vendor / renderer / version strings
+unsigned long long ShaderCache::hashProgram(const std::vector<std::string>& sources)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	// a binary is only valid for the driver that made it
+	hashString(hash, (const char*)glGetString(GL_VENDOR));
+	hashString(hash, (const char*)glGetString(GL_RENDERER));
+	hashString(hash, (const char*)glGetString(GL_VERSION));
+
+	for (const std::string& source : sources)
+	{
+		hashString(hash, source.c_str());
+	}
+
+	return hash;
+}
+
+// binaries can't be used when the driver supports no binary formats
+bool ShaderCache::isSupported()
+{
+	static const bool supported = []()
+	{
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}();
+
+	return supported;
+}
+
+// give a program the cached binary, fails if there is none, it is corrupt or the driver won't link it
+bool ShaderCache::load(unsigned long long programHash, unsigned int program)
+{
+	if (!isSupported())
+	{
+		return false;
+	}
+
+	std::ifstream file(getCachePath(programHash), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	CacheHeader header = {};
+	if (!file.read((char*)&header, sizeof(header)) ||
+		header.magic != CacheMagic || header.version != CacheVersion || header.programHash != programHash)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(header.binarySize);
+	if (!file.read(binary.data(), binary.size()))
+	{
+		return false;
+	}
+
+	glProgramBinary(program, (GLenum)header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+	// a driver can refuse binaries of its own (e.g. after a settings change), the program is then rebuilt
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		stats.rejected++;
+		return false;
+	}
+
+	stats.loaded++;
+	return true;
+}
+
+// write a linked program's binary
+bool ShaderCache::save(unsigned long long programHash, unsigned int program)
+{
+	if (!isSupported())
+	{
+		return false;
+	}
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(size);
+	GLenum format = 0;
+	glGetProgramBinary(program, size, nullptr, &format, binary.data());
+
+	std::error_code error;
+	fs::create_directories(getCacheFolder(), error);
+
+	std::ofstream file(getCachePath(programHash), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	CacheHeader header = {};
+	header.magic = CacheMagic;
+	header.version = CacheVersion;
+	header.programHash = programHash;
+	header.binaryFormat = format;
+	header.binarySize = (uint32_t)binary.size();
+
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), binary.size());
+
+	return (bool)file;
+}
+
+// count a program that had to be compiled from source
+void ShaderCache::addCompiled()
+{
+	stats.compiled++;
+}
+
+ShaderCacheStats ShaderCache::getStats()
+{
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// counters of the shader cache since startup
+struct ShaderCacheStats
+{
+	unsigned int loaded = 0;	// programs created from a cached binary
+	unsigned int compiled = 0;	// programs compiled from source (missing, stale or rejected binaries)
+	unsigned int rejected = 0;	// cached binaries the driver refused, they are rebuilt and written again
+};
+
+// linked program binaries (glGetProgramBinary) kept in a folder next to the executable
+//
+// layout (version 1, little endian):
+//   header	magic, version, program hash, binary format, binary size
+//   binary	the driver's program binary
+//
+// a program is found by a hash of its preprocessed stages and the driver, so editing a shader or anything it
+// includes, or updating the driver, misses the cache and the program is compiled (and cached) again
+namespace ShaderCache
+{
+	// 64 bit FNV-1a hash of the preprocessed stage sources and the GL vendor / renderer / version strings
+	unsigned long long hashProgram(const std::vector<std::string>& sources);
+
+	// give a program the cached binary, fails if there is none, it is corrupt or the driver won't link it
+	bool load(unsigned long long programHash, unsigned int program);
+
+	// write a linked program's binary (it needs GL_PROGRAM_BINARY_RETRIEVABLE_HINT set before linking)
+	bool save(unsigned long long programHash, unsigned int program);
+
+	// binaries can't be used when the driver supports no binary formats
+	bool isSupported();
+
+	// count a program that had to be compiled from source
+	void addCompiled();
+
+	ShaderCacheStats getStats();
+}
\ No newline at end of file
@@ -1,9 +1,186 @@
 #include <glad\glad.h>
 #include "Texture.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "TextureMemoryTracker.h"
+#include "GLExtensions.h"
+#include "SamplerCache.h"
+#include "MaterialTextureTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb\stb_image.h>
 
+// s3tc is an extension rather than core, so glad doesn't have these
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// largest side of the copy TextureResidency::KeepLowMip keeps
+static const unsigned int LowMipSize = 64;
+
+static bool hasS3TC()
+{
+	return GLExtensions::has("GL_EXT_texture_compression_s3tc");
+}
+
+TextureImage::~TextureImage()
+{
+	if (pixels != nullptr)
+		stbi_image_free(pixels);
+}
+
+// take ownership of another image's pixels
+TextureImage::TextureImage(TextureImage&& other) noexcept :
+	filename(std::move(other.filename)),
+	width(other.width),
+	height(other.height),
+	components(other.components),
+	pixels(other.pixels),
+	compressed(std::move(other.compressed))
+{
+	other.pixels = nullptr;
+}
+
+// free this image's pixels and take ownership of another one's
+TextureImage& TextureImage::operator = (TextureImage&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (pixels != nullptr)
+			stbi_image_free(pixels);
+
+		filename = std::move(other.filename);
+		width = other.width;
+		height = other.height;
+		components = other.components;
+		pixels = other.pixels;
+		compressed = std::move(other.compressed);
+
+		other.pixels = nullptr;
+	}
+
+	return *this;
+}
+
+bool TextureImage::decode(const char* file, bool flipVertically)
+{
+	if (pixels != nullptr)
+	{
+		stbi_image_free(pixels);
+		pixels = nullptr;
+	}
+	compressed = CompressedImage();
+
+	// prefer the block compressed version, it has its mips already and is a fraction of the size
+	// unless it needs flipping and its blocks can't be, then the source image is used instead
+	if (DDS::read(DDS::getPath(file), compressed))
+	{
+		if (!flipVertically || DDS::flipVertically(compressed))
+		{
+			filename = file;
+			width = compressed.width;
+			height = compressed.height;
+			components = 0;
+
+			return true;
+		}
+
+		printf("Can't flip the BC7 texture for %s, loading the source image instead\n", file);
+		compressed = CompressedImage();
+	}
+
+	int x = 0, y = 0, comp = 0;
+	pixels = stbi_load(file, &x, &y, &comp, STBI_default);
+
+	if (pixels == nullptr)
+	{
+		return false;
+	}
+
+	filename = file;
+	width = (unsigned int)x;
+	height = (unsigned int)y;
+	components = (unsigned int)comp;
+
+	// swap rows top to bottom so the first row is the bottom of the image, as GL expects
+	if (flipVertically)
+	{
+		size_t rowSize = (size_t)width * components;
+		std::vector<unsigned char> row(rowSize);
+
+		for (unsigned int top = 0, bottom = height - 1; top < bottom; top++, bottom--)
+		{
+			unsigned char* topRow = pixels + top * rowSize;
+			unsigned char* bottomRow = pixels + bottom * rowSize;
+
+			memcpy(row.data(), topRow, rowSize);
+			memcpy(topRow, bottomRow, rowSize);
+			memcpy(bottomRow, row.data(), rowSize);
+		}
+	}
+
+	return true;
+}
+
+bool TextureImage::hasTransparency() const
+{
+	if (isCompressed())
+	{
+		return Texture::hasTransparency(compressed.format);
+	}
+
+	// alpha is the last component of grey alpha and rgba images
+	if (pixels == nullptr || (components != STBI_grey_alpha && components != STBI_rgb_alpha))
+	{
+		return false;
+	}
+
+	size_t pixelCount = (size_t)width * height;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		if (pixels[i * components + components - 1] < 255)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void halveImage(std::vector<unsigned char>& pixels, unsigned int& width, unsigned int& height, unsigned int components)
+{
+	unsigned int halfWidth = std::max(1u, width / 2);
+	unsigned int halfHeight = std::max(1u, height / 2);
+
+	for (unsigned int y = 0; y < halfHeight; y++)
+	{
+		unsigned int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (unsigned int x = 0; x < halfWidth; x++)
+		{
+			unsigned int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (unsigned int c = 0; c < components; c++)
+			{
+				unsigned int sum = pixels[((size_t)y0 * width + x0) * components + c] + pixels[((size_t)y0 * width + x1) * components + c] +
+					pixels[((size_t)y1 * width + x0) * components + c] + pixels[((size_t)y1 * width + x1) * components + c];
+
+				// written in place, never ahead of the texels still to be read
+				pixels[((size_t)y * halfWidth + x) * components + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+
+	width = halfWidth;
+	height = halfHeight;
+	pixels.resize((size_t)width * height * components);
+}
+
 Texture::Texture(const char* filename)
 {
 	load(filename);
@@ -16,129 +193,429 @@ Texture::Texture(unsigned int width, unsigned int height, GLenum format, unsigne
 
 Texture::~Texture()
 {
-	if (m_glHandle != 0)
-		glDeleteTextures(1, &m_glHandle);
-	if (m_loadedPixels != nullptr)
-		stbi_image_free(m_loadedPixels);
+	releaseGL();
+	TextureMemoryTracker::getInstance().remove(this);
 }
 
-bool Texture::load(const char* filename)
+// take ownership of another texture's GL texture and pixels
+Texture::Texture(Texture&& other) noexcept :
+	m_filename(std::move(other.m_filename)),
+	m_width(other.m_width),
+	m_height(other.m_height),
+	m_glHandle(other.m_glHandle),
+	m_format(other.m_format),
+	m_hasMipmaps(other.m_hasMipmaps),
+	m_transparent(other.m_transparent),
+	m_storageSize(other.m_storageSize),
+	m_sampler(other.m_sampler),
+	m_pixels(std::move(other.m_pixels)),
+	m_pixelWidth(other.m_pixelWidth),
+	m_pixelHeight(other.m_pixelHeight),
+	m_pixelComponents(other.m_pixelComponents)
 {
-	stbi_set_flip_vertically_on_load(true);
+	other.m_glHandle = 0;
+	other.m_pixels.clear();
 
-	// discard old texture if there is one
-	if (m_glHandle != 0)
+	TextureMemoryTracker::getInstance().remove(&other);
+	trackMemory();
+}
+
+// release this texture and take ownership of another one
+Texture& Texture::operator = (Texture&& other) noexcept
+{
+	if (this != &other)
 	{
-		glDeleteTextures(1, &m_glHandle);
-		m_glHandle = 0;
-		m_width = 0;
-		m_height = 0;
-		m_filename = "none";
+		releaseGL();
+
+		m_filename = std::move(other.m_filename);
+		m_width = other.m_width;
+		m_height = other.m_height;
+		m_glHandle = other.m_glHandle;
+		m_format = other.m_format;
+		m_hasMipmaps = other.m_hasMipmaps;
+		m_transparent = other.m_transparent;
+		m_storageSize = other.m_storageSize;
+		m_sampler = other.m_sampler;
+		m_pixels = std::move(other.m_pixels);
+		m_pixelWidth = other.m_pixelWidth;
+		m_pixelHeight = other.m_pixelHeight;
+		m_pixelComponents = other.m_pixelComponents;
+
+		other.m_glHandle = 0;
+		other.m_pixels.clear();
+
+		TextureMemoryTracker::getInstance().remove(&other);
+		trackMemory();
 	}
 
-	int x = 0, y = 0, comp = 0;
-	m_loadedPixels = stbi_load(filename, &x, &y, &comp, STBI_default);
+	return *this;
+}
+
+bool Texture::load(const char* filename, const TextureOptions& options)
+{
+	TextureImage image;
+	if (!image.decode(filename, options.flipVertically))
+	{
+		return false;
+	}
+
+	return upload(image, options);
+}
+
+bool Texture::upload(TextureImage& image, const TextureOptions& options)
+{
+	// discard old texture if there is one
+	releaseGL();
+	m_width = 0;
+	m_height = 0;
+	m_filename = "none";
+	m_hasMipmaps = false;
+	m_transparent = image.hasTransparency();
+	m_storageSize = 0;
+	m_pixels.clear();
+	m_pixels.shrink_to_fit();
 
-	if (m_loadedPixels)
+	bool uploaded = false;
+
+	if (image.isCompressed())
+	{
+		uploaded = uploadCompressed(image, options);
+	}
+	else if (image.pixels != nullptr)
 	{
+		int x = (int)image.width, y = (int)image.height, comp = (int)image.components;
+
 		glGenTextures(1, &m_glHandle);
-		glBindTexture(GL_TEXTURE_2D, m_glHandle);
+		GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Texture");
+		GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_glHandle);
 
+		GLenum format = GL_RGBA;
 		switch (comp)
 		{
 		case STBI_grey:
-			m_format = GL_ALPHA;
+			format = GL_RED;
 			break;
 		case STBI_grey_alpha:
-			m_format = GL_RG;
+			format = GL_RG;
 			break;
 		case STBI_rgb:
-			m_format = GL_RGB;
+			format = GL_RGB;
 			break;
 		case STBI_rgb_alpha:
-			m_format = GL_RGBA;
+			format = GL_RGBA;
 			break;
 		default:
 			break;
 		};
 
-		glTexImage2D(GL_TEXTURE_2D, 0, m_format, x, y, 0, m_format, GL_UNSIGNED_BYTE, m_loadedPixels);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// immutable storage for the whole chain, the driver never has to check it is complete
+		m_format = getSizedFormat(format);
+		glTexStorage2D(GL_TEXTURE_2D, getLevelCount(x, y), m_format, x, y);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, x, y, format, GL_UNSIGNED_BYTE, image.pixels);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// grey images read as grey in every channel rather than just red
+		if (format == GL_RED)
+		{
+			GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+			glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
 
 		glGenerateMipmap(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		m_sampler = SamplerCache::getInstance().get(SamplerDesc::get(options.filter, options.wrap, true));
+		m_hasMipmaps = true;
 		m_width = (unsigned int)x;
 		m_height = (unsigned int)y;
-		m_filename = filename;
-		return true;
+		m_filename = image.filename;
+
+		keepPixels(image, options.residency);
+		uploaded = true;
 	}
 
-	return false;
+	trackMemory();
+	return uploaded;
 }
 
-void Texture::create(unsigned int width, unsigned int height, GLenum format, unsigned char* pixels)
+// copy what the residency asks for out of the image, the image itself is freed by its owner
+void Texture::keepPixels(const TextureImage& image, TextureResidency residency)
+{
+	m_pixelWidth = 0;
+	m_pixelHeight = 0;
+	m_pixelComponents = 0;
+
+	if (residency == TextureResidency::DiscardPixels)
+	{
+		return;
+	}
+
+	unsigned int components = image.components;
+	unsigned int width = image.width;
+	unsigned int height = image.height;
+	m_pixels.assign(image.pixels, image.pixels + (size_t)width * height * components);
+
+	if (residency == TextureResidency::KeepLowMip)
+	{
+		while (width > LowMipSize || height > LowMipSize)
+		{
+			halveImage(m_pixels, width, height, components);
+		}
+
+		m_pixels.shrink_to_fit();
+	}
+
+	m_pixelWidth = width;
+	m_pixelHeight = height;
+	m_pixelComponents = components;
+}
+
+void Texture::releaseGL()
 {
 	if (m_glHandle != 0)
 	{
+		MaterialTextureTable::getInstance().textureDeleted(m_glHandle);
+		GL_TRACK_DELETED(GLObjectType::Texture, m_glHandle);
+		GLState::getInstance().textureDeleted(m_glHandle);
 		glDeleteTextures(1, &m_glHandle);
 		m_glHandle = 0;
-		m_filename = "none";
 	}
+}
 
-	m_width = width;
-	m_height = height;
-	m_format = format;
+void Texture::trackMemory()
+{
+	if (m_glHandle == 0 && m_pixels.empty())
+	{
+		TextureMemoryTracker::getInstance().remove(this);
+		return;
+	}
+
+	TextureMemoryTracker::getInstance().set(this, m_filename, m_pixels.size(), getMemorySize());
+}
+
+GLenum Texture::getCompressedFormat(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		return hasS3TC() ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : 0;
+	case BlockFormat::BC2:
+		return hasS3TC() ? GL_COMPRESSED_RGBA_S3TC_DXT3_EXT : 0;
+	case BlockFormat::BC3:
+		return hasS3TC() ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+	case BlockFormat::BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	case BlockFormat::BC7:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default:
+		return 0;
+	}
+}
+
+BlockFormat Texture::getBlockFormat(GLenum format)
+{
+	switch (format)
+	{
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		return BlockFormat::BC1;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		return BlockFormat::BC2;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		return BlockFormat::BC3;
+	case GL_COMPRESSED_RED_RGTC1:
+		return BlockFormat::BC4;
+	case GL_COMPRESSED_RG_RGTC2:
+		return BlockFormat::BC5;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		return BlockFormat::BC7;
+	default:
+		return BlockFormat::None;
+	}
+}
+
+// upload every stored mip level as is, the driver never sees (or has to compress) raw pixels
+bool Texture::uploadCompressed(TextureImage& image, const TextureOptions& options)
+{
+	const CompressedImage& compressed = image.compressed;
+
+	GLenum format = getCompressedFormat(compressed.format);
+	if (format == 0)
+	{
+		printf("Block compressed textures aren't supported by this driver (%s)\n", image.filename.c_str());
+		return false;
+	}
 
 	glGenTextures(1, &m_glHandle);
-	glBindTexture(GL_TEXTURE_2D, m_glHandle);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Texture");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_glHandle);
+
+	// storage for just the levels the file has, so a partial chain is still complete
+	glTexStorage2D(GL_TEXTURE_2D, compressed.getLevelCount(), format, compressed.width, compressed.height);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	for (unsigned int level = 0; level < compressed.getLevelCount(); level++)
+	{
+		GLsizei size = (GLsizei)compressed.getLevelSize(level);
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, compressed.getLevelWidth(level), compressed.getLevelHeight(level), format, size, compressed.getLevelData(level));
+		m_storageSize += size;
+	}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	m_sampler = SamplerCache::getInstance().get(SamplerDesc::get(options.filter, options.wrap, compressed.getLevelCount() > 1));
 
-	glTexImage2D(GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, pixels);
+	m_format = format;
+	m_hasMipmaps = compressed.getLevelCount() > 1;
+	m_width = compressed.width;
+	m_height = compressed.height;
+	m_filename = image.filename;
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	// the blocks are on the GPU now
+	image.compressed = CompressedImage();
+	return true;
 }
 
-void Texture::createDummy(Color color)
+void Texture::create(unsigned int width, unsigned int height, GLenum format, unsigned char* pixels)
 {
-	if (m_glHandle != 0)
+	releaseGL();
+	m_filename = "none";
+	m_hasMipmaps = false;
+	m_transparent = false;
+	m_storageSize = 0;
+	m_pixels.clear();
+
+	m_width = width;
+	m_height = height;
+	m_format = getSizedFormat(format);
+	m_sampler = SamplerCache::getInstance().get(SamplerType::Nearest);
+
+	glGenTextures(1, &m_glHandle);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Texture");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_glHandle);
+
+	glTexStorage2D(GL_TEXTURE_2D, 1, m_format, m_width, m_height);
+
+	// pixels are in the unsized format given (render targets start empty)
+	if (pixels != nullptr)
 	{
-		glDeleteTextures(1, &m_glHandle);
-		m_glHandle = 0;
-		m_filename = "none";
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format, GL_UNSIGNED_BYTE, pixels);
 	}
 
+	trackMemory();
+}
+
+void Texture::createDummy(Color color)
+{
+	releaseGL();
+	m_filename = "none";
+	m_hasMipmaps = false;
+	m_transparent = color.a < 255;
+	m_storageSize = 0;
+	m_pixels.clear();
+
 	m_width = 1;
 	m_height = 1;
-	m_format = GL_RGBA;
+	m_format = GL_RGBA8;
+	m_sampler = SamplerCache::getInstance().get(SamplerType::Nearest);
 
 	glGenTextures(1, &m_glHandle);
-	glBindTexture(GL_TEXTURE_2D, m_glHandle);
+	GL_TRACK_CREATED(GLObjectType::Texture, m_glHandle, "Texture");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, m_glHandle);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	unsigned char pixels[4] { color.r, color.g, color.b, color.a };
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexStorage2D(GL_TEXTURE_2D, 1, m_format, m_width, m_height);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
-	unsigned char pixels[4] { color.r, color.g, color.b, color.a };
+	trackMemory();
+}
+
+void Texture::adopt(unsigned int glHandle, unsigned int width, unsigned int height, GLenum format, size_t storageSize)
+{
+	if (glHandle != m_glHandle)
+	{
+		releaseGL();
+		m_glHandle = glHandle;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_format = format;
+	m_hasMipmaps = true;
+	m_storageSize = storageSize;
 
-	glTexImage2D(GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, pixels);
+	trackMemory();
+}
+
+size_t Texture::getBytesPerPixel(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RED:
+	case GL_ALPHA:
+	case GL_R8:
+		return 1;
+	case GL_RG:
+	case GL_RG8:
+		return 2;
+	case GL_RGB:
+	case GL_RGB8:
+		return 3;
+	case GL_RGB16F:
+		return 6;
+	case GL_RGBA16F:
+		return 8;
+	case GL_RGBA32F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+// does a GL format store alpha (BC1 counts, its punch through alpha is only known per block)
+bool Texture::hasTransparency(BlockFormat format)
+{
+	return format == BlockFormat::BC2 || format == BlockFormat::BC3 || format == BlockFormat::BC7;
+}
+
+size_t Texture::getMemorySize() const
+{
+	if (m_storageSize > 0)
+	{
+		return m_storageSize;
+	}
+
+	size_t size = (size_t)m_width * m_height * getBytesPerPixel(m_format);
+
+	// a full mip chain adds a third
+	return m_hasMipmaps ? size + size / 3 : size;
+}
+
+GLenum Texture::getSizedFormat(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RED:
+		return GL_R8;
+	case GL_RG:
+		return GL_RG8;
+	case GL_RGB:
+		return GL_RGB8;
+	case GL_RGBA:
+		return GL_RGBA8;
+	default:
+		return format;
+	}
+}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+unsigned int Texture::getLevelCount(unsigned int width, unsigned int height)
+{
+	unsigned int levels = 1;
+	for (unsigned int size = std::max(width, height); size > 1; size /= 2)
+	{
+		levels++;
+	}
+	return levels;
 }
 
 void Texture::bind(unsigned int slot) const
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, m_glHandle);
+	GLState::getInstance().bindTexture(slot, GL_TEXTURE_2D, m_glHandle);
+	GLState::getInstance().bindSampler(slot, m_sampler);
 }
\ No newline at end of file
@@ -1,8 +1,66 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "Color.h"
+#include "DDS.h"
 #include <glad\glad.h>
 
+// what happens to the decoded pixels of a texture once they are on the GPU
+enum class TextureResidency
+{
+	DiscardPixels,	// free them, only the GPU copy is kept
+	KeepPixels,		// keep the whole image for reading on the CPU
+	KeepLowMip		// keep a small (at most 64x64) copy, e.g. for average colors
+};
+
+// how an image file is turned into a texture, textures loaded with different options can't be shared
+struct TextureOptions
+{
+	bool flipVertically = true;
+	GLenum wrap = GL_REPEAT;
+	GLenum filter = GL_LINEAR;
+	TextureResidency residency = TextureResidency::DiscardPixels;
+
+	// start with the low mips only and page finer ones in as they are needed (see TextureStreamer)
+	bool streamMips = false;
+};
+
+// pixels decoded from an image file, decoding touches no GL so it can run on any thread
+// and the image handed to the GL thread to upload, owns its pixels so it can be moved but not copied
+struct TextureImage
+{
+	TextureImage() {};
+	~TextureImage();
+
+	TextureImage(TextureImage&& other) noexcept;
+	TextureImage& operator = (TextureImage&& other) noexcept;
+
+	TextureImage(const TextureImage&) = delete;
+	TextureImage& operator = (const TextureImage&) = delete;
+
+	// flipping is done here rather than through stb's global flag so decodes on different threads can't race
+	// a .dds file next to the image (written by the TextureConverter) is read instead when there is one
+	bool decode(const char* filename, bool flipVertically);
+
+	bool isCompressed() const { return compressed.format != BlockFormat::None; }
+
+	// does any pixel have alpha below 1 (block compressed images go by their format)
+	bool hasTransparency() const;
+
+	std::string filename;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int components = 0;
+	unsigned char* pixels = nullptr;
+
+	// block compressed levels, pixels is null when these are used
+	CompressedImage compressed;
+};
+
+// halve an image in place with a 2x2 box filter (odd sizes reuse their last row / column)
+void halveImage(std::vector<unsigned char>& pixels, unsigned int& width, unsigned int& height, unsigned int components);
+
+// 2D texture, owns its GL texture so it can be moved but not copied
 class Texture
 {
 public:
@@ -12,12 +70,31 @@ public:
 	Texture(unsigned int width, unsigned int height, GLenum format, unsigned char* pixels = nullptr);
 	virtual ~Texture();
 
-	bool load(const char* filename);
+	Texture(Texture&& other) noexcept;
+	Texture& operator = (Texture&& other) noexcept;
+
+	Texture(const Texture&) = delete;
+	Texture& operator = (const Texture&) = delete;
+
+	bool load(const char* filename, const TextureOptions& options = TextureOptions());
+
+	// create the GL texture from a decoded image, the pixels are kept or freed as options.residency says
+	bool upload(TextureImage& image, const TextureOptions& options = TextureOptions());
+
+	// GL format of a block compressed format, 0 if the driver can't sample it
+	static GLenum getCompressedFormat(BlockFormat format);
+
+	// block format of a GL compressed format, None for anything else
+	static BlockFormat getBlockFormat(GLenum format);
 
 	void create(unsigned int width, unsigned int height, GLenum format, unsigned char* pixels = nullptr);
 
 	void createDummy(Color color);
 
+	// take over a GL texture made elsewhere, replacing the current one unless it is the same
+	// (the TextureStreamer swaps in storage with more or fewer mips as they are paged in and out)
+	void adopt(unsigned int glHandle, unsigned int width, unsigned int height, GLenum format, size_t storageSize);
+
 	const std::string& getFilename() const { return m_filename; }
 
 	void bind(unsigned int slot) const;
@@ -25,8 +102,38 @@ public:
 	unsigned int getHandle() const { return m_glHandle; }
 
 	unsigned int getWidth() const { return m_width; }
+	GLenum getFormat() const { return m_format; }
 	unsigned int getHeight() const { return m_height; }
-	const unsigned char* getPixels() const { return m_loadedPixels; }
+
+	// bytes of GPU memory used by the texture, counting its mip chain
+	size_t getMemorySize() const;
+
+	// bytes per pixel of an uncompressed GL format
+	static size_t getBytesPerPixel(GLenum format);
+
+	// does a block format carry cutouts, BC1 doesn't as the TextureConverter only uses it for opaque images
+	static bool hasTransparency(BlockFormat format);
+
+	// whether the loaded image has any texel that isn't opaque, placeholders are opaque until the real data arrives
+	bool isTransparent() const { return m_transparent; }
+	void setTransparent(bool transparent) { m_transparent = transparent; }
+
+	// sized internal format of an unsized one (GL_RGBA -> GL_RGBA8), immutable storage needs these
+	static GLenum getSizedFormat(GLenum format);
+
+	// levels in a full mip chain
+	static unsigned int getLevelCount(unsigned int width, unsigned int height);
+
+	// sampler object bind uses, from the filter / wrap options it was loaded with (materials bind their own)
+	unsigned int getSampler() const { return m_sampler; }
+	void setSampler(unsigned int sampler) { m_sampler = sampler; }
+
+	// pixels kept on the CPU (null unless loaded with a residency that keeps them),
+	// the low mip residency keeps a smaller image than the texture
+	const unsigned char* getPixels() const { return m_pixels.empty() ? nullptr : m_pixels.data(); }
+	unsigned int getPixelWidth() const { return m_pixelWidth; }
+	unsigned int getPixelHeight() const { return m_pixelHeight; }
+	unsigned int getPixelComponents() const { return m_pixelComponents; }
 
 protected:
 
@@ -35,5 +142,23 @@ protected:
 	unsigned int m_height = 0;
 	unsigned int m_glHandle = 0;
 	unsigned int m_format = 0;
-	unsigned char* m_loadedPixels = nullptr;
+	bool m_hasMipmaps = false;
+	bool m_transparent = false;
+	size_t m_storageSize = 0; // exact bytes of the uploaded levels when known (block compressed or streamed textures)
+	unsigned int m_sampler = 0;
+
+	std::vector<unsigned char> m_pixels;
+	unsigned int m_pixelWidth = 0;
+	unsigned int m_pixelHeight = 0;
+	unsigned int m_pixelComponents = 0;
+
+private:
+
+	bool uploadCompressed(TextureImage& image, const TextureOptions& options);
+
+	void keepPixels(const TextureImage& image, TextureResidency residency);
+	void releaseGL();
+
+	// report the current CPU / GPU bytes to the TextureMemoryTracker
+	void trackMemory();
 };
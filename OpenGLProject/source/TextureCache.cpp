@@ -0,0 +1,193 @@
+#include "TextureCache.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include "AssetLoader.h"
+#include "TextureStreamer.h"
+
+#include <experimental\filesystem>
+namespace fs = std::experimental::filesystem;
+
+TextureCache& TextureCache::getInstance()
+{
+	static TextureCache instance;
+	return instance;
+}
+
+// the same file reached through different relative paths (or cases on windows) shares a key
+std::string TextureCache::makeKey(const std::string& filename, const TextureOptions& options)
+{
+	std::error_code error;
+	fs::path path = fs::canonical(filename, error);
+
+	std::string key = error ? filename : path.string();
+
+#ifdef _WIN32
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+#endif
+
+	key += '|';
+	key += options.flipVertically ? '1' : '0';
+	key += '|' + std::to_string(options.wrap) + '|' + std::to_string(options.filter);
+	key += '|' + std::to_string((int)options.residency) + (options.streamMips ? "|s" : "");
+
+	return key;
+}
+
+TextureHandle TextureCache::find(const std::string& key)
+{
+	m_lookups++;
+
+	auto entry = m_entries.find(key);
+	if (entry == m_entries.end())
+	{
+		return nullptr;
+	}
+
+	TextureHandle texture = entry->second.texture.lock();
+	if (texture == nullptr)
+	{
+		// everyone let go of it, it will be loaded again
+		m_purgedBytesSaved += entry->second.hits * entry->second.bytes;
+		m_entries.erase(entry);
+		return nullptr;
+	}
+
+	m_hits++;
+	entry->second.hits++;
+	entry->second.bytes = texture->getMemorySize();
+
+	return texture;
+}
+
+TextureHandle TextureCache::load(const std::string& filename, const TextureOptions& options)
+{
+	std::string key = makeKey(filename, options);
+
+	TextureHandle texture = find(key);
+	if (texture != nullptr)
+	{
+		return texture;
+	}
+
+	texture = std::make_shared<Texture>();
+	if (!texture->load(filename.c_str(), options))
+	{
+		return nullptr;
+	}
+
+	Entry& entry = m_entries[key];
+	entry.texture = texture;
+	entry.bytes = texture->getMemorySize();
+
+	return texture;
+}
+
+TextureHandle TextureCache::stream(const std::string& filename, Color placeholder, const TextureOptions& options)
+{
+	std::string key = makeKey(filename, options);
+
+	TextureHandle texture = find(key);
+	if (texture != nullptr)
+	{
+		return texture;
+	}
+
+	texture = std::make_shared<Texture>();
+	if (options.streamMips)
+	{
+		TextureStreamer::getInstance().add(texture, filename, placeholder, options);
+	}
+	else
+	{
+		AssetLoader::getInstance().loadTexture(texture, filename, placeholder, options);
+	}
+
+	Entry& entry = m_entries[key];
+	entry.texture = texture;
+	entry.bytes = texture->getMemorySize();
+
+	return texture;
+}
+
+TextureHandle TextureCache::createDefault(TextureHandle& texture, Color color)
+{
+	if (texture == nullptr)
+	{
+		texture = std::make_shared<Texture>();
+		texture->createDummy(color);
+	}
+
+	return texture;
+}
+
+TextureHandle TextureCache::getWhite()
+{
+	return createDefault(m_white, Color(255, 255, 255, 255));
+}
+
+TextureHandle TextureCache::getBlack()
+{
+	return createDefault(m_black, Color(0, 0, 0, 255));
+}
+
+TextureHandle TextureCache::getFlatNormal()
+{
+	return createDefault(m_flatNormal, Color(128, 128, 255, 255));
+}
+
+void TextureCache::purge()
+{
+	for (auto entry = m_entries.begin(); entry != m_entries.end();)
+	{
+		if (entry->second.texture.expired())
+		{
+			m_purgedBytesSaved += entry->second.hits * entry->second.bytes;
+			entry = m_entries.erase(entry);
+		}
+		else
+		{
+			entry++;
+		}
+	}
+}
+
+void TextureCache::clear()
+{
+	m_entries.clear();
+	m_white = nullptr;
+	m_black = nullptr;
+	m_flatNormal = nullptr;
+}
+
+TextureCacheStats TextureCache::getStats()
+{
+	purge();
+
+	TextureCacheStats stats;
+	stats.lookups = m_lookups;
+	stats.hits = m_hits;
+	stats.bytesSaved = m_purgedBytesSaved;
+
+	for (auto& entry : m_entries)
+	{
+		TextureHandle texture = entry.second.texture.lock();
+		entry.second.bytes = texture->getMemorySize();
+
+		stats.liveTextures++;
+		stats.liveBytes += entry.second.bytes;
+		stats.bytesSaved += entry.second.hits * entry.second.bytes;
+	}
+
+	return stats;
+}
+
+void TextureCache::printStats()
+{
+	TextureCacheStats stats = getStats();
+
+	std::cout << "---- texture cache ----" << std::endl;
+	std::cout << "lookups: " << stats.lookups << ", hits: " << stats.hits << " (" << stats.getHitRate() * 100.0f << "%)" << std::endl;
+	std::cout << "live textures: " << stats.liveTextures << " (" << stats.liveBytes / 1024 << " KB)" << std::endl;
+	std::cout << "saved by sharing: " << stats.bytesSaved / 1024 << " KB" << std::endl;
+}
\ No newline at end of file
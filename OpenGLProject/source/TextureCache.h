@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Texture.h"
+
+// shared reference counted texture, freed once the last material using it lets go
+typedef std::shared_ptr<Texture> TextureHandle;
+
+// lookup counters of the texture cache
+struct TextureCacheStats
+{
+	unsigned int lookups = 0;
+	unsigned int hits = 0;
+	unsigned int liveTextures = 0;
+	size_t liveBytes = 0; // GPU bytes of the textures still in use
+	size_t bytesSaved = 0; // GPU bytes a separate texture per lookup would have used on top
+
+	float getHitRate() const { return lookups > 0 ? (float)hits / lookups : 0.0f; }
+};
+
+// singleton process wide texture cache
+// files are loaded once per canonical path + options and handed out as shared handles,
+// missing textures use shared 1x1 defaults instead of a texture each
+class TextureCache
+{
+public:
+
+	static TextureCache& getInstance();
+
+	// get the texture of a file, loading it if no one is using it yet (null if it can't be loaded)
+	TextureHandle load(const std::string& filename, const TextureOptions& options = TextureOptions());
+
+	// like load but decoded in the background by the asset loader, the texture is a 1x1 of the placeholder color until then
+	// (with streamMips the texture streamer owns it and pages its mips in as they are needed)
+	TextureHandle stream(const std::string& filename, Color placeholder, const TextureOptions& options = TextureOptions());
+
+	// shared 1x1 defaults
+	TextureHandle getWhite();
+	TextureHandle getBlack();
+	TextureHandle getFlatNormal();
+
+	TextureCacheStats getStats();
+	void printStats();
+
+	// forget textures no one uses anymore
+	void purge();
+
+	// let go of every texture the cache holds, call while the GL context is still alive
+	void clear();
+
+private:
+
+	TextureCache() {};
+	~TextureCache() {};
+
+	struct Entry
+	{
+		std::weak_ptr<Texture> texture;
+		unsigned int hits = 0;
+		size_t bytes = 0; // size when last seen alive, for the stats once it is gone
+	};
+
+	static std::string makeKey(const std::string& filename, const TextureOptions& options);
+
+	// returns the live entry for the key or creates an empty one
+	TextureHandle find(const std::string& key);
+
+	TextureHandle createDefault(TextureHandle& texture, Color color);
+
+	std::unordered_map<std::string, Entry> m_entries;
+
+	unsigned int m_lookups = 0;
+	unsigned int m_hits = 0;
+	size_t m_purgedBytesSaved = 0;
+
+	TextureHandle m_white;
+	TextureHandle m_black;
+	TextureHandle m_flatNormal;
+};
\ No newline at end of file
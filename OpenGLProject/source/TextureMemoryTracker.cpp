@@ -0,0 +1,96 @@
+#include "TextureMemoryTracker.h"
+#include <algorithm>
+#include <iostream>
+
+TextureMemoryTracker& TextureMemoryTracker::getInstance()
+{
+	static TextureMemoryTracker instance;
+	return instance;
+}
+
+void TextureMemoryTracker::set(const void* owner, const std::string& name, size_t cpuBytes, size_t gpuBytes)
+{
+	auto result = m_entries.emplace(owner, TextureMemoryEntry());
+	TextureMemoryEntry& entry = result.first->second;
+
+	if (result.second)
+	{
+		m_stats.textureCount++;
+	}
+	else
+	{
+		m_stats.cpuBytes -= entry.cpuBytes;
+		m_stats.gpuBytes -= entry.gpuBytes;
+	}
+
+	entry.name = name;
+	entry.cpuBytes = cpuBytes;
+	entry.gpuBytes = gpuBytes;
+
+	m_stats.cpuBytes += cpuBytes;
+	m_stats.gpuBytes += gpuBytes;
+	m_stats.peakCpuBytes = std::max(m_stats.peakCpuBytes, m_stats.cpuBytes);
+	m_stats.peakGpuBytes = std::max(m_stats.peakGpuBytes, m_stats.gpuBytes);
+}
+
+void TextureMemoryTracker::remove(const void* owner)
+{
+	auto entry = m_entries.find(owner);
+	if (entry == m_entries.end())
+	{
+		return;
+	}
+
+	m_stats.textureCount--;
+	m_stats.cpuBytes -= entry->second.cpuBytes;
+	m_stats.gpuBytes -= entry->second.gpuBytes;
+
+	m_entries.erase(entry);
+}
+
+std::vector<TextureMemoryEntry> TextureMemoryTracker::getLargest(unsigned int count) const
+{
+	std::vector<TextureMemoryEntry> entries;
+	entries.reserve(m_entries.size());
+	for (const auto& entry : m_entries)
+	{
+		entries.push_back(entry.second);
+	}
+
+	count = std::min(count, (unsigned int)entries.size());
+	std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), [](const TextureMemoryEntry& a, const TextureMemoryEntry& b)
+	{
+		return a.cpuBytes + a.gpuBytes > b.cpuBytes + b.gpuBytes;
+	});
+	entries.resize(count);
+
+	return entries;
+}
+
+void TextureMemoryTracker::print(unsigned int largestCount) const
+{
+	std::cout << "---- texture memory ----" << std::endl;
+	std::cout << "textures: " << m_stats.textureCount << std::endl;
+	std::cout << "cpu: " << m_stats.cpuBytes / 1024 << " KB (peak " << m_stats.peakCpuBytes / 1024 << " KB)" << std::endl;
+	std::cout << "gpu: " << m_stats.gpuBytes / 1024 << " KB (peak " << m_stats.peakGpuBytes / 1024 << " KB)" << std::endl;
+
+	for (const TextureMemoryEntry& entry : getLargest(largestCount))
+	{
+		std::cout << "  " << entry.name << ": cpu " << entry.cpuBytes / 1024 << " KB, gpu " << entry.gpuBytes / 1024 << " KB" << std::endl;
+	}
+}
+
+void TextureMemoryTracker::update(float deltaTime)
+{
+	if (m_logInterval <= 0.0f)
+	{
+		return;
+	}
+
+	m_timeSinceLog += deltaTime;
+	if (m_timeSinceLog >= m_logInterval)
+	{
+		m_timeSinceLog = 0.0f;
+		print();
+	}
+}
\ No newline at end of file
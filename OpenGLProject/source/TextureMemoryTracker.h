@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// memory one texture is using
+struct TextureMemoryEntry
+{
+	std::string name;
+	size_t cpuBytes = 0; // decoded pixels still held in system memory
+	size_t gpuBytes = 0; // estimated video memory, mips included
+};
+
+// totals over every live texture
+struct TextureMemoryStats
+{
+	unsigned int textureCount = 0;
+	size_t cpuBytes = 0;
+	size_t gpuBytes = 0;
+	size_t peakCpuBytes = 0;
+	size_t peakGpuBytes = 0;
+};
+
+// singleton record of what every live texture and cubemap costs, updated by the textures themselves
+// whenever their GL storage or kept pixels change, so long sessions can see where memory goes
+class TextureMemoryTracker
+{
+public:
+
+	static TextureMemoryTracker& getInstance();
+
+	// add or replace the record of a texture (keyed by the texture object)
+	void set(const void* owner, const std::string& name, size_t cpuBytes, size_t gpuBytes);
+	void remove(const void* owner);
+
+	const TextureMemoryStats& getStats() const { return m_stats; }
+
+	// the textures using the most memory (CPU + GPU), largest first
+	std::vector<TextureMemoryEntry> getLargest(unsigned int count) const;
+
+	void print(unsigned int largestCount = 5) const;
+
+	// print the stats every so many seconds, 0 turns the log off
+	void setLogInterval(float seconds) { m_logInterval = seconds; }
+	void update(float deltaTime);
+
+private:
+
+	TextureMemoryTracker() {};
+	~TextureMemoryTracker() {};
+
+	std::unordered_map<const void*, TextureMemoryEntry> m_entries;
+	TextureMemoryStats m_stats;
+
+	float m_logInterval = 0.0f;
+	float m_timeSinceLog = 0.0f;
+};
\ No newline at end of file
@@ -0,0 +1,692 @@
+#include "TextureStreamer.h"
+#include <glad\glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "AssetLoader.h"
+#include "DDS.h"
+#include "GLExtensions.h"
+#include "GLObjectTracker.h"
+#include "GLState.h"
+#include "SamplerCache.h"
+
+// ARB_sparse_texture, glad only has the core profile
+#define GL_TEXTURE_SPARSE_ARB 0x91A6
+#define GL_NUM_SPARSE_LEVELS_ARB 0x91AA
+#define GL_NUM_VIRTUAL_PAGE_SIZES_ARB 0x91A8
+#define GL_VIRTUAL_PAGE_SIZE_X_ARB 0x9195
+#define GL_VIRTUAL_PAGE_SIZE_Y_ARB 0x9196
+typedef void (APIENTRYP PFNGLTEXPAGECOMMITMENTARBPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+	GLsizei width, GLsizei height, GLsizei depth, GLboolean commit);
+
+// largest side of the levels a streamed texture always keeps
+static const unsigned int TailSize = 128;
+
+// most loads waiting on the asset loader at once
+static const unsigned int MaxLoadsInFlight = 4;
+
+static PFNGLTEXPAGECOMMITMENTARBPROC texPageCommitment = nullptr;
+
+// levels of a streamed texture read on a loader thread, rgba8 pixels or blocks
+struct StreamedLevels
+{
+	BlockFormat format = BlockFormat::None;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int levelCount = 0;
+	bool transparent = false; // of the whole image, only filled in by the first load
+
+	unsigned int firstLevel = 0;
+	std::vector<std::vector<unsigned char>> levels;
+};
+
+static bool hasSparseTextures()
+{
+	static const bool supported = GLExtensions::has("GL_ARB_sparse_texture") &&
+		(texPageCommitment = (PFNGLTEXPAGECOMMITMENTARBPROC)GLExtensions::getProcAddress("glTexPageCommitmentARB")) != nullptr;
+
+	return supported;
+}
+
+// sparse storage has to be a whole number of the format's pages
+static bool canBeSparse(GLenum internalFormat, unsigned int width, unsigned int height)
+{
+	if (!hasSparseTextures())
+	{
+		return false;
+	}
+
+	GLint pageSizes = 0;
+	glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &pageSizes);
+	if (pageSizes == 0)
+	{
+		return false;
+	}
+
+	GLint pageWidth = 0, pageHeight = 0;
+	glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pageWidth);
+	glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pageHeight);
+
+	return pageWidth > 0 && pageHeight > 0 && width % pageWidth == 0 && height % pageHeight == 0;
+}
+
+static unsigned int getLevelDimension(unsigned int size, unsigned int level)
+{
+	return std::max(1u, size >> level);
+}
+
+// first level no bigger than the tail size
+static unsigned int getTailLevel(unsigned int width, unsigned int height, unsigned int levelCount)
+{
+	unsigned int level = 0;
+	while (level + 1 < levelCount && std::max(getLevelDimension(width, level), getLevelDimension(height, level)) > TailSize)
+	{
+		level++;
+	}
+	return level;
+}
+
+// expand any decoded image to rgba8, grey is copied to every color channel and grey + alpha becomes red + green like GL_RG
+static std::vector<unsigned char> toRGBA(const TextureImage& image)
+{
+	size_t count = (size_t)image.width * image.height;
+	std::vector<unsigned char> rgba(count * 4);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char* source = image.pixels + i * image.components;
+		unsigned char* target = &rgba[i * 4];
+
+		switch (image.components)
+		{
+		case 1:
+			target[0] = target[1] = target[2] = source[0];
+			target[3] = 255;
+			break;
+		case 2:
+			target[0] = source[0];
+			target[1] = source[1];
+			target[2] = 0;
+			target[3] = 255;
+			break;
+		case 3:
+			target[0] = source[0];
+			target[1] = source[1];
+			target[2] = source[2];
+			target[3] = 255;
+			break;
+		default:
+			memcpy(target, source, 4);
+			break;
+		}
+	}
+
+	return rgba;
+}
+
+// read levels [firstLevel, endLevel) of a texture, with endLevel 0 the size and the tail levels
+// the dds next to the file only has the asked for levels copied, an image is decoded whole and downsampled
+static bool readLevels(const std::string& filename, bool flipVertically, unsigned int firstLevel, unsigned int endLevel, StreamedLevels& result)
+{
+	std::string ddsPath = DDS::getPath(filename);
+
+	// a dds that would have to be flipped and can't be (BC7) is left for the source image, as TextureImage::decode does
+	CompressedImage compressed;
+	if (DDS::readHeader(ddsPath, compressed) && (!flipVertically || DDS::canFlipVertically(compressed.format)))
+	{
+		result.format = compressed.format;
+		result.transparent = Texture::hasTransparency(compressed.format);
+		result.width = compressed.width;
+		result.height = compressed.height;
+		result.levelCount = compressed.getLevelCount();
+
+		if (endLevel == 0)
+		{
+			firstLevel = getTailLevel(result.width, result.height, result.levelCount);
+			endLevel = result.levelCount;
+		}
+
+		if (!DDS::readLevels(ddsPath, firstLevel, endLevel - firstLevel, compressed))
+		{
+			return false;
+		}
+
+		if (flipVertically)
+		{
+			DDS::flipVertically(compressed);
+		}
+
+		result.firstLevel = firstLevel;
+		for (unsigned int level = 0; level < compressed.getLevelCount(); level++)
+		{
+			const unsigned char* data = compressed.getLevelData(level);
+			result.levels.emplace_back(data, data + compressed.getLevelSize(level));
+		}
+
+		return true;
+	}
+
+	TextureImage image;
+	if (!image.decode(filename.c_str(), flipVertically) || image.pixels == nullptr)
+	{
+		return false;
+	}
+
+	unsigned int width = image.width;
+	unsigned int height = image.height;
+	std::vector<unsigned char> pixels = toRGBA(image);
+	result.transparent = endLevel == 0 && image.hasTransparency();
+
+	result.format = BlockFormat::None;
+	result.width = width;
+	result.height = height;
+	result.levelCount = Texture::getLevelCount(width, height);
+
+	if (endLevel == 0)
+	{
+		firstLevel = getTailLevel(result.width, result.height, result.levelCount);
+		endLevel = result.levelCount;
+	}
+
+	result.firstLevel = firstLevel;
+	for (unsigned int level = 0; level < endLevel; level++)
+	{
+		if (level >= firstLevel)
+		{
+			result.levels.push_back(pixels);
+		}
+
+		if (level + 1 < endLevel)
+		{
+			halveImage(pixels, width, height, 4);
+		}
+	}
+
+	return true;
+}
+
+TextureStreamer& TextureStreamer::getInstance()
+{
+	static TextureStreamer instance;
+	return instance;
+}
+
+size_t TextureStreamer::getLevelSize(const StreamedTexture& streamed, unsigned int level) const
+{
+	unsigned int width = getLevelDimension(streamed.width, level);
+	unsigned int height = getLevelDimension(streamed.height, level);
+
+	if (streamed.format == BlockFormat::None)
+	{
+		return (size_t)width * height * 4;
+	}
+
+	return DDS::getLevelSize(streamed.format, width, height);
+}
+
+size_t TextureStreamer::getChainSize(const StreamedTexture& streamed, unsigned int firstLevel) const
+{
+	size_t size = 0;
+	for (unsigned int level = firstLevel; level < streamed.levelCount; level++)
+	{
+		size += getLevelSize(streamed, level);
+	}
+	return size;
+}
+
+void TextureStreamer::add(const std::shared_ptr<Texture>& texture, const std::string& filename, Color placeholder, const TextureOptions& options)
+{
+	texture->createDummy(placeholder);
+
+	// the levels keep changing but the filtering doesn't
+	texture->setSampler(SamplerCache::getInstance().get(SamplerDesc::get(options.filter, options.wrap, true)));
+
+	StreamedTexture& streamed = m_textures[texture.get()];
+	streamed = StreamedTexture();
+	streamed.texture = texture;
+	streamed.filename = filename;
+	streamed.options = options;
+
+	startLoad(texture, streamed, 0);
+}
+
+void TextureStreamer::request(const Texture* texture, float uvPerPixel)
+{
+	auto found = m_textures.find(texture);
+	if (found == m_textures.end() || found->second.levelCount == 0)
+	{
+		return;
+	}
+
+	StreamedTexture& streamed = found->second;
+
+	// a texel per pixel at the level asked for, the tail already covers anything coarser
+	float texelsPerPixel = uvPerPixel * std::max(streamed.width, streamed.height);
+	unsigned int level = texelsPerPixel > 1.0f ? (unsigned int)std::log2(texelsPerPixel) : 0;
+	level = std::min(level, streamed.tailLevel);
+
+	if (streamed.wantedFrame != m_frame)
+	{
+		streamed.wantedFrame = m_frame;
+		streamed.wantedLevel = level;
+	}
+	else
+	{
+		streamed.wantedLevel = std::min(streamed.wantedLevel, level);
+	}
+}
+
+void TextureStreamer::startLoad(const std::shared_ptr<Texture>& texture, StreamedTexture& streamed, unsigned int firstLevel)
+{
+	streamed.loading = true;
+	streamed.loadingLevel = firstLevel;
+
+	const Texture* key = texture.get();
+	std::string filename = streamed.filename;
+	bool flipVertically = streamed.options.flipVertically;
+
+	// the first load reads the size and the tail, later ones the levels above what is resident
+	unsigned int endLevel = streamed.levelCount > 0 ? streamed.residentLevel : 0;
+
+	AssetLoader::getInstance().load(key, [this, key, filename, flipVertically, firstLevel, endLevel]() -> AssetLoader::UploadFunction
+	{
+		// shared so the upload function can still be copied
+		std::shared_ptr<StreamedLevels> levels = std::make_shared<StreamedLevels>();
+		if (!readLevels(filename, flipVertically, firstLevel, endLevel, *levels))
+		{
+			levels = nullptr;
+		}
+
+		return [this, key, filename, levels]() { finishLoad(key, filename, levels.get()); };
+	}, texture);
+}
+
+void TextureStreamer::finishLoad(const Texture* texture, const std::string& filename, const StreamedLevels* levels)
+{
+	auto found = m_textures.find(texture);
+	if (found == m_textures.end())
+	{
+		return;
+	}
+
+	StreamedTexture& streamed = found->second;
+	streamed.loading = false;
+
+	if (levels == nullptr)
+	{
+		std::cout << "Failed to stream a texture from " << filename << std::endl;
+		return;
+	}
+
+	if (streamed.levelCount == 0)
+	{
+		if (!createStorage(streamed, *levels))
+		{
+			return;
+		}
+	}
+	else
+	{
+		// sparse storage already covers the new levels, otherwise it grows to fit them
+		if (!streamed.sparse)
+		{
+			reallocate(streamed, levels->firstLevel);
+		}
+
+		m_levelsPagedIn += streamed.residentLevel - levels->firstLevel;
+	}
+
+	uploadLevels(streamed, *levels);
+	setResidentLevel(streamed, levels->firstLevel);
+}
+
+bool TextureStreamer::createStorage(StreamedTexture& streamed, const StreamedLevels& levels)
+{
+	streamed.format = levels.format;
+	streamed.internalFormat = levels.format == BlockFormat::None ? GL_RGBA8 : Texture::getCompressedFormat(levels.format);
+	if (streamed.internalFormat == 0)
+	{
+		std::cout << "Block compressed textures aren't supported by this driver (" << streamed.filename << ")" << std::endl;
+		return false;
+	}
+
+	streamed.width = levels.width;
+	streamed.height = levels.height;
+	streamed.levelCount = levels.levelCount;
+	streamed.tailLevel = levels.firstLevel;
+
+	// the placeholder was opaque, materials pick up cutouts from here on (see Material::getFeatures)
+	streamed.texture.lock()->setTransparent(levels.transparent);
+
+	// nothing resident yet
+	streamed.residentLevel = streamed.levelCount;
+	streamed.storageLevel = streamed.levelCount;
+
+	streamed.sparse = m_allowSparse && canBeSparse(streamed.internalFormat, streamed.width, streamed.height);
+	if (!streamed.sparse)
+	{
+		reallocate(streamed, levels.firstLevel);
+		return true;
+	}
+
+	// the whole chain is allocated up front but only committed levels use memory
+	GLuint handle = 0;
+	glGenTextures(1, &handle);
+	GL_TRACK_CREATED(GLObjectType::Texture, handle, "TextureStreamer");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, handle);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+	glTexStorage2D(GL_TEXTURE_2D, streamed.levelCount, streamed.internalFormat, streamed.width, streamed.height);
+
+	GLint sparseLevels = 0;
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &sparseLevels);
+	streamed.sparseLevels = (unsigned int)sparseLevels;
+	streamed.storageLevel = 0;
+
+	streamed.texture.lock()->adopt(handle, streamed.width, streamed.height, streamed.internalFormat, 0);
+	return true;
+}
+
+// new storage for the levels from storageLevel on, with the resident levels both have copied across on the GPU
+void TextureStreamer::reallocate(StreamedTexture& streamed, unsigned int storageLevel)
+{
+	std::shared_ptr<Texture> texture = streamed.texture.lock();
+	unsigned int oldHandle = texture->getHandle();
+
+	GLuint handle = 0;
+	glGenTextures(1, &handle);
+	GL_TRACK_CREATED(GLObjectType::Texture, handle, "TextureStreamer");
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, handle);
+
+	glTexStorage2D(GL_TEXTURE_2D, streamed.levelCount - storageLevel, streamed.internalFormat,
+		getLevelDimension(streamed.width, storageLevel), getLevelDimension(streamed.height, storageLevel));
+
+	for (unsigned int level = std::max(storageLevel, streamed.residentLevel); level < streamed.levelCount; level++)
+	{
+		glCopyImageSubData(oldHandle, GL_TEXTURE_2D, level - streamed.storageLevel, 0, 0, 0,
+			handle, GL_TEXTURE_2D, level - storageLevel, 0, 0, 0,
+			getLevelDimension(streamed.width, level), getLevelDimension(streamed.height, level), 1);
+	}
+
+	streamed.storageLevel = storageLevel;
+
+	// frees the old storage (or the placeholder)
+	texture->adopt(handle, getLevelDimension(streamed.width, storageLevel), getLevelDimension(streamed.height, storageLevel),
+		streamed.internalFormat, getChainSize(streamed, storageLevel));
+}
+
+void TextureStreamer::uploadLevels(StreamedTexture& streamed, const StreamedLevels& levels)
+{
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, streamed.texture.lock()->getHandle());
+
+	for (unsigned int i = 0; i < levels.levels.size(); i++)
+	{
+		unsigned int level = levels.firstLevel + i;
+		GLsizei width = getLevelDimension(streamed.width, level);
+		GLsizei height = getLevelDimension(streamed.height, level);
+		const std::vector<unsigned char>& data = levels.levels[i];
+
+		// committing any level of the sparse mip tail commits all of it
+		if (streamed.sparse)
+		{
+			texPageCommitment(GL_TEXTURE_2D, level, 0, 0, 0, width, height, 1, GL_TRUE);
+		}
+
+		GLint storageLevel = level - streamed.storageLevel;
+		if (streamed.format == BlockFormat::None)
+		{
+			glTexSubImage2D(GL_TEXTURE_2D, storageLevel, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		}
+		else
+		{
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, storageLevel, 0, 0, width, height, streamed.internalFormat, (GLsizei)data.size(), data.data());
+		}
+	}
+}
+
+// sample from level on, the levels before it may be gone
+void TextureStreamer::setResidentLevel(StreamedTexture& streamed, unsigned int level)
+{
+	std::shared_ptr<Texture> texture = streamed.texture.lock();
+
+	streamed.residentLevel = level;
+	streamed.loadingLevel = level;
+
+	GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, texture->getHandle());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - streamed.storageLevel);
+
+	texture->adopt(texture->getHandle(), getLevelDimension(streamed.width, level), getLevelDimension(streamed.height, level),
+		streamed.internalFormat, getChainSize(streamed, level));
+}
+
+// drop every level finer than level
+void TextureStreamer::evict(StreamedTexture& streamed, unsigned int level)
+{
+	unsigned int firstLevel = streamed.residentLevel;
+
+	if (streamed.sparse)
+	{
+		// stop sampling them before the pages go
+		setResidentLevel(streamed, level);
+
+		for (unsigned int evicted = firstLevel; evicted < level && evicted < streamed.sparseLevels; evicted++)
+		{
+			texPageCommitment(GL_TEXTURE_2D, evicted, 0, 0, 0,
+				getLevelDimension(streamed.width, evicted), getLevelDimension(streamed.height, evicted), 1, GL_FALSE);
+		}
+	}
+	else
+	{
+		reallocate(streamed, level);
+		setResidentLevel(streamed, level);
+	}
+
+	m_levelsEvicted += level - firstLevel;
+}
+
+bool TextureStreamer::makeRoom(size_t bytes, const StreamedTexture* loading)
+{
+	size_t used = m_residentBytes + m_loadingBytes;
+	if (used + bytes <= m_budget)
+	{
+		return true;
+	}
+
+	size_t shortfall = used + bytes - m_budget;
+
+	// levels finer than a texture needs (everything above the tail if it wasn't asked for this frame)
+	struct Victim
+	{
+		StreamedTexture* streamed;
+		unsigned int limit;
+	};
+
+	std::vector<Victim> victims;
+	size_t evictable = 0;
+
+	for (auto& entry : m_textures)
+	{
+		StreamedTexture& streamed = entry.second;
+		if (&streamed == loading || streamed.loading || streamed.levelCount == 0 || streamed.texture.expired())
+		{
+			continue;
+		}
+
+		unsigned int limit = isWanted(streamed) ? std::min(streamed.wantedLevel, streamed.tailLevel) : streamed.tailLevel;
+		if (limit > streamed.residentLevel)
+		{
+			victims.push_back({ &streamed, limit });
+			evictable += getChainSize(streamed, streamed.residentLevel) - getChainSize(streamed, limit);
+		}
+	}
+
+	if (evictable < shortfall)
+	{
+		return false;
+	}
+
+	// longest unused first, the ones asked for this frame last
+	std::sort(victims.begin(), victims.end(), [](const Victim& a, const Victim& b)
+	{
+		return a.streamed->wantedFrame < b.streamed->wantedFrame;
+	});
+
+	size_t freed = 0;
+	for (const Victim& victim : victims)
+	{
+		StreamedTexture& streamed = *victim.streamed;
+
+		unsigned int level = streamed.residentLevel;
+		size_t victimFreed = 0;
+		while (level < victim.limit && freed + victimFreed < shortfall)
+		{
+			victimFreed += getLevelSize(streamed, level++);
+		}
+
+		evict(streamed, level);
+		freed += victimFreed;
+
+		if (freed >= shortfall)
+		{
+			break;
+		}
+	}
+
+	m_residentBytes -= freed;
+	return true;
+}
+
+void TextureStreamer::update()
+{
+	// forget textures that have been freed, their storage went with them
+	for (auto entry = m_textures.begin(); entry != m_textures.end();)
+	{
+		if (entry->second.texture.expired())
+		{
+			entry = m_textures.erase(entry);
+		}
+		else
+		{
+			entry++;
+		}
+	}
+
+	m_residentBytes = 0;
+	m_loadingBytes = 0;
+	unsigned int loadsInFlight = 0;
+
+	std::vector<StreamedTexture*> candidates;
+
+	for (auto& entry : m_textures)
+	{
+		StreamedTexture& streamed = entry.second;
+		if (streamed.levelCount == 0)
+		{
+			loadsInFlight += streamed.loading ? 1 : 0;
+			continue;
+		}
+
+		m_residentBytes += getChainSize(streamed, streamed.residentLevel);
+
+		if (streamed.loading)
+		{
+			m_loadingBytes += getChainSize(streamed, streamed.loadingLevel) - getChainSize(streamed, streamed.residentLevel);
+			loadsInFlight++;
+		}
+		else if (isWanted(streamed) && streamed.wantedLevel < streamed.residentLevel)
+		{
+			candidates.push_back(&streamed);
+		}
+	}
+
+	// the textures furthest from the detail they need first
+	std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->residentLevel - a->wantedLevel > b->residentLevel - b->wantedLevel;
+	});
+
+	for (StreamedTexture* streamed : candidates)
+	{
+		if (loadsInFlight >= MaxLoadsInFlight)
+		{
+			break;
+		}
+
+		// settle for coarser levels than asked for if the finest ones don't fit
+		unsigned int level = streamed->wantedLevel;
+		size_t residentSize = getChainSize(*streamed, streamed->residentLevel);
+		while (level < streamed->residentLevel && !makeRoom(getChainSize(*streamed, level) - residentSize, streamed))
+		{
+			level++;
+		}
+
+		if (level == streamed->residentLevel)
+		{
+			continue;
+		}
+
+		std::shared_ptr<Texture> texture = streamed->texture.lock();
+		startLoad(texture, *streamed, level);
+
+		m_loadingBytes += getChainSize(*streamed, level) - residentSize;
+		loadsInFlight++;
+	}
+
+	m_frame++;
+}
+
+bool TextureStreamer::getChain(const Texture* texture, StreamedChain& chain) const
+{
+	auto found = m_textures.find(texture);
+	if (found == m_textures.end() || found->second.levelCount == 0)
+	{
+		return false;
+	}
+
+	const StreamedTexture& streamed = found->second;
+	chain.width = streamed.width;
+	chain.height = streamed.height;
+	chain.levelCount = streamed.levelCount;
+	chain.storageLevel = streamed.storageLevel;
+	chain.residentLevel = streamed.residentLevel;
+	return true;
+}
+
+TextureStreamerStats TextureStreamer::getStats() const
+{
+	TextureStreamerStats stats;
+	stats.textures = (unsigned int)m_textures.size();
+	stats.budget = m_budget;
+	stats.levelsPagedIn = m_levelsPagedIn;
+	stats.levelsEvicted = m_levelsEvicted;
+	stats.sparse = hasSparseTextures();
+
+	for (const auto& entry : m_textures)
+	{
+		const StreamedTexture& streamed = entry.second;
+		stats.loadsInFlight += streamed.loading ? 1 : 0;
+
+		if (streamed.levelCount > 0)
+		{
+			// update has moved on a frame since the requests
+			bool wanted = streamed.wantedFrame + 1 == m_frame;
+
+			stats.residentBytes += getChainSize(streamed, streamed.residentLevel);
+			stats.wantedBytes += getChainSize(streamed, wanted ? streamed.wantedLevel : streamed.tailLevel);
+		}
+	}
+
+	return stats;
+}
+
+void TextureStreamer::printStats() const
+{
+	TextureStreamerStats stats = getStats();
+
+	std::cout << "---- texture streaming ----" << std::endl;
+	std::cout << "textures: " << stats.textures << " (" << stats.loadsInFlight << " loading, " << (stats.sparse ? "sparse" : "reallocated") << " storage)" << std::endl;
+	std::cout << "resident: " << stats.residentBytes / 1024 << " KB of " << stats.budget / 1024 << " KB, wanted: " << stats.wantedBytes / 1024 << " KB" << std::endl;
+	std::cout << "levels paged in: " << stats.levelsPagedIn << ", evicted: " << stats.levelsEvicted << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Color.h"
+#include "Texture.h"
+
+struct StreamedLevels;
+
+// counters of the texture streamer
+struct TextureStreamerStats
+{
+	unsigned int textures = 0;
+	unsigned int loadsInFlight = 0;
+	size_t residentBytes = 0; // mips on the GPU
+	size_t wantedBytes = 0; // what the mips asked for last frame would take
+	size_t budget = 0;
+	unsigned int levelsPagedIn = 0;
+	unsigned int levelsEvicted = 0;
+	bool sparse = false; // ARB_sparse_texture is used
+};
+
+// where a streamed texture's GL levels sit in its full mip chain
+struct StreamedChain
+{
+	unsigned int width = 0; // of level 0
+	unsigned int height = 0;
+	unsigned int levelCount = 0;
+	unsigned int storageLevel = 0; // chain level of the GL texture's level 0
+	unsigned int residentLevel = 0; // finest chain level with data
+};
+
+// singleton mip streamer
+// streamed textures start with only their small mips (the tail), meshes ask each frame for the mip
+// they need from their distance and uv density, and finer mips are read on the asset loader's threads
+// and paged in while there is budget, evicting the finest mips of textures that need them least.
+// with ARB_sparse_texture the storage covers the whole chain and levels are committed / decommitted,
+// otherwise it is reallocated with glTexStorage2D for just the resident levels and the kept ones copied over
+class TextureStreamer
+{
+public:
+
+	static TextureStreamer& getInstance();
+
+	// the texture is a 1x1 placeholder until the tail is loaded
+	// levels come from the dds next to the file if there is one, otherwise the image is decoded and downsampled
+	void add(const std::shared_ptr<Texture>& texture, const std::string& filename, Color placeholder, const TextureOptions& options);
+
+	// ask for the mip a texture needs this frame, uvPerPixel is how much of the 0 - 1 uv range one screen pixel covers
+	// (textures that aren't streamed are ignored)
+	void request(const Texture* texture, float uvPerPixel);
+
+	// page mips in and out for the requests since the last call, once per frame
+	void update();
+
+	// sparse textures keep one GL texture as levels are committed, which the MaterialTextureTable can't follow
+	// (bindless handles freeze the base level, array copies go stale), so it can be turned off
+	void setAllowSparse(bool allow) { m_allowSparse = allow; }
+
+	// false if the texture isn't streamed or its size isn't known yet
+	bool getChain(const Texture* texture, StreamedChain& chain) const;
+
+	void setBudget(size_t bytes) { m_budget = bytes; }
+	size_t getBudget() const { return m_budget; }
+
+	TextureStreamerStats getStats() const;
+	void printStats() const;
+
+private:
+
+	TextureStreamer() {};
+	~TextureStreamer() {};
+
+	struct StreamedTexture
+	{
+		std::weak_ptr<Texture> texture;
+		std::string filename;
+		TextureOptions options;
+
+		// known once the tail has been read, level count 0 until then
+		BlockFormat format = BlockFormat::None; // None is rgba8
+		GLenum internalFormat = 0;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int levelCount = 0;
+		unsigned int tailLevel = 0; // levels from here on are always resident
+
+		unsigned int residentLevel = 0; // finest level on the GPU
+		bool loading = false;
+		unsigned int loadingLevel = 0; // finest level of the load in flight
+		unsigned int storageLevel = 0; // level the GL storage starts at (always 0 with sparse storage)
+
+		bool sparse = false;
+		unsigned int sparseLevels = 0; // levels committed one at a time, the rest are the sparse mip tail
+
+		unsigned int wantedLevel = 0; // finest level asked for in wantedFrame
+		unsigned int wantedFrame = 0;
+	};
+
+	size_t getLevelSize(const StreamedTexture& streamed, unsigned int level) const;
+	// bytes of every level from firstLevel to the end of the chain
+	size_t getChainSize(const StreamedTexture& streamed, unsigned int firstLevel) const;
+
+	bool isWanted(const StreamedTexture& streamed) const { return streamed.wantedFrame == m_frame; }
+
+	void startLoad(const std::shared_ptr<Texture>& texture, StreamedTexture& streamed, unsigned int firstLevel);
+	void finishLoad(const Texture* texture, const std::string& filename, const StreamedLevels* levels);
+
+	bool createStorage(StreamedTexture& streamed, const StreamedLevels& levels);
+	void reallocate(StreamedTexture& streamed, unsigned int storageLevel);
+	void uploadLevels(StreamedTexture& streamed, const StreamedLevels& levels);
+	void setResidentLevel(StreamedTexture& streamed, unsigned int level);
+	void evict(StreamedTexture& streamed, unsigned int level);
+
+	// evict levels of other textures until bytes fit in the budget, false if they can't
+	bool makeRoom(size_t bytes, const StreamedTexture* loading);
+
+	std::unordered_map<const Texture*, StreamedTexture> m_textures;
+
+	bool m_allowSparse = true;
+	size_t m_budget = 256 * 1024 * 1024;
+	size_t m_residentBytes = 0; // recounted every update
+	size_t m_loadingBytes = 0;
+	unsigned int m_frame = 1;
+
+	unsigned int m_levelsPagedIn = 0;
+	unsigned int m_levelsEvicted = 0;
+};
\ No newline at end of file
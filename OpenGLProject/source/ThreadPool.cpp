@@ -0,0 +1,125 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int workerCount)
+{
+	m_workers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+// finish the queued jobs then join the workers
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::getDefault()
+{
+	static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+	// no workers to hand it to
+	if (m_workers.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_wake.notify_one();
+}
+
+void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int)>& job)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// shared with the helper jobs, which may only get to run after this call has returned
+	struct ParallelState
+	{
+		std::function<void(unsigned int)> job;
+		unsigned int count;
+		std::atomic<unsigned int> next;
+		std::atomic<unsigned int> finished;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+
+	std::shared_ptr<ParallelState> state = std::make_shared<ParallelState>();
+	state->job = job;
+	state->count = count;
+	state->next = 0;
+	state->finished = 0;
+
+	// take indices until there are none left
+	auto run = [](ParallelState& s)
+	{
+		unsigned int index;
+		while ((index = s.next++) < s.count)
+		{
+			s.job(index);
+
+			if (++s.finished == s.count)
+			{
+				std::lock_guard<std::mutex> lock(s.mutex);
+				s.done.notify_all();
+			}
+		}
+	};
+
+	unsigned int helpers = std::min(count - 1, getWorkerCount());
+	for (unsigned int i = 0; i < helpers; i++)
+	{
+		enqueue([state, run]() { run(*state); });
+	}
+
+	run(*state);
+
+	// wait for the indices the helpers took
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state]() { return state->finished == state->count; });
+}
+
+void ThreadPool::workerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+			if (m_jobs.empty())
+			{
+				return;
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
\ No newline at end of file
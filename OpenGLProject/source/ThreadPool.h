@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads running queued jobs in order
+class ThreadPool
+{
+public:
+
+	// workerCount 0 runs everything on the calling thread
+	explicit ThreadPool(unsigned int workerCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator = (const ThreadPool&) = delete;
+
+	// pool shared by the loaders, one worker per core besides the main thread
+	static ThreadPool& getDefault();
+
+	void enqueue(std::function<void()> job);
+
+	// run job(0) .. job(count - 1) across the workers and the calling thread, returns once they have all finished
+	// safe to call from inside a job, the caller keeps taking indices so it never waits on a busy queue
+	void parallelFor(unsigned int count, const std::function<void(unsigned int)>& job);
+
+	unsigned int getWorkerCount() const { return (unsigned int)m_workers.size(); }
+
+private:
+
+	void workerLoop();
+
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_jobs;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+};
\ No newline at end of file
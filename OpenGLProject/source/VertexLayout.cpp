@@ -0,0 +1,239 @@
+#include "VertexLayout.h"
+#include <glm\gtc\packing.hpp>
+#include <cstring>
+
+// size of one component (or of the whole packed value for GL_INT_2_10_10_10_REV)
+static unsigned int attributeSize(int components, GLenum type)
+{
+	switch (type)
+	{
+	case GL_FLOAT:
+		return 4 * components;
+	case GL_HALF_FLOAT:
+	case GL_SHORT:
+		return 2 * components;
+	case GL_UNSIGNED_BYTE:
+		return components;
+	case GL_INT_2_10_10_10_REV:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+// append an attribute after the previous one (kept 4 byte aligned)
+VertexLayout& VertexLayout::add(VertexSemantic semantic, int components, GLenum type, bool normalized)
+{
+	VertexAttribute attribute;
+	attribute.semantic = semantic;
+	attribute.components = components;
+	attribute.type = type;
+	attribute.normalized = normalized;
+	attribute.offset = m_stride;
+
+	m_attributes.push_back(attribute);
+
+	m_stride += (attributeSize(components, type) + 3) & ~3u;
+
+	return *this;
+}
+
+// shared layouts of the vertex formats
+const VertexLayout& VertexLayout::get(VertexFormat format)
+{
+	static const VertexLayout full = VertexLayout()
+		.add(VertexSemantic::Position, 4, GL_FLOAT)
+		.add(VertexSemantic::Normal, 4, GL_FLOAT)
+		.add(VertexSemantic::TexCoord, 2, GL_FLOAT)
+		.add(VertexSemantic::Tangent, 4, GL_FLOAT)
+		.add(VertexSemantic::Color, 4, GL_FLOAT);
+
+	// w of the position defaults to 1 in the shader, normals / tangents only need 10 bits per axis
+	// and the 2 bit w still holds the tangent handedness
+	static const VertexLayout compact = VertexLayout()
+		.add(VertexSemantic::Position, 3, GL_FLOAT)
+		.add(VertexSemantic::Normal, 4, GL_INT_2_10_10_10_REV, true)
+		.add(VertexSemantic::TexCoord, 2, GL_HALF_FLOAT)
+		.add(VertexSemantic::Tangent, 4, GL_INT_2_10_10_10_REV, true)
+		.add(VertexSemantic::Color, 4, GL_UNSIGNED_BYTE, true);
+
+	static const VertexLayout compactNoColor = VertexLayout()
+		.add(VertexSemantic::Position, 3, GL_FLOAT)
+		.add(VertexSemantic::Normal, 4, GL_INT_2_10_10_10_REV, true)
+		.add(VertexSemantic::TexCoord, 2, GL_HALF_FLOAT)
+		.add(VertexSemantic::Tangent, 4, GL_INT_2_10_10_10_REV, true);
+
+	switch (format)
+	{
+	case VertexFormat::Compact:
+		return compact;
+	case VertexFormat::CompactNoColor:
+		return compactNoColor;
+	default:
+		return full;
+	}
+}
+
+// point the attributes of the bound vertex array at a vertex buffer binding index
+void VertexLayout::apply(unsigned int bindingIndex) const
+{
+	for (const VertexAttribute& attribute : m_attributes)
+	{
+		unsigned int location = (unsigned int)attribute.semantic;
+
+		glEnableVertexAttribArray(location);
+		glVertexAttribFormat(location, attribute.components, attribute.type,
+			attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+		glVertexAttribBinding(location, bindingIndex);
+	}
+
+	// without a color array the shader reads the current attribute value instead
+	if (!has(VertexSemantic::Color))
+	{
+		glDisableVertexAttribArray((unsigned int)VertexSemantic::Color);
+		glVertexAttrib4f((unsigned int)VertexSemantic::Color, 1.0f, 1.0f, 1.0f, 1.0f);
+	}
+}
+
+// convert vertices to this layout
+void VertexLayout::pack(const Vertex* vertices, size_t count, std::vector<unsigned char>& packed) const
+{
+	packed.assign(count * m_stride, 0);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vertex& vertex = vertices[i];
+		unsigned char* destination = &packed[i * m_stride];
+
+		for (const VertexAttribute& attribute : m_attributes)
+		{
+			glm::vec4 value;
+			switch (attribute.semantic)
+			{
+			case VertexSemantic::Position:
+				value = vertex.position;
+				break;
+			case VertexSemantic::Normal:
+				value = vertex.normal;
+				break;
+			case VertexSemantic::TexCoord:
+				value = glm::vec4(vertex.texcoord, 0, 1);
+				break;
+			case VertexSemantic::Tangent:
+				value = vertex.tangent;
+				break;
+			case VertexSemantic::Color:
+				value = vertex.color;
+				break;
+			}
+
+			unsigned char* out = destination + attribute.offset;
+
+			switch (attribute.type)
+			{
+			case GL_FLOAT:
+				std::memcpy(out, &value[0], sizeof(float) * attribute.components);
+				break;
+			case GL_HALF_FLOAT:
+				for (int c = 0; c < attribute.components; c++)
+				{
+					glm::uint16 half = glm::packHalf1x16(value[c]);
+					std::memcpy(out + c * 2, &half, 2);
+				}
+				break;
+			case GL_SHORT:
+				for (int c = 0; c < attribute.components; c++)
+				{
+					glm::uint16 snorm = glm::packSnorm1x16(value[c]);
+					std::memcpy(out + c * 2, &snorm, 2);
+				}
+				break;
+			case GL_UNSIGNED_BYTE:
+				for (int c = 0; c < attribute.components; c++)
+				{
+					out[c] = glm::packUnorm1x8(value[c]);
+				}
+				break;
+			case GL_INT_2_10_10_10_REV:
+			{
+				glm::uint32 bits = glm::packSnorm3x10_1x2(value);
+				std::memcpy(out, &bits, 4);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+}
+
+// read an attribute back out of a packed vertex, (0, 0, 0, 1) if the layout doesn't have it
+glm::vec4 VertexLayout::read(const unsigned char* vertex, VertexSemantic semantic) const
+{
+	glm::vec4 value(0.0f, 0.0f, 0.0f, 1.0f);
+
+	for (const VertexAttribute& attribute : m_attributes)
+	{
+		if (attribute.semantic != semantic)
+		{
+			continue;
+		}
+
+		const unsigned char* in = vertex + attribute.offset;
+
+		switch (attribute.type)
+		{
+		case GL_FLOAT:
+			std::memcpy(&value[0], in, sizeof(float) * attribute.components);
+			break;
+		case GL_HALF_FLOAT:
+			for (int c = 0; c < attribute.components; c++)
+			{
+				glm::uint16 half;
+				std::memcpy(&half, in + c * 2, 2);
+				value[c] = glm::unpackHalf1x16(half);
+			}
+			break;
+		case GL_SHORT:
+			for (int c = 0; c < attribute.components; c++)
+			{
+				glm::uint16 snorm;
+				std::memcpy(&snorm, in + c * 2, 2);
+				value[c] = glm::unpackSnorm1x16(snorm);
+			}
+			break;
+		case GL_UNSIGNED_BYTE:
+			for (int c = 0; c < attribute.components; c++)
+			{
+				value[c] = glm::unpackUnorm1x8(in[c]);
+			}
+			break;
+		case GL_INT_2_10_10_10_REV:
+		{
+			glm::uint32 bits;
+			std::memcpy(&bits, in, 4);
+			value = glm::unpackSnorm3x10_1x2(bits);
+			break;
+		}
+		default:
+			break;
+		}
+
+		break;
+	}
+
+	return value;
+}
+
+bool VertexLayout::has(VertexSemantic semantic) const
+{
+	for (const VertexAttribute& attribute : m_attributes)
+	{
+		if (attribute.semantic == semantic)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <glad\glad.h>
+#include <vector>
+#include "Vertex.h"
+
+// vertex formats a mesh can be stored in
+enum class VertexFormat
+{
+	Full,			// the 72 byte Vertex as is
+	Compact,		// 28 bytes: vec3 position, 10:10:10:2 normal / tangent, half float uv, rgba8 color
+	CompactNoColor	// 24 bytes: as compact but every vertex is white
+};
+
+// which Vertex member an attribute holds, doubles as the shader location
+enum class VertexSemantic : unsigned int
+{
+	Position = 0,
+	Normal = 1,
+	TexCoord = 2,
+	Tangent = 3,
+	Color = 4
+};
+
+struct VertexAttribute
+{
+	VertexSemantic semantic;
+	int components;
+	GLenum type; // GL_FLOAT, GL_HALF_FLOAT, GL_SHORT, GL_UNSIGNED_BYTE or GL_INT_2_10_10_10_REV
+	bool normalized;
+	unsigned int offset;
+};
+
+// describes how vertices are stored in a buffer
+// drives both the packing of Vertex data and the vertex array setup so the two can't disagree
+class VertexLayout
+{
+public:
+
+	// append an attribute after the previous one (kept 4 byte aligned)
+	VertexLayout& add(VertexSemantic semantic, int components, GLenum type, bool normalized = false);
+
+	// shared layouts of the vertex formats
+	static const VertexLayout& get(VertexFormat format);
+
+	// point the attributes of the bound vertex array at a vertex buffer binding index
+	void apply(unsigned int bindingIndex) const;
+
+	// convert vertices to this layout
+	void pack(const Vertex* vertices, size_t count, std::vector<unsigned char>& packed) const;
+
+	// read an attribute back out of a packed vertex, (0, 0, 0, 1) if the layout doesn't have it
+	glm::vec4 read(const unsigned char* vertex, VertexSemantic semantic) const;
+
+	bool has(VertexSemantic semantic) const;
+
+	unsigned int getStride() const { return m_stride; }
+	const std::vector<VertexAttribute>& getAttributes() const { return m_attributes; }
+
+private:
+
+	std::vector<VertexAttribute> m_attributes;
+	unsigned int m_stride = 0;
+};
@@ -0,0 +1,246 @@
+// command line tool that block compresses images into .dds files next to them, with the full mip chain
+// the app then loads the .dds instead of the image, as long as it sits beside it with the same name
+//
+// usage: TextureConverter <image> [<image> ...] [-normal] [-hq]
+// normal maps (-normal, or "normal" in the file name) become BC5, images with any transparency BC3, the rest BC1
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "DDS.h"
+#include "ThreadPool.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb\stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb\stb_image_resize.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb\stb_dxt.h>
+
+// rgba8 pixels of one mip level
+struct Level
+{
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+static bool isNormalMap(const std::string& filename)
+{
+	std::string lower = filename;
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+	return lower.find("normal") != std::string::npos;
+}
+
+static bool hasTransparency(const Level& level)
+{
+	for (size_t i = 3; i < level.pixels.size(); i += 4)
+	{
+		if (level.pixels[i] < 255)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// averaging shortens normals, stretch them back out so lower mips don't look flatter
+static void renormalize(Level& level)
+{
+	for (size_t i = 0; i < level.pixels.size(); i += 4)
+	{
+		float x = level.pixels[i] / 127.5f - 1.0f;
+		float y = level.pixels[i + 1] / 127.5f - 1.0f;
+		float z = level.pixels[i + 2] / 127.5f - 1.0f;
+		float length = std::sqrt(x * x + y * y + z * z);
+		if (length > 0.0f)
+		{
+			level.pixels[i] = (unsigned char)std::lround((x / length + 1.0f) * 127.5f);
+			level.pixels[i + 1] = (unsigned char)std::lround((y / length + 1.0f) * 127.5f);
+			level.pixels[i + 2] = (unsigned char)std::lround((z / length + 1.0f) * 127.5f);
+		}
+	}
+}
+
+// halve the size until 1x1
+static std::vector<Level> buildMipChain(Level top, bool normalMap)
+{
+	std::vector<Level> levels;
+	levels.push_back(std::move(top));
+
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		const Level& previous = levels.back();
+
+		Level next;
+		next.width = std::max(1u, previous.width / 2);
+		next.height = std::max(1u, previous.height / 2);
+		next.pixels.resize((size_t)next.width * next.height * 4);
+
+		stbir_resize_uint8(previous.pixels.data(), previous.width, previous.height, 0,
+			next.pixels.data(), next.width, next.height, 0, 4);
+
+		if (normalMap)
+		{
+			renormalize(next);
+		}
+
+		levels.push_back(std::move(next));
+	}
+
+	return levels;
+}
+
+// compress one level, a row of blocks per job
+static void compressLevel(const Level& level, BlockFormat format, int mode, unsigned char* output, ThreadPool& pool)
+{
+	unsigned int blocksWide = std::max(1u, (level.width + 3) / 4);
+	unsigned int blocksHigh = std::max(1u, (level.height + 3) / 4);
+	unsigned int blockSize = DDS::getBlockSize(format);
+
+	pool.parallelFor(blocksHigh, [&](unsigned int blockY)
+	{
+		unsigned char rgba[16 * 4];
+		unsigned char rg[16 * 2];
+
+		for (unsigned int blockX = 0; blockX < blocksWide; blockX++)
+		{
+			// gather the block, repeating the edge for levels smaller than 4 texels
+			for (unsigned int y = 0; y < 4; y++)
+			{
+				unsigned int py = std::min(blockY * 4 + y, level.height - 1);
+				for (unsigned int x = 0; x < 4; x++)
+				{
+					unsigned int px = std::min(blockX * 4 + x, level.width - 1);
+					const unsigned char* pixel = &level.pixels[((size_t)py * level.width + px) * 4];
+
+					memcpy(&rgba[(y * 4 + x) * 4], pixel, 4);
+					rg[(y * 4 + x) * 2] = pixel[0];
+					rg[(y * 4 + x) * 2 + 1] = pixel[1];
+				}
+			}
+
+			unsigned char* block = output + ((size_t)blockY * blocksWide + blockX) * blockSize;
+			switch (format)
+			{
+			case BlockFormat::BC1:
+				stb_compress_dxt_block(block, rgba, 0, mode);
+				break;
+			case BlockFormat::BC3:
+				stb_compress_dxt_block(block, rgba, 1, mode);
+				break;
+			case BlockFormat::BC5:
+				stb_compress_bc5_block(block, rg);
+				break;
+			default:
+				break;
+			}
+		}
+	});
+}
+
+static bool convert(const std::string& source, bool forceNormalMap, int mode, ThreadPool& pool)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	int x = 0, y = 0, comp = 0;
+	unsigned char* pixels = stbi_load(source.c_str(), &x, &y, &comp, STBI_rgb_alpha);
+	if (pixels == nullptr)
+	{
+		printf("Can't read %s\n", source.c_str());
+		return false;
+	}
+
+	Level top;
+	top.width = (unsigned int)x;
+	top.height = (unsigned int)y;
+	top.pixels.assign(pixels, pixels + (size_t)x * y * 4);
+	stbi_image_free(pixels);
+
+	bool normalMap = forceNormalMap || isNormalMap(source);
+
+	CompressedImage image;
+	image.width = top.width;
+	image.height = top.height;
+	image.format = normalMap ? BlockFormat::BC5 : (hasTransparency(top) ? BlockFormat::BC3 : BlockFormat::BC1);
+
+	std::vector<Level> levels = buildMipChain(std::move(top), normalMap);
+
+	size_t size = 0;
+	for (unsigned int level = 0; level < levels.size(); level++)
+	{
+		image.levelOffsets.push_back(size);
+		size += image.getLevelSize(level);
+	}
+	image.data.resize(size);
+
+	for (unsigned int level = 0; level < levels.size(); level++)
+	{
+		compressLevel(levels[level], image.format, mode, image.data.data() + image.levelOffsets[level], pool);
+	}
+
+	std::string destination = DDS::getPath(source);
+	if (!DDS::write(destination, image))
+	{
+		printf("Failed to write %s\n", destination.c_str());
+		return false;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	// what the app would have uploaded before, the decoded channels plus generated mips
+	size_t uncompressed = (size_t)x * y * comp;
+	uncompressed += uncompressed / 3;
+
+	const char* formatNames[] = { "none", "BC1", "BC2", "BC3", "BC4", "BC5", "BC7" };
+	printf("%s -> %s: %dx%d %s, %zu levels, %.2f MB -> %.2f MB (%.1fx smaller) in %.1f ms\n",
+		source.c_str(), destination.c_str(), x, y, formatNames[(int)image.format], levels.size(),
+		uncompressed / (1024.0 * 1024.0), size / (1024.0 * 1024.0), (double)uncompressed / size,
+		std::chrono::duration<double, std::milli>(end - start).count());
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> sources;
+	bool forceNormalMap = false;
+	int mode = STB_DXT_NORMAL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-normal") == 0)
+		{
+			forceNormalMap = true;
+		}
+		else if (strcmp(argv[i], "-hq") == 0)
+		{
+			mode = STB_DXT_HIGHQUAL;
+		}
+		else
+		{
+			sources.push_back(argv[i]);
+		}
+	}
+
+	if (sources.empty())
+	{
+		printf("usage: TextureConverter <image> [<image> ...] [-normal] [-hq]\n");
+		return 1;
+	}
+
+	int failed = 0;
+	for (const std::string& source : sources)
+	{
+		if (!convert(source, forceNormalMap, mode, ThreadPool::getDefault()))
+		{
+			failed++;
+		}
+	}
+
+	return failed == 0 ? 0 : 1;
+}
\ No newline at end of file